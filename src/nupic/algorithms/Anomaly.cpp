@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "nupic/algorithms/Anomaly.hpp"
+#include "nupic/algorithms/AnomalyLikelihood.hpp"
 #include "nupic/utils/Log.hpp"
 #include "nupic/utils/MovingAverage.hpp"
 
@@ -38,22 +39,86 @@ namespace algorithms {
 
 namespace anomaly {
 
-Real32 computeRawAnomalyScore(const vector<UInt> &active,
-                              const vector<UInt> &predicted) {
+static bool isStrictlyIncreasing_(const UInt *begin, const UInt *end) {
+  for (const UInt *it = begin; it + 1 < end; ++it) {
+    if (it[0] >= it[1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static Real32 computeRawAnomalyScore_(const UInt *active, size_t nActive,
+                                      const UInt *predicted,
+                                      size_t nPredicted) {
   // Return 0 if no active columns are present
-  if (active.size() == 0) {
+  if (nActive == 0) {
     return 0.0f;
   }
 
-  set<UInt> active_{active.begin(), active.end()};
-  set<UInt> predicted_{predicted.begin(), predicted.end()};
-  vector<UInt> predictedActiveCols;
+  size_t predictedActive = 0;
+  if (isStrictlyIncreasing_(active, active + nActive) &&
+      isStrictlyIncreasing_(predicted, predicted + nPredicted)) {
+    // Count the columns in both inputs with a merge.
+    size_t i = 0, j = 0;
+    while (i < nActive && j < nPredicted) {
+      if (active[i] < predicted[j]) {
+        i++;
+      } else if (predicted[j] < active[i]) {
+        j++;
+      } else {
+        predictedActive++;
+        i++;
+        j++;
+      }
+    }
+  } else {
+    set<UInt> active_{active, active + nActive};
+    set<UInt> predicted_{predicted, predicted + nPredicted};
+    vector<UInt> predictedActiveCols;
+    set_intersection(active_.begin(), active_.end(), predicted_.begin(),
+                     predicted_.end(), back_inserter(predictedActiveCols));
+    predictedActive = predictedActiveCols.size();
+  }
 
   // Calculate and return percent of active columns that were not predicted.
-  set_intersection(active_.begin(), active_.end(), predicted_.begin(),
-                   predicted_.end(), back_inserter(predictedActiveCols));
+  return (nActive - predictedActive) / Real32(nActive);
+}
+
+Real32 computeRawAnomalyScore(const vector<UInt> &active,
+                              const vector<UInt> &predicted) {
+  return computeRawAnomalyScore_(active.data(), active.size(),
+                                 predicted.data(), predicted.size());
+}
 
-  return (active.size() - predictedActiveCols.size()) / Real32(active.size());
+void computeRawAnomalyScores(const vector<UInt> &active,
+                             const vector<UInt> &activeOffsets,
+                             const vector<UInt> &predicted,
+                             const vector<UInt> &predictedOffsets,
+                             vector<Real32> &scores) {
+  NTA_CHECK(activeOffsets.size() > 0 &&
+            activeOffsets.size() == predictedOffsets.size())
+      << "activeOffsets and predictedOffsets must have one element more "
+      << "than there are pairs";
+  NTA_CHECK(activeOffsets.back() <= active.size() &&
+            predictedOffsets.back() <= predicted.size())
+      << "The offsets must be within the columns";
+
+  const size_t nPairs = activeOffsets.size() - 1;
+  for (size_t i = 0; i < nPairs; i++) {
+    NTA_CHECK(activeOffsets[i] <= activeOffsets[i + 1] &&
+              predictedOffsets[i] <= predictedOffsets[i + 1])
+        << "The offsets must be non-decreasing, pair " << i << " is not";
+  }
+
+  scores.resize(nPairs);
+  for (size_t i = 0; i < nPairs; i++) {
+    scores[i] = computeRawAnomalyScore_(
+        active.data() + activeOffsets[i],
+        activeOffsets[i + 1] - activeOffsets[i],
+        predicted.data() + predictedOffsets[i],
+        predictedOffsets[i + 1] - predictedOffsets[i]);
+  }
 }
 
 Anomaly::Anomaly(UInt slidingWindowSize, AnomalyMode mode,
@@ -65,12 +130,13 @@ Anomaly::Anomaly(UInt slidingWindowSize, AnomalyMode mode,
   if (slidingWindowSize > 0) {
     movingAverage_.reset(new nupic::util::MovingAverage(slidingWindowSize));
   }
-
-  // Not implemented. Fail.
-  NTA_ASSERT(mode_ == AnomalyMode::PURE)
-      << "C++ Anomaly implemented only for PURE mode!";
+  if (mode_ == AnomalyMode::LIKELIHOOD || mode_ == AnomalyMode::WEIGHTED) {
+    likelihood_.reset(new AnomalyLikelihood());
+  }
 }
 
+Anomaly::~Anomaly() {}
+
 Real32 Anomaly::compute(const vector<UInt> &active,
                         const vector<UInt> &predicted, Real64 inputValue,
                         UInt timestamp) {
@@ -81,10 +147,13 @@ Real32 Anomaly::compute(const vector<UInt> &active,
     score = anomalyScore;
     break;
   case AnomalyMode::LIKELIHOOD:
+    // low likelihood -> high anomaly
+    score = 1 - (Real32)likelihood_->anomalyProbability(inputValue,
+                                                        anomalyScore);
+    break;
   case AnomalyMode::WEIGHTED:
-    // Not implemented. Fail
-    NTA_ASSERT(mode_ == AnomalyMode::PURE)
-        << "C++ Anomaly implemented only for PURE mode!";
+    score = anomalyScore * (1 - (Real32)likelihood_->anomalyProbability(
+                                    inputValue, anomalyScore));
     break;
   }
 
@@ -23,6 +23,7 @@
 #ifndef NUPIC_ALGORITHMS_ANOMALY_HPP
 #define NUPIC_ALGORITHMS_ANOMALY_HPP
 
+#include <limits>
 #include <memory> // Needed for smart pointer templates
 #include <nupic/types/Types.hpp>
 #include <nupic/utils/MovingAverage.hpp> // Needed for for smart pointer templates
@@ -38,10 +39,15 @@ namespace algorithms {
 
 namespace anomaly {
 
+class AnomalyLikelihood; // Forward declaration
+
 /**
  * Computes the raw anomaly score.
  *
  * The raw anomaly score is the fraction of active columns not predicted.
+ * Inputs sorted in strictly increasing order, as produced by the spatial
+ * pooler and temporal memory, are merged without allocating; other inputs
+ * are sorted first.
  *
  * @param activeColumns: array of active column indices
  * @param prevPredictedColumns: array of columns indices predicted in
@@ -51,6 +57,24 @@ namespace anomaly {
 Real32 computeRawAnomalyScore(const std::vector<UInt> &active,
                               const std::vector<UInt> &predicted);
 
+/**
+ * Computes the raw anomaly scores of many (active, predicted) pairs, e.g.
+ * one per metric of a server that models many streams.
+ *
+ * The pairs are laid out contiguously: the active columns of pair i are
+ * active[activeOffsets[i]] to active[activeOffsets[i + 1] - 1], and
+ * likewise for the predicted columns, so both offset vectors hold one
+ * more element than there are pairs.
+ *
+ * @param scores receives the raw anomaly score of each pair, as computed
+ *     by computeRawAnomalyScore
+ */
+void computeRawAnomalyScores(const std::vector<UInt> &active,
+                             const std::vector<UInt> &activeOffsets,
+                             const std::vector<UInt> &predicted,
+                             const std::vector<UInt> &predictedOffsets,
+                             std::vector<Real32> &scores);
+
 enum class AnomalyMode { PURE, LIKELIHOOD, WEIGHTED };
 
 class Anomaly {
@@ -61,10 +85,9 @@ public:
    * Supported modes:
    *    PURE - the raw anomaly score as computed by computeRawAnomalyScore
    *    LIKELIHOOD - uses the AnomalyLikelihood class on top of the raw
-   *        anomaly scores (not implemented in C++)
+   *        anomaly scores
    *    WEIGHTED - multiplies the likelihood result with the raw anomaly
-   *        score that was used to generate the likelihood (not
-   *        implemented in C++)
+   *        score that was used to generate the likelihood
    *
    *    @param slidingWindowSize (optional) - how many elements are
    *        summed up; enables moving average on final anomaly score;
@@ -86,6 +109,8 @@ public:
   Anomaly(UInt slidingWindowSize = 0, AnomalyMode mode = AnomalyMode::PURE,
           Real32 binaryAnomalyThreshold = 0);
 
+  ~Anomaly();
+
   /**
    * Compute the anomaly score as the percent of active columns not
    * predicted.
@@ -95,19 +120,22 @@ public:
    *        (used for anomaly in step T+1)
    * @param inputValue: (optional) value of current input to encoders
    *                    (eg "cat" for category encoder)
-   *                    (used in anomaly-likelihood)
+   *                    (used in anomaly-likelihood, NaN when there is
+   *                    none)
    * @param timestamp: (optional) date timestamp when the sample occured
    *                   (used in anomaly-likelihood)
    * @return the computed anomaly score; Real32 0..1
    */
   Real32 compute(const std::vector<UInt> &active,
-                 const std::vector<UInt> &predicted, Real64 inputValue = 0,
+                 const std::vector<UInt> &predicted,
+                 Real64 inputValue = std::numeric_limits<Real64>::quiet_NaN(),
                  UInt timestamp = 0);
 
 private:
   AnomalyMode mode_;
   Real32 binaryThreshold_;
   std::unique_ptr<nupic::util::MovingAverage> movingAverage_;
+  std::unique_ptr<AnomalyLikelihood> likelihood_;
 };
 } // namespace anomaly
 } // namespace algorithms
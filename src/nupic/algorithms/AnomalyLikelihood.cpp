@@ -0,0 +1,224 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "nupic/algorithms/AnomalyLikelihood.hpp"
+#include "nupic/utils/Log.hpp"
+
+using namespace std;
+
+namespace nupic {
+
+namespace algorithms {
+
+namespace anomaly {
+
+// The lower bounds that NuPIC puts on the estimated distribution, so that
+// a very stable stream doesn't make every small change look anomalous.
+static const Real64 MIN_MEAN = 0.03;
+static const Real64 MIN_VARIANCE = 0.0003;
+
+// A metric whose values vary less than this over the historic window is
+// flat, and gets the null distribution, which is wide enough that no
+// score is unlikely under it.
+static const Real64 FLAT_METRIC_VARIANCE = 1.5e-5;
+static const Real64 NULL_MEAN = 0.5;
+static const Real64 NULL_VARIANCE = 1e6;
+
+// Tail probabilities of the red and yellow likelihood thresholds of the
+// filter, computed the same way as in the Python version.
+static const Real64 RED_TAIL = 1.0 - 0.99999;
+static const Real64 YELLOW_TAIL = 1.0 - 0.999;
+
+// The running sums lose precision as values come and go, so they are
+// summed again from the window this often.
+static const UInt RESUM_PERIOD = 1 << 16;
+
+AnomalyLikelihood::AnomalyLikelihood(UInt learningPeriod,
+                                     UInt estimationSamples,
+                                     UInt historicWindowSize,
+                                     UInt reestimationPeriod,
+                                     UInt averagingWindow)
+    : learningPeriod_(learningPeriod), estimationSamples_(estimationSamples),
+      reestimationPeriod_(reestimationPeriod), iteration_(0),
+      averager_(averagingWindow), historic_(historicWindowSize, 0.0),
+      historicBegin_(0), historicSize_(0), historicSum_(0.0),
+      historicSumSquares_(0.0),
+      metric_(historicWindowSize, numeric_limits<Real64>::quiet_NaN()),
+      metricCount_(0), metricMean_(0.0), metricM2_(0.0), mean_(0.0),
+      variance_(0.0), stdev_(0.0), previousAverage_(0.0), previousTail_(1.0) {
+  NTA_CHECK(historicWindowSize > 0)
+      << "historicWindowSize must be positive";
+  NTA_CHECK(historicWindowSize >= estimationSamples)
+      << "estimationSamples must be <= historicWindowSize";
+  NTA_CHECK(reestimationPeriod > 0) << "reestimationPeriod must be positive";
+  NTA_CHECK(averagingWindow > 0) << "averagingWindow must be positive";
+}
+
+Real64 AnomalyLikelihood::anomalyProbability(Real64 anomalyScore) {
+  return compute_(anomalyScore, nullptr);
+}
+
+Real64 AnomalyLikelihood::anomalyProbability(Real64 value,
+                                             Real64 anomalyScore) {
+  return compute_(anomalyScore, &value);
+}
+
+Real64 AnomalyLikelihood::compute_(Real64 anomalyScore, const Real64 *value) {
+  const Real64 averagedScore = averager_.compute((Real32)anomalyScore);
+  const UInt iteration = iteration_++;
+
+  if (iteration >= learningPeriod_) {
+    addHistoric_(averagedScore,
+                 value ? *value : numeric_limits<Real64>::quiet_NaN());
+  }
+
+  const Real64 previousAverage = previousAverage_;
+  previousAverage_ = averagedScore;
+
+  // Return 0.5 while the model is in its probationary period.
+  if (iteration < learningPeriod_ + estimationSamples_) {
+    return 0.5;
+  }
+
+  if (iteration == learningPeriod_ + estimationSamples_ ||
+      iteration % reestimationPeriod_ == 0) {
+    estimateNormal_();
+    previousTail_ = tailProbability(previousAverage, mean_, stdev_);
+  }
+
+  // Only keep sharp increases of the likelihood: a red likelihood that
+  // follows another one is lowered to yellow.
+  const Real64 tail = tailProbability(averagedScore, mean_, stdev_);
+  const Real64 filteredTail =
+      (tail <= RED_TAIL && previousTail_ <= RED_TAIL) ? YELLOW_TAIL : tail;
+  previousTail_ = tail;
+  return 1.0 - filteredTail;
+}
+
+Real64 AnomalyLikelihood::tailProbability(Real64 x, Real64 mean,
+                                          Real64 stdev) {
+  // The distribution is symmetric, so reflect x above the mean.
+  if (x < mean) {
+    x = 2 * mean - x;
+  }
+  NTA_ASSERT(stdev > 0);
+  const Real64 z = (x - mean) / stdev;
+  return 0.5 * erfc(z / sqrt(2.0));
+}
+
+Real64 AnomalyLikelihood::getMean() const { return mean_; }
+
+Real64 AnomalyLikelihood::getVariance() const { return variance_; }
+
+UInt AnomalyLikelihood::getIteration() const { return iteration_; }
+
+void AnomalyLikelihood::addHistoric_(Real64 averagedScore, Real64 value) {
+  const UInt capacity = (UInt)historic_.size();
+  if (historicSize_ < capacity) {
+    const UInt end = (historicBegin_ + historicSize_) % capacity;
+    historic_[end] = averagedScore;
+    metric_[end] = value;
+    historicSize_++;
+  } else {
+    const Real64 oldest = historic_[historicBegin_];
+    historicSum_ -= oldest;
+    historicSumSquares_ -= oldest * oldest;
+    if (!std::isnan(metric_[historicBegin_])) {
+      removeMetric_(metric_[historicBegin_]);
+    }
+    historic_[historicBegin_] = averagedScore;
+    metric_[historicBegin_] = value;
+    historicBegin_ = (historicBegin_ + 1) % capacity;
+  }
+  historicSum_ += averagedScore;
+  historicSumSquares_ += averagedScore * averagedScore;
+  if (!std::isnan(value)) {
+    addMetric_(value);
+  }
+
+  if (iteration_ % RESUM_PERIOD == 0) {
+    historicSum_ = 0.0;
+    historicSumSquares_ = 0.0;
+    metricMean_ = 0.0;
+    for (UInt i = 0; i < historicSize_; i++) {
+      const UInt j = (historicBegin_ + i) % capacity;
+      historicSum_ += historic_[j];
+      historicSumSquares_ += historic_[j] * historic_[j];
+      if (!std::isnan(metric_[j])) {
+        metricMean_ += metric_[j];
+      }
+    }
+    metricMean_ = metricCount_ > 0 ? metricMean_ / metricCount_ : 0.0;
+    metricM2_ = 0.0;
+    for (UInt i = 0; i < historicSize_; i++) {
+      const Real64 v = metric_[(historicBegin_ + i) % capacity];
+      if (!std::isnan(v)) {
+        metricM2_ += (v - metricMean_) * (v - metricMean_);
+      }
+    }
+  }
+}
+
+void AnomalyLikelihood::addMetric_(Real64 value) {
+  metricCount_++;
+  const Real64 delta = value - metricMean_;
+  metricMean_ += delta / metricCount_;
+  metricM2_ += delta * (value - metricMean_);
+}
+
+void AnomalyLikelihood::removeMetric_(Real64 value) {
+  metricCount_--;
+  if (metricCount_ == 0) {
+    metricMean_ = 0.0;
+    metricM2_ = 0.0;
+    return;
+  }
+  const Real64 delta = value - metricMean_;
+  metricMean_ -= delta / metricCount_;
+  metricM2_ -= delta * (value - metricMean_);
+}
+
+void AnomalyLikelihood::estimateNormal_() {
+  NTA_ASSERT(historicSize_ > 0);
+  mean_ = historicSum_ / historicSize_;
+  variance_ = max(0.0, historicSumSquares_ / historicSize_ - mean_ * mean_);
+
+  mean_ = max(mean_, MIN_MEAN);
+  variance_ = max(variance_, MIN_VARIANCE);
+
+  // Only when every record of the window has a metric value.
+  if (metricCount_ == historicSize_ &&
+      metricM2_ / metricCount_ < FLAT_METRIC_VARIANCE) {
+    mean_ = NULL_MEAN;
+    variance_ = NULL_VARIANCE;
+  }
+  stdev_ = sqrt(variance_);
+}
+
+} // namespace anomaly
+
+} // namespace algorithms
+
+} // namespace nupic
@@ -0,0 +1,175 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef NUPIC_ALGORITHMS_ANOMALY_LIKELIHOOD_HPP
+#define NUPIC_ALGORITHMS_ANOMALY_LIKELIHOOD_HPP
+
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/MovingAverage.hpp>
+
+namespace nupic {
+
+namespace algorithms {
+
+namespace anomaly {
+
+/**
+ * Streaming anomaly likelihood.
+ *
+ * Models the distribution of the recent raw anomaly scores as a normal
+ * distribution and reports how unlikely the current score is under that
+ * model. This is the same computation as AnomalyLikelihood in NuPIC's
+ * anomaly_likelihood.py, done incrementally: the raw scores are averaged
+ * over a short window, the averages of the last historicWindowSize
+ * records are kept in a ring buffer together with their sum and sum of
+ * squares, and the mean and variance are read from those sums. Each
+ * record therefore costs O(1), and the memory of an instance is bounded
+ * by 2 * historicWindowSize + averagingWindow values.
+ *
+ * As in the Python version, only the first of consecutive likelihoods
+ * above 0.99999 is reported as is, and the following ones are lowered to
+ * 0.999. When the metric values are given and hardly vary over the
+ * historic window, the distribution is replaced by a very wide one, so
+ * that a flat metric is not reported as anomalous. One difference
+ * remains: after an estimate, the filter compares the next likelihood
+ * with the unfiltered likelihood of the previous record, where the Python
+ * version uses the filtered one.
+ */
+class AnomalyLikelihood {
+public:
+  /**
+   * @param learningPeriod Number of records at the start of the stream
+   *        whose scores are not used to estimate the distribution, since
+   *        the model is still learning.
+   * @param estimationSamples Number of records used for the first
+   *        estimate of the distribution, after learningPeriod.
+   *        anomalyProbability returns 0.5 until then.
+   * @param historicWindowSize Number of recent averaged scores used to
+   *        estimate the distribution.
+   * @param reestimationPeriod How often, in records, the distribution is
+   *        estimated again.
+   * @param averagingWindow Number of raw scores averaged before they are
+   *        compared to the distribution.
+   */
+  AnomalyLikelihood(UInt learningPeriod = 288, UInt estimationSamples = 100,
+                    UInt historicWindowSize = 8640,
+                    UInt reestimationPeriod = 100, UInt averagingWindow = 10);
+
+  /**
+   * Adds a raw anomaly score to the model and returns the probability
+   * that it is anomalous, 1 - the tail probability of its moving average
+   * under the estimated distribution.
+   *
+   * @param anomalyScore The raw anomaly score, 0..1.
+   * @return the anomaly likelihood, 0..1. 0.5 while the model is still in
+   *         its probationary period.
+   */
+  Real64 anomalyProbability(Real64 anomalyScore);
+
+  /**
+   * Same as above, also checking whether the metric is flat. The
+   * arguments are in the order of the Python version.
+   *
+   * @param value The value of the metric for this record, NaN if there is
+   *        none.
+   * @param anomalyScore The raw anomaly score, 0..1.
+   */
+  Real64 anomalyProbability(Real64 value, Real64 anomalyScore);
+
+  /**
+   * The probability that a value drawn from a normal distribution with the
+   * given mean and stdev is further from the mean than x, on the same side
+   * of the mean as x. stdev must be positive.
+   */
+  static Real64 tailProbability(Real64 x, Real64 mean, Real64 stdev);
+
+  /**
+   * The estimated distribution of the averaged scores.
+   */
+  Real64 getMean() const;
+  Real64 getVariance() const;
+
+  /**
+   * Number of records seen so far.
+   */
+  UInt getIteration() const;
+
+private:
+  // Both forms of anomalyProbability. value is null when there is no
+  // metric value.
+  Real64 compute_(Real64 anomalyScore, const Real64 *value);
+
+  // Adds an averaged score, and the metric value or NaN, to the historic
+  // window.
+  void addHistoric_(Real64 averagedScore, Real64 value);
+
+  // Adds a value to, or removes one from, the running mean and sum of
+  // squared deviations of the metric values.
+  void addMetric_(Real64 value);
+  void removeMetric_(Real64 value);
+
+  // Estimates the distribution from the historic window, or uses the null
+  // distribution for a flat metric.
+  void estimateNormal_();
+
+  UInt learningPeriod_;
+  UInt estimationSamples_;
+  UInt reestimationPeriod_;
+  UInt iteration_;
+
+  // Averages the raw scores.
+  util::MovingAverage averager_;
+
+  // The averaged scores after learningPeriod_, as a ring buffer of
+  // historicWindowSize entries whose oldest entry is at historicBegin_.
+  std::vector<Real64> historic_;
+  UInt historicBegin_;
+  UInt historicSize_;
+  Real64 historicSum_;
+  Real64 historicSumSquares_;
+
+  // The metric values of the historic window, NaN for a record without
+  // one, with the number of values and their running statistics.
+  std::vector<Real64> metric_;
+  UInt metricCount_;
+  Real64 metricMean_;
+  Real64 metricM2_;
+
+  Real64 mean_;
+  Real64 variance_;
+  Real64 stdev_;
+
+  // The averaged score and unfiltered tail probability of the previous
+  // record, for the filter.
+  Real64 previousAverage_;
+  Real64 previousTail_;
+};
+
+} // namespace anomaly
+
+} // namespace algorithms
+
+} // namespace nupic
+
+#endif // NUPIC_ALGORITHMS_ANOMALY_LIKELIHOOD_HPP
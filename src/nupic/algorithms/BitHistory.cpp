@@ -20,6 +20,7 @@
  * ---------------------------------------------------------------------
  */
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <math.h>
@@ -28,6 +29,7 @@
 #include <vector>
 
 #include <nupic/algorithms/BitHistory.hpp>
+#include <nupic/math/VectorKernels.hpp>
 #include <nupic/proto/BitHistory.capnp.h>
 #include <nupic/types/Types.hpp>
 #include <nupic/utils/Log.hpp>
@@ -203,6 +205,127 @@ bool BitHistory::operator!=(const BitHistory &other) const {
   return !operator==(other);
 }
 
+BitHistoryTable::BitHistoryTable(int nSteps, Real64 alpha, UInt verbosity)
+    : nSteps_(nSteps), alpha_(alpha), verbosity_(verbosity) {}
+
+void BitHistoryTable::grow_(UInt nbits, UInt nbuckets) {
+  if (nbits <= stats_.nRows() && nbuckets <= stats_.nCols()) {
+    return;
+  }
+
+  stats_.resize(max(nbits, stats_.nRows()), max(nbuckets, stats_.nCols()));
+  lastTotalUpdate_.resize(stats_.nRows(), -1);
+  totals_.resize(stats_.nRows(), 0.0);
+}
+
+void BitHistoryTable::store(int iteration, UInt bit, int bucketIdx) {
+  NTA_CHECK(bucketIdx >= 0) << "Invalid bucket index " << bucketIdx;
+  grow_(bit + 1, bucketIdx + 1);
+
+  if (lastTotalUpdate_[bit] == -1) {
+    lastTotalUpdate_[bit] = iteration;
+  }
+
+  Real64 *row = stats_.row(bit);
+
+  // Same arithmetic as BitHistory::store.
+  const Real64 denom = pow(1.0 - alpha_, iteration - lastTotalUpdate_[bit]);
+  Real64 dcNew = -1.0;
+  if (denom > 0.0) {
+    dcNew = row[bucketIdx] + (alpha_ / denom);
+  }
+
+  if (denom < 0.00001 || dcNew > DUTY_CYCLE_UPDATE_INTERVAL) {
+    // Update the row's duty cycles to the current iteration.
+    Real64 total = 0.0;
+    for (UInt j = 0; j < stats_.nCols(); ++j) {
+      row[j] *= denom;
+      total += row[j];
+    }
+
+    lastTotalUpdate_[bit] = iteration;
+
+    row[bucketIdx] += alpha_;
+    totals_[bit] = total + alpha_;
+  } else {
+    totals_[bit] += dcNew - row[bucketIdx];
+    row[bucketIdx] = dcNew;
+  }
+}
+
+void BitHistoryTable::store(int iteration, const vector<UInt> &bits,
+                            int bucketIdx) {
+  for (UInt bit : bits) {
+    store(iteration, bit, bucketIdx);
+  }
+}
+
+void BitHistoryTable::infer(const vector<UInt> &bits,
+                            vector<Real64> &votes) const {
+  if (votes.size() < stats_.nCols()) {
+    votes.resize(stats_.nCols(), 0.0);
+  }
+
+  for (UInt bit : bits) {
+    if (bit >= stats_.nRows() || totals_[bit] <= 0.0) {
+      continue;
+    }
+
+    math::kernels::addScaledTo(votes.data(), 1.0 / totals_[bit],
+                               stats_.row(bit), stats_.nCols());
+  }
+}
+
+void BitHistoryTable::write(UInt bit, BitHistoryProto::Builder &proto) const {
+  stringstream ss;
+  ss << bit << "[" << nSteps_ << "]";
+  proto.setId(ss.str().c_str());
+
+  UInt numStats = 0;
+  if (bit < stats_.nRows()) {
+    numStats = (UInt)count_if(stats_.row(bit), stats_.row(bit) + stats_.nCols(),
+                              [](Real64 dc) { return dc != 0.0; });
+  }
+
+  auto statsList = proto.initStats(numStats);
+  UInt i = 0;
+  for (UInt j = 0; j < stats_.nCols() && i < numStats; ++j) {
+    if (stats_.at(bit, j) != 0.0) {
+      auto stat = statsList[i];
+      stat.setIndex(j);
+      stat.setDutyCycle(stats_.at(bit, j));
+      i++;
+    }
+  }
+
+  proto.setLastTotalUpdate(bit < stats_.nRows() ? lastTotalUpdate_[bit] : -1);
+  proto.setLearnIteration(0);
+  proto.setAlpha(alpha_);
+  proto.setVerbosity(verbosity_);
+}
+
+void BitHistoryTable::read(UInt bit, BitHistoryProto::Reader &proto) {
+  NTA_CHECK(fabs(proto.getAlpha() - alpha_) <= 0.000001)
+      << "BitHistoryTable::read - alpha " << proto.getAlpha()
+      << " doesn't match the table's alpha " << alpha_;
+
+  UInt nbuckets = 0;
+  for (auto stat : proto.getStats()) {
+    nbuckets = max(nbuckets, (UInt)stat.getIndex() + 1);
+  }
+  grow_(bit + 1, nbuckets);
+
+  Real64 *row = stats_.row(bit);
+  std::fill(row, row + stats_.nCols(), 0.0);
+  totals_[bit] = 0.0;
+  for (auto stat : proto.getStats()) {
+    row[stat.getIndex()] = stat.getDutyCycle();
+    totals_[bit] += stat.getDutyCycle();
+  }
+
+  lastTotalUpdate_[bit] = proto.getLastTotalUpdate();
+}
+
 } // end namespace cla_classifier
 } // end namespace algorithms
 } // end namespace nupic
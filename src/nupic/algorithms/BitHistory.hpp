@@ -31,6 +31,7 @@
 #include <string>
 #include <vector>
 
+#include <nupic/math/GrowableMatrix.hpp>
 #include <nupic/proto/BitHistory.capnp.h>
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Types.hpp>
@@ -143,6 +144,83 @@ private:
   UInt verbosity_;
 }; // end class BitHistory
 
+/** Class to store duty cycles for buckets for many input bits.
+ *
+ * @b Responsibility
+ * Does the job of one BitHistory per input bit, with the duty cycles of all
+ * the bits in a single row major table: one row per bit, one column per
+ * bucket. As in BitHistory, each row is kept relative to the iteration of
+ * its own last total update, so storing a bucket touches only that element
+ * and rows that aren't stored to are never decayed. Each row can be written
+ * to and read from a BitHistoryProto.
+ *
+ */
+class BitHistoryTable {
+public:
+  /**
+   * Constructor.
+   *
+   * @param nSteps The number of steps this table is storing duty cycles
+   *               for.
+   * @param alpha The alpha to use when decaying the duty cycles.
+   * @param verbosity The logging verbosity to use.
+   *
+   */
+  BitHistoryTable(int nSteps, Real64 alpha, UInt verbosity = 0);
+
+  /**
+   * The number of input bits and buckets seen so far. Both grow as needed
+   * when storing.
+   */
+  UInt numBits() const { return stats_.nRows(); }
+  UInt numBuckets() const { return stats_.nCols(); }
+
+  /**
+   * Same as BitHistory::store for the given bit.
+   */
+  void store(int iteration, UInt bit, int bucketIdx);
+
+  /**
+   * Same as store for each of the given bits.
+   */
+  void store(int iteration, const vector<UInt> &bits, int bucketIdx);
+
+  /**
+   * Adds the normalized duty cycles of each of the given bits to votes,
+   * i.e. the sum of what BitHistory::infer returns for these bits. Bits
+   * that haven't stored anything yet are skipped.
+   *
+   * @param bits The active input bits.
+   * @param votes The votes for each bucket. Grown to numBuckets() elements
+   *              if it is smaller.
+   *
+   */
+  void infer(const vector<UInt> &bits, vector<Real64> &votes) const;
+
+  /**
+   * Save the given bit's row to the builder, the way BitHistory does.
+   */
+  void write(UInt bit, BitHistoryProto::Builder &proto) const;
+
+  /**
+   * Replace the given bit's row with the one in reader.
+   */
+  void read(UInt bit, BitHistoryProto::Reader &proto);
+
+private:
+  void grow_(UInt nbits, UInt nbuckets);
+
+  int nSteps_;
+  Real64 alpha_;
+  UInt verbosity_;
+  // The duty cycles of bit i are in row i, relative to iteration
+  // lastTotalUpdate_[i].
+  GrowableMatrix<Real64> stats_;
+  vector<int> lastTotalUpdate_;
+  // Sum of each row.
+  vector<Real64> totals_;
+}; // end class BitHistoryTable
+
 } // end namespace cla_classifier
 } // end namespace algorithms
 } // end namespace nupic
@@ -24,19 +24,26 @@
  *
  */
 
+#include <algorithm>
+
 #include "nupic/algorithms/CondProbTable.hpp"
+#include "nupic/math/VectorKernels.hpp"
 #include "nupic/utils/Log.hpp"
 
 using namespace std;
 
 namespace nupic {
 
+const Real CondProbTable::DENSE_FILL_THRESHOLD = (Real)0.25;
+
 ////////////////////////////////////////////////////////////////////////////
 // Constructor
 //////////////////////////////////////////////////////////////////////////////
 CondProbTable::CondProbTable(const UInt hintNumCols, const UInt hintNumRows)
     : hintNumCols_(hintNumCols), hintNumRows_(hintNumRows), tableP_(nullptr),
-      cleanTableP_(nullptr), cleanTableValid_(false), rowSums_(), colSums_() {}
+      cleanTableP_(nullptr), cleanTableValid_(false), rowSums_(), colSums_(),
+      dense_(false), tableValid_(true), denseTable_(), scratch_(),
+      nNonZeros_(0) {}
 
 ////////////////////////////////////////////////////////////////////////////
 // Destructor
@@ -51,6 +58,12 @@ CondProbTable::~CondProbTable() {
 //////////////////////////////////////////////////////////////////////////////
 void CondProbTable::getRow(const UInt &row, vector<Real> &contents) {
   // Overwrite the contents
+  if (dense_) {
+    const Real *begin = denseTable_.row(row);
+    contents.assign(begin, begin + denseTable_.nCols());
+    return;
+  }
+
   contents.resize(tableP_->nCols());
   tableP_->getRowToDense(row, contents.begin());
 }
@@ -74,6 +87,19 @@ void CondProbTable::grow(const UInt &rows, const UInt &cols) {
     colSums_.resize(cols, (Real)0);
   }
 
+  if (dense_) {
+    if (rows > denseTable_.nRows() || cols > denseTable_.nCols()) {
+      cleanTableValid_ = false;
+      tableValid_ = false;
+      denseTable_.resize(max(rows, denseTable_.nRows()),
+                         max(cols, denseTable_.nCols()));
+
+      rowSums_.resize(denseTable_.nRows());
+      colSums_.resize(denseTable_.nCols());
+    }
+    return;
+  }
+
   UInt curRows = tableP_->nRows();
   UInt curCols = tableP_->nCols();
   UInt nextRows = max(rows, curRows);
@@ -101,21 +127,99 @@ void CondProbTable::updateRow(const UInt &row,
     cols = hintNumCols_;
   grow(row + 1, cols);
 
-  // Update the row
+  addToRow_(row, distribution.data(), UInt(distribution.size()));
+  checkDensity_();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Update several rows
+////////////////////////////////////////////////////////////////////////////
+void CondProbTable::updateRows(const vector<UInt> &rows,
+                               const vector<Real> &distributions) {
+  const char *errPrefix = "CondProbTable::updateRows() - ";
+
+  if (rows.empty())
+    return;
+
+  NTA_CHECK(distributions.size() % rows.size() == 0)
+      << errPrefix << "Expected " << rows.size()
+      << " distributions of the same length, got " << distributions.size()
+      << " values";
+
+  // Grow the matrix once for the whole batch
+  const UInt n = UInt(distributions.size() / rows.size());
+  grow(*std::max_element(rows.begin(), rows.end()) + 1, max(n, hintNumCols_));
+
+  for (size_t i = 0; i < rows.size(); ++i)
+    addToRow_(rows[i], distributions.data() + i * n, n);
+  checkDensity_();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Add to a row
+////////////////////////////////////////////////////////////////////////////
+void CondProbTable::addToRow_(UInt row, const Real *distribution, UInt n) {
   cleanTableValid_ = false;
-  tableP_->elementRowApply(row, std::plus<Real>(), distribution.begin());
+
+  if (dense_) {
+    tableValid_ = false;
+    math::kernels::addTo(denseTable_.row(row), distribution, n);
+  } else {
+    const size_t rowNonZeros = tableP_->nNonZerosOnRow(row);
+    if (n == tableP_->nCols()) {
+      tableP_->elementRowApply(row, std::plus<Real>(), distribution);
+    } else {
+      // elementRowApply reads a value for every column.
+      scratch_.assign(tableP_->nCols(), (Real)0);
+      std::copy(distribution, distribution + n, scratch_.begin());
+      tableP_->elementRowApply(row, std::plus<Real>(), scratch_.begin());
+    }
+    nNonZeros_ = nNonZeros_ - rowNonZeros + tableP_->nNonZerosOnRow(row);
+  }
 
   // Update the row sums and column sums
   Real rowSum = 0;
-  auto colSumsIter = colSums_.begin();
-  CONST_LOOP(vector<Real>, iter, distribution) {
-    rowSum = rowSum + *iter;
-    *colSumsIter = *colSumsIter + *iter;
-    colSumsIter++;
+  for (UInt j = 0; j < n; ++j) {
+    rowSum = rowSum + distribution[j];
+    colSums_[j] = colSums_[j] + distribution[j];
   }
   rowSums_[row] += rowSum;
 }
 
+////////////////////////////////////////////////////////////////////////////
+// Switch to the dense table
+////////////////////////////////////////////////////////////////////////////
+void CondProbTable::checkDensity_() {
+  if (dense_)
+    return;
+
+  const UInt nrows = tableP_->nRows(), ncols = tableP_->nCols();
+  const size_t size = (size_t)nrows * ncols;
+  if (size == 0 || nNonZeros_ < DENSE_FILL_THRESHOLD * size)
+    return;
+
+  denseTable_ = GrowableMatrix<Real>(nrows, ncols);
+  for (UInt row = 0; row < nrows; ++row)
+    tableP_->getRowToDense(row, denseTable_.row(row));
+
+  dense_ = true;
+  tableValid_ = true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Rebuild the sparse table from the dense one
+////////////////////////////////////////////////////////////////////////////
+void CondProbTable::syncTable_() const {
+  if (!dense_ || tableValid_)
+    return;
+
+  tableP_->resize(denseTable_.nRows(), denseTable_.nCols());
+  for (UInt row = 0; row < denseTable_.nRows(); ++row)
+    tableP_->setRowFromDense(row, denseTable_.row(row));
+
+  tableValid_ = true;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Infer, given vectors as inputs
 //////////////////////////////////////////////////////////////////////////////
@@ -124,14 +228,14 @@ void CondProbTable::inferRow(const vector<Real> &distribution,
   const char *errPrefix = "CondProbTable::inferRow() - ";
 
   // Make sure they gave us the right source size
-  NTA_ASSERT(distribution.size() == tableP_->nCols())
-      << errPrefix << "input distribution vector should be " << tableP_->nCols()
+  NTA_ASSERT(distribution.size() == numColumns())
+      << errPrefix << "input distribution vector should be " << numColumns()
       << " wide";
 
   // And the right output size
-  NTA_ASSERT(outScores.size() >= tableP_->nRows())
+  NTA_ASSERT(outScores.size() >= numRows())
       << errPrefix << "Output vector not large enough to hold all "
-      << tableP_->nRows() << " rows.";
+      << numRows() << " rows.";
 
   // Call the iterator version
   inferRow(distribution.begin(), outScores.begin(), infer);
@@ -157,11 +261,19 @@ void CondProbTable::inferRow(vector<Real>::const_iterator distIter,
     // Normalize by the column sums first
     vector<Real> normDist;
     LOOP(vector<Real>, iter, colSums_) {
-      normDist.push_back(*distIter / *iter);
+      // The sparse product never reads a column that has a sum of 0, the
+      // dense one would multiply its zeros by infinity.
+      normDist.push_back(dense_ && *iter == 0 ? 0 : *distIter / *iter);
       ++distIter;
     }
 
-    tableP_->rightVecProd(normDist.begin(), outIter);
+    if (dense_) {
+      for (UInt row = 0; row < denseTable_.nRows(); ++row, ++outIter)
+        *outIter = math::kernels::dot(denseTable_.row(row), normDist.data(),
+                                      denseTable_.nCols());
+    } else {
+      tableP_->rightVecProd(normDist.begin(), outIter);
+    }
   }
 
   // ----------------------------------------------------------------
@@ -169,7 +281,14 @@ void CondProbTable::inferRow(vector<Real>::const_iterator distIter,
   // ----------------------------------------------------------------
   else if (infer == inferRowEvidence) {
 
-    tableP_->rightVecProd(distIter, outIter);
+    if (dense_) {
+      for (UInt row = 0; row < denseTable_.nRows(); ++row)
+        outIter[row] =
+            math::kernels::dot(denseTable_.row(row), &*distIter,
+                               denseTable_.nCols());
+    } else {
+      tableP_->rightVecProd(distIter, outIter);
+    }
 
     // Normalize by the row sums
     LOOP(vector<Real>, iter, rowSums_) {
@@ -182,7 +301,14 @@ void CondProbTable::inferRow(vector<Real>::const_iterator distIter,
   // Max product per row
   // ----------------------------------------------------------------
   else if (infer == inferMaxProd) {
-    tableP_->vecMaxProd(distIter, outIter);
+    if (dense_) {
+      for (UInt row = 0; row < denseTable_.nRows(); ++row, ++outIter)
+        *outIter =
+            math::kernels::maxProd(denseTable_.row(row), &*distIter,
+                                   denseTable_.nCols());
+    } else {
+      tableP_->vecMaxProd(distIter, outIter);
+    }
   }
 
   // ----------------------------------------------------------------
@@ -210,6 +336,8 @@ void CondProbTable::inferRow(vector<Real>::const_iterator distIter,
 void CondProbTable::makeCleanCPT() {
   delete cleanTableP_;
 
+  syncTable_();
+
   UInt nrows = tableP_->nRows(), ncols = tableP_->nCols();
   vector<pair<UInt, Real>> col_max(ncols, make_pair(0, Real(0)));
 
@@ -239,6 +367,7 @@ void CondProbTable::saveState(ostream &state) const {
   state << "CondProbTable.V1 ";
 
   // Do we have a table yet?
+  syncTable_();
   if (tableP_) {
     state << "1 ";
     state << tableP_->nCols() << " ";
@@ -281,6 +410,10 @@ void CondProbTable::readState(istream &state) {
   }
 
   cleanTableValid_ = false;
+  dense_ = false;
+  tableValid_ = true;
+  denseTable_ = GrowableMatrix<Real>();
+  nNonZeros_ = 0;
 
   // -----------------------------------------------------------------
   // Get # of columns then read in the old matrix
@@ -292,6 +425,7 @@ void CondProbTable::readState(istream &state) {
       state >> hintNumCols_;
       tableP_ = new SparseMatrix<UInt, Real>(0, hintNumCols_);
       tableP_->fromCSR(state);
+      nNonZeros_ = tableP_->nNonZeros();
     } else {
       state >> hintNumCols_ >> hintNumRows_;
     }
@@ -306,7 +440,7 @@ void CondProbTable::readState(istream &state) {
   if (tableP_) {
     // Update the row sums and column sums
     rowSums_.resize(tableP_->nRows());
-    colSums_.resize(tableP_->nCols());
+    colSums_.assign(tableP_->nCols(), (Real)0);
 
     auto rowIter = rowSums_.begin();
     vector<Real> row;
@@ -325,6 +459,8 @@ void CondProbTable::readState(istream &state) {
         ++srcIter;
       }
     }
+
+    checkDensity_();
   }
 
   // Restore exceptions mask
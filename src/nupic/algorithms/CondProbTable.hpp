@@ -25,6 +25,7 @@
 #ifndef NTA_COND_PROB_TABLE_HPP
 #define NTA_COND_PROB_TABLE_HPP
 
+#include <nupic/math/GrowableMatrix.hpp>
 #include <nupic/math/SparseMatrix.hpp>
 #include <nupic/math/SparseMatrix01.hpp>
 
@@ -45,6 +46,13 @@ namespace nupic {
 /// compressed sparse row matrix. Also maintains the row and column sumProp
 /// distributions.
 ///
+/// Once the fraction of non-zeros in the table reaches DENSE_FILL_THRESHOLD,
+/// the table is moved to a dense matrix, where updates and inference are
+/// straight loops over contiguous rows. The sparse matrix is then only
+/// rebuilt when it is asked for, by getTable() or saveState(), so the saved
+/// state is the same either way. The dense inference assumes that the
+/// distributions and the table are non-negative, as probabilities are.
+///
 //////////////////////////////////////////////////////////////////////////////
 class CondProbTable {
 public:
@@ -101,7 +109,9 @@ public:
   /// @retval number of rows
   ///////////////////////////////////////////////////////////////////////////////////
   UInt numRows(void) {
-    if (tableP_)
+    if (dense_)
+      return denseTable_.nRows();
+    else if (tableP_)
       return UInt(tableP_->nRows());
     else
       return hintNumRows_;
@@ -113,7 +123,9 @@ public:
   /// @retval number of rows
   ///////////////////////////////////////////////////////////////////////////////////
   UInt numColumns(void) {
-    if (tableP_)
+    if (dense_)
+      return denseTable_.nCols();
+    else if (tableP_)
       return tableP_->nCols();
     else
       return hintNumCols_;
@@ -127,6 +139,17 @@ public:
   ///////////////////////////////////////////////////////////////////////////////////
   void updateRow(const UInt &row, const std::vector<Real> &distribution);
 
+  /////////////////////////////////////////////////////////////////////////////////////
+  /// Update several rows at once. The table is grown only once for the whole
+  /// batch.
+  ///
+  /// @param rows          which rows to update
+  /// @param distributions rows.size() distributions of the same length, one
+  ///                        after the other
+  ///////////////////////////////////////////////////////////////////////////////////
+  void updateRows(const std::vector<UInt> &rows,
+                  const std::vector<Real> &distributions);
+
   /////////////////////////////////////////////////////////////////////////////////////
   /// Return the probablity of the given distribution belonging to each row.
   ///
@@ -148,6 +171,11 @@ public:
   ///                 max element of each column, setting it to 1, and putting 0
   ///                 in all other elements of the column.
   ///
+  /// A dense table sums the products of a row in the order of
+  /// math::kernels::dot, and a sparse one in column order. The two agree
+  /// within 2 * (numColumns() + 1) * epsilon times the sum of the absolute
+  /// products, where epsilon is that of Real.
+  ///
   /// @param distribution   the distribution to test - length equal to # of
   /// columns
   /// @param outScores      the return probablity of distribution belonging to
@@ -189,7 +217,19 @@ public:
   ///
   /// @retval pointer to the table
   ///////////////////////////////////////////////////////////////////////////////////
-  const SparseMatrix<UInt, Real> *getTable(void) const { return tableP_; }
+  const SparseMatrix<UInt, Real> *getTable(void) const {
+    syncTable_();
+    return tableP_;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////
+  /// Whether the table has moved to the dense representation.
+  ///////////////////////////////////////////////////////////////////////////////////
+  bool isDense(void) const { return dense_; }
+
+  /// Fraction of non-zeros at which the table moves to the dense
+  /// representation.
+  static const Real DENSE_FILL_THRESHOLD;
 
   /////////////////////////////////////////////////////////////////////////////////////
   /// Save state to a stream
@@ -221,6 +261,21 @@ private:
   ///////////////////////////////////////////////////////////////////////////////////
   void makeCleanCPT(void);
 
+  /////////////////////////////////////////////////////////////////////////////////////
+  /// Add n values to a row that the table has already been grown to hold.
+  ///////////////////////////////////////////////////////////////////////////////////
+  void addToRow_(UInt row, const Real *distribution, UInt n);
+
+  /////////////////////////////////////////////////////////////////////////////////////
+  /// Move the table to the dense representation if it is full enough.
+  ///////////////////////////////////////////////////////////////////////////////////
+  void checkDensity_(void);
+
+  /////////////////////////////////////////////////////////////////////////////////////
+  /// Bring tableP_ up to date with the dense table.
+  ///////////////////////////////////////////////////////////////////////////////////
+  void syncTable_(void) const;
+
   UInt hintNumCols_;
   UInt hintNumRows_;
   SparseMatrix<UInt, Real> *tableP_;
@@ -228,6 +283,16 @@ private:
   bool cleanTableValid_;
   std::vector<Real> rowSums_;
   std::vector<Real> colSums_;
+
+  // When dense_ is set, denseTable_ holds the table and tableP_ only has
+  // the right contents while tableValid_ is set.
+  bool dense_;
+  mutable bool tableValid_;
+  GrowableMatrix<Real> denseTable_;
+  std::vector<Real> scratch_;
+  // Non-zeros of tableP_ while it is the backing table, kept up to date by
+  // addToRow_ so that checkDensity_ does not have to walk every row.
+  size_t nNonZeros_;
 };
 
 } // namespace nupic
@@ -501,10 +501,24 @@ void Connections::read(ConnectionsProto::Reader &proto) {
 
   initialize(protoCells.size());
 
+  // Size the flat lists once rather than growing them segment by segment.
+  size_t numSegments = 0, numSynapses = 0;
+  for (auto protoCell : protoCells) {
+    for (auto protoSegment : protoCell.getSegments()) {
+      numSegments++;
+      numSynapses += protoSegment.getSynapses().size();
+    }
+  }
+  segments_.reserve(segments_.size() + numSegments);
+  segmentOrdinals_.reserve(segmentOrdinals_.size() + numSegments);
+  synapses_.reserve(synapses_.size() + numSynapses);
+  synapseOrdinals_.reserve(synapseOrdinals_.size() + numSynapses);
+
   for (CellIdx cell = 0; cell < protoCells.size(); ++cell) {
     CellData &cellData = cells_[cell];
 
     auto protoSegments = protoCells[cell].getSegments();
+    cellData.segments.reserve(protoSegments.size());
 
     for (SegmentIdx j = 0; j < (SegmentIdx)protoSegments.size(); ++j) {
       Segment segment;
@@ -519,6 +533,7 @@ void Connections::read(ConnectionsProto::Reader &proto) {
       SegmentData &segmentData = segments_[segment];
 
       auto protoSynapses = protoSegments[j].getSynapses();
+      segmentData.synapses.reserve(protoSynapses.size());
 
       for (SynapseIdx k = 0; k < protoSynapses.size(); ++k) {
         CellIdx presynapticCell = protoSynapses[k].getPresynapticCell();
@@ -21,7 +21,6 @@
  */
 
 #include <cmath>
-#include <deque>
 #include <iostream>
 #include <limits>
 #include <map>
@@ -37,6 +36,7 @@
 #include <nupic/algorithms/ClassifierResult.hpp>
 #include <nupic/algorithms/SDRClassifier.hpp>
 #include <nupic/math/ArrayAlgo.hpp>
+#include <nupic/math/VectorKernels.hpp>
 #include <nupic/proto/SdrClassifier.capnp.h>
 #include <nupic/utils/Log.hpp>
 
@@ -46,9 +46,28 @@ namespace nupic {
 namespace algorithms {
 namespace sdr_classifier {
 
+namespace {
+
+// Like Dense::axby, zeroes the weights of a row that end up within
+// nupic::Epsilon of 0. Returns true if a nonzero weight was zeroed.
+template <typename T> bool thresholdRow(T *row, UInt n) {
+  bool zeroed = false;
+  for (UInt i = 0; i < n; ++i) {
+    if (row[i] != 0 && fabs(row[i]) <= nupic::Epsilon) {
+      row[i] = 0;
+      zeroed = true;
+    }
+  }
+  return zeroed;
+}
+
+} // namespace
+
 SDRClassifier::SDRClassifier(const vector<UInt> &steps, Real64 alpha,
-                             Real64 actValueAlpha, UInt verbosity)
+                             Real64 actValueAlpha, UInt verbosity,
+                             WeightPrecision weightPrecision)
     : steps_(steps), alpha_(alpha), actValueAlpha_(actValueAlpha),
+      historyBegin_(0), historySize_(0), weightPrecision_(weightPrecision),
       maxInputIdx_(0), maxBucketIdx_(0), actualValues_({0.0}),
       actualValuesSet_({false}), version_(sdrClassifierVersion),
       verbosity_(verbosity) {
@@ -58,18 +77,12 @@ SDRClassifier::SDRClassifier(const vector<UInt> &steps, Real64 alpha,
   } else {
     maxSteps_ = 1;
   }
+  clearHistory_();
 
-  // TODO: insert maxBucketIdx / maxInputIdx hint as parameter?
-  // There can be great overhead reallocating the array every time a new
-  // input is seen, especially if we start at (0, 0). The client will
-  // usually know what is the final maxInputIdx (typically the number
-  // of columns?), and we can have heuristics using the encoder's
-  // settings to get an good approximate of the maxBucketIdx, thus having
-  // to reallocate this matrix only a few times, even never if we use
-  // lower bounds
-  for (const auto &step : steps_) {
-    weightMatrix_.emplace(step, Matrix(maxInputIdx_ + 1, maxBucketIdx_ + 1));
-  }
+  // The weights start with one input bit and one bucket, and double their
+  // capacity whenever they need to grow, so new input bits and buckets are
+  // cheap to add.
+  resizeWeights_();
 }
 
 SDRClassifier::~SDRClassifier() {}
@@ -78,89 +91,108 @@ void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
                             const vector<UInt> &bucketIdxList,
                             const vector<Real64> &actValueList, bool category,
                             bool learn, bool infer, ClassifierResult *result) {
+  const Matrix &activations = addRecord_(recordNum, patternNZ, infer);
+
+  // if in inference mode, compute likelihood and update return value
+  if (infer) {
+    infer_(activations, actValueList, result);
+  }
+
+  // update weights if in learning mode
+  if (learn) {
+    learn_(recordNum, bucketIdxList, actValueList, category);
+  }
+}
+
+void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
+                            const vector<UInt> &bucketIdxList,
+                            const vector<Real64> &actValueList, bool category,
+                            bool learn, UInt topK,
+                            vector<vector<BucketPrediction>> &predictions) {
+  const Matrix &activations = addRecord_(recordNum, patternNZ, true);
+  inferTopK_(activations, actValueList, topK, predictions);
+  if (learn) {
+    learn_(recordNum, bucketIdxList, actValueList, category);
+  }
+}
+
+const Matrix &SDRClassifier::addRecord_(UInt recordNum,
+                                        const vector<UInt> &patternNZ,
+                                        bool infer) {
+  NTA_CHECK(!history_.empty())
+      << "SDRClassifier has no pattern history, it must be constructed "
+         "with its steps or loaded before compute";
+
   // ensures that recordNum increases monotonically
   UInt lastRecordNum = -1;
-  if (recordNumHistory_.size() > 0) {
-    lastRecordNum = recordNumHistory_[recordNumHistory_.size() - 1];
+  if (historySize_ > 0) {
+    lastRecordNum = historyEntry_(historySize_ - 1).recordNum;
     if (recordNum < lastRecordNum)
       NTA_THROW << "the record number has to increase monotonically";
   }
 
-  // update pattern history if this is a new record
-  if (recordNumHistory_.size() == 0 || recordNum > lastRecordNum) {
-    patternNZHistory_.emplace_back(patternNZ.begin(), patternNZ.end());
-    recordNumHistory_.push_back(recordNum);
-    if (patternNZHistory_.size() > maxSteps_) {
-      patternNZHistory_.pop_front();
-      recordNumHistory_.pop_front();
-    }
-  }
-
   // if input pattern has greater index than previously seen, update
   // maxInputIdx and augment weight matrix with zero padding
   if (patternNZ.size() > 0) {
     UInt maxInputIdx = *max_element(patternNZ.begin(), patternNZ.end());
     if (maxInputIdx > maxInputIdx_) {
       maxInputIdx_ = maxInputIdx;
-      for (const auto &step : steps_) {
-        Matrix &weights = weightMatrix_.at(step);
-        weights.resize(maxInputIdx_ + 1, maxBucketIdx_ + 1);
-      }
+      resizeWeights_();
     }
   }
 
-  // if in inference mode, compute likelihood and update return value
+  // update pattern history if this is a new record. Its activations are
+  // the forward pass of inference, and are kept for learning.
+  if (historySize_ == 0 || recordNum > lastRecordNum) {
+    HistoryEntry &entry = pushHistory_(recordNum, patternNZ);
+    computeActivations_(entry.patternNZ, entry.activations);
+    return entry.activations;
+  }
+
   if (infer) {
-    infer_(patternNZ, actValueList, result);
+    computeActivations_(patternNZ, activations_);
   }
+  return activations_;
+}
 
-  // update weights if in learning mode
-  if (learn) {
-    for (size_t categoryI = 0; categoryI < bucketIdxList.size(); categoryI++) {
-      UInt bucketIdx = bucketIdxList[categoryI];
-      Real64 actValue = actValueList[categoryI];
-      // if bucket is greater, update maxBucketIdx_ and augment weight
-      // matrix with zero-padding
-      if (bucketIdx > maxBucketIdx_) {
-        maxBucketIdx_ = bucketIdx;
-        for (const auto &step : steps_) {
-          Matrix &weights = weightMatrix_.at(step);
-          weights.resize(maxInputIdx_ + 1, maxBucketIdx_ + 1);
-        }
-      }
+void SDRClassifier::learn_(UInt recordNum, const vector<UInt> &bucketIdxList,
+                           const vector<Real64> &actValueList, bool category) {
+  for (size_t categoryI = 0; categoryI < bucketIdxList.size(); categoryI++) {
+    UInt bucketIdx = bucketIdxList[categoryI];
+    Real64 actValue = actValueList[categoryI];
+    // if bucket is greater, update maxBucketIdx_ and augment weight
+    // matrix with zero-padding
+    if (bucketIdx > maxBucketIdx_) {
+      maxBucketIdx_ = bucketIdx;
+      resizeWeights_();
+    }
 
-      // update rolling averages of bucket values
-      while (actualValues_.size() <= maxBucketIdx_) {
-        actualValues_.push_back(0.0);
-        actualValuesSet_.push_back(false);
-      }
-      if (!actualValuesSet_[bucketIdx] || category) {
-        actualValues_[bucketIdx] = actValue;
-        actualValuesSet_[bucketIdx] = true;
-      } else {
-        actualValues_[bucketIdx] =
-            ((1.0 - actValueAlpha_) * actualValues_[bucketIdx]) +
-            (actValueAlpha_ * actValue);
-      }
+    // update rolling averages of bucket values
+    while (actualValues_.size() <= maxBucketIdx_) {
+      actualValues_.push_back(0.0);
+      actualValuesSet_.push_back(false);
+    }
+    if (!actualValuesSet_[bucketIdx] || category) {
+      actualValues_[bucketIdx] = actValue;
+      actualValuesSet_[bucketIdx] = true;
+    } else {
+      actualValues_[bucketIdx] =
+          ((1.0 - actValueAlpha_) * actualValues_[bucketIdx]) +
+          (actValueAlpha_ * actValue);
     }
+  }
 
-    // compute errors and update weights
-    auto patternIteration = patternNZHistory_.begin();
-    for (auto learnRecord = recordNumHistory_.begin();
-         learnRecord != recordNumHistory_.end();
-         learnRecord++, patternIteration++) {
-      const vector<UInt> learnPatternNZ = *patternIteration;
-      const UInt nSteps = recordNum - *learnRecord;
-
-      // update weights
-      if (binary_search(steps_.begin(), steps_.end(), nSteps)) {
-        vector<Real64> error =
-            calculateError_(bucketIdxList, learnPatternNZ, nSteps);
-        Matrix &weights = weightMatrix_.at(nSteps);
-        for (auto &bit : learnPatternNZ) {
-          weights.axby(bit, 1.0, alpha_, error);
-        }
-      }
+  // compute errors and update weights
+  for (UInt i = 0; i < historySize_; ++i) {
+    const HistoryEntry &entry = historyEntry_(i);
+    const UInt nSteps = recordNum - entry.recordNum;
+
+    // update weights
+    const UInt stepIdx = stepIndex_(nSteps);
+    if (stepIdx < steps_.size()) {
+      vector<Real64> error =
+          calculateError_(bucketIdxList, entry.activations.row(stepIdx));
+      updateWeights_(entry.patternNZ, stepIdx, error);
     }
   }
 }
@@ -173,7 +205,7 @@ UInt SDRClassifier::persistentSize() const {
   return s.str().size();
 }
 
-void SDRClassifier::infer_(const vector<UInt> &patternNZ,
+void SDRClassifier::infer_(const Matrix &activations,
                            const vector<Real64> &actValue,
                            ClassifierResult *result) {
   // add the actual values to the return value. For buckets that haven't
@@ -182,42 +214,107 @@ void SDRClassifier::infer_(const vector<UInt> &patternNZ,
   vector<Real64> *actValueVector =
       result->createVector(-1, actualValues_.size(), 0.0);
   for (UInt i = 0; i < actualValues_.size(); ++i) {
-    if (actualValuesSet_[i]) {
-      (*actValueVector)[i] = actualValues_[i];
-    } else {
-      // if doing 0-step ahead prediction, we shouldn't use any
-      // knowledge of the classification input during inference
-      if (steps_.at(0) == 0) {
-        (*actValueVector)[i] = 0;
-      } else {
-        (*actValueVector)[i] = actValue[0];
-      }
-    }
+    (*actValueVector)[i] = actualValue_(i, actValue);
   }
 
-  for (auto nSteps = steps_.begin(); nSteps != steps_.end(); ++nSteps) {
+  const UInt numBuckets = maxBucketIdx_ + 1;
+  for (UInt stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
     vector<Real64> *likelihoods =
-        result->createVector(*nSteps, maxBucketIdx_ + 1, 0.0);
-    for (auto &bit : patternNZ) {
-      const Matrix &weights = weightMatrix_.at(*nSteps);
-      add(likelihoods->begin(), likelihoods->end(), weights.begin(bit),
-          weights.begin(bit + 1));
-    }
+        result->createVector(steps_[stepIdx], numBuckets, 0.0);
+    const Real64 *row = activations.row(stepIdx);
+    copy(row, row + numBuckets, likelihoods->begin());
     softmax_(likelihoods->begin(), likelihoods->end());
   }
 }
 
-vector<Real64> SDRClassifier::calculateError_(const vector<UInt> &bucketIdxList,
-                                              const vector<UInt> patternNZ,
-                                              UInt step) {
-  // compute predicted likelihoods
-  vector<Real64> likelihoods(maxBucketIdx_ + 1, 0);
+void SDRClassifier::inferTopK_(const Matrix &activations,
+                               const vector<Real64> &actValue, UInt topK,
+                               vector<vector<BucketPrediction>> &predictions) {
+  // The softmax preserves the order of the activations, so the buckets are
+  // selected on their activations, and only the selected ones are
+  // normalized.
+  auto better = [](const BucketPrediction &a, const BucketPrediction &b) {
+    return a.likelihood > b.likelihood ||
+           (a.likelihood == b.likelihood && a.bucketIdx < b.bucketIdx);
+  };
+
+  const UInt numBuckets = maxBucketIdx_ + 1;
+  predictions.resize(steps_.size());
+  for (UInt stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+    const Real64 *row = activations.row(stepIdx);
+    vector<BucketPrediction> &stepPredictions = predictions[stepIdx];
+    stepPredictions.clear();
+    if (topK == 0) {
+      continue;
+    }
+
+    // Keep a heap of the best buckets so far, the worst one on top.
+    for (UInt j = 0; j < numBuckets; ++j) {
+      const BucketPrediction candidate = {j, row[j], 0.0};
+      if (stepPredictions.size() < topK) {
+        stepPredictions.push_back(candidate);
+        push_heap(stepPredictions.begin(), stepPredictions.end(), better);
+      } else if (better(candidate, stepPredictions.front())) {
+        pop_heap(stepPredictions.begin(), stepPredictions.end(), better);
+        stepPredictions.back() = candidate;
+        push_heap(stepPredictions.begin(), stepPredictions.end(), better);
+      }
+    }
+    sort_heap(stepPredictions.begin(), stepPredictions.end(), better);
 
+    // Same arithmetic as softmax_, so the likelihoods match compute's.
+    const Real64 maxValue = *std::max_element(row, row + numBuckets);
+    Real64 sum = 0.0;
+    for (UInt j = 0; j < numBuckets; ++j) {
+      sum += exp(row[j] - maxValue);
+    }
+    for (auto &prediction : stepPredictions) {
+      prediction.likelihood = exp(prediction.likelihood - maxValue) / sum;
+      prediction.actualValue = actualValue_(prediction.bucketIdx, actValue);
+    }
+  }
+}
+
+Real64 SDRClassifier::actualValue_(UInt bucketIdx,
+                                   const vector<Real64> &actValue) const {
+  if (bucketIdx < actualValues_.size() && actualValuesSet_[bucketIdx]) {
+    return actualValues_[bucketIdx];
+  }
+  // if doing 0-step ahead prediction, we shouldn't use any
+  // knowledge of the classification input during inference
+  if (steps_.at(0) == 0) {
+    return 0;
+  }
+  return actValue[0];
+}
+
+void SDRClassifier::computeActivations_(const vector<UInt> &patternNZ,
+                                        Matrix &activations) const {
+  // Accumulate the activations of all the steps in one walk over the
+  // active bits, whose weights are next to each other.
+  const UInt numBuckets = maxBucketIdx_ + 1;
+  activations.resize(steps_.size(), numBuckets);
+  for (UInt stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+    std::fill(activations.row(stepIdx), activations.row(stepIdx) + numBuckets,
+              0.0);
+  }
   for (auto &bit : patternNZ) {
-    const Matrix &weights = weightMatrix_.at(step);
-    add(likelihoods.begin(), likelihoods.end(), weights.begin(bit),
-        weights.begin(bit + 1));
+    for (UInt stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+      if (weightPrecision_ == WeightPrecision::REAL32) {
+        math::kernels::addTo(activations.row(stepIdx),
+                             weights32Row_(bit, stepIdx), numBuckets);
+      } else {
+        math::kernels::addTo(activations.row(stepIdx),
+                             weightsRow_(bit, stepIdx), numBuckets);
+      }
+    }
   }
+}
+
+vector<Real64> SDRClassifier::calculateError_(const vector<UInt> &bucketIdxList,
+                                              const Real64 *activations) {
+  // compute predicted likelihoods
+  vector<Real64> likelihoods(activations, activations + maxBucketIdx_ + 1);
   softmax_(likelihoods.begin(), likelihoods.end());
 
   // compute target likelihoods
@@ -230,19 +327,132 @@ vector<Real64> SDRClassifier::calculateError_(const vector<UInt> &bucketIdxList,
   return likelihoods;
 }
 
+void SDRClassifier::updateWeights_(const vector<UInt> &patternNZ,
+                                   UInt stepIdx, const vector<Real64> &error) {
+  const UInt numBuckets = maxBucketIdx_ + 1;
+  bool thresholded = false;
+  for (auto &bit : patternNZ) {
+    if (weightPrecision_ == WeightPrecision::REAL32) {
+      Real32 *row = weights32Row_(bit, stepIdx);
+      math::kernels::addScaledTo(row, alpha_, error.data(), numBuckets);
+      thresholded |= thresholdRow(row, numBuckets);
+    } else {
+      Real64 *row = weightsRow_(bit, stepIdx);
+      math::kernels::addScaledTo(row, alpha_, error.data(), numBuckets);
+      thresholded |= thresholdRow(row, numBuckets);
+    }
+    ++bitCounts_[bit];
+  }
+
+  // Every active bit that a pattern shares with patternNZ moves that
+  // pattern's activations by alpha * error, so patching the activations of
+  // the history is cheaper than summing their weights again. The rare
+  // updates that zeroed a weight don't move it by alpha * error, and the
+  // activations that depend on it are summed again instead.
+  for (UInt i = 0; i < historySize_; ++i) {
+    HistoryEntry &entry = historyEntry_(i);
+    UInt overlap = 0;
+    for (auto &bit : entry.patternNZ) {
+      overlap += bitCounts_[bit];
+    }
+    if (overlap == 0) {
+      continue;
+    }
+
+    Real64 *activations = entry.activations.row(stepIdx);
+    if (!thresholded) {
+      math::kernels::addScaledTo(activations, alpha_ * overlap, error.data(),
+                                 numBuckets);
+    } else {
+      std::fill(activations, activations + numBuckets, 0.0);
+      for (auto &bit : entry.patternNZ) {
+        if (weightPrecision_ == WeightPrecision::REAL32) {
+          math::kernels::addTo(activations, weights32Row_(bit, stepIdx),
+                               numBuckets);
+        } else {
+          math::kernels::addTo(activations, weightsRow_(bit, stepIdx),
+                               numBuckets);
+        }
+      }
+    }
+  }
+
+  for (auto &bit : patternNZ) {
+    bitCounts_[bit] = 0;
+  }
+}
+
 void SDRClassifier::softmax_(vector<Real64>::iterator begin,
                              vector<Real64>::iterator end) {
-  vector<Real64>::iterator maxItr = max_element(begin, end);
-  for (auto itr = begin; itr != end; ++itr) {
-    *itr -= *maxItr;
+  if (begin == end) {
+    return;
   }
-  range_exp(1.0, begin, end);
-  Real64 sum = accumulate(begin, end, 0.0);
+  const Real64 maxValue = *max_element(begin, end);
+  Real64 sum = 0.0;
   for (auto itr = begin; itr != end; ++itr) {
-    *itr /= sum;
+    *itr = exp(*itr - maxValue);
+    sum += *itr;
+  }
+  math::kernels::divideBy(&*begin, (UInt)(end - begin), sum);
+}
+
+UInt SDRClassifier::stepIndex_(UInt step) const {
+  auto it = lower_bound(steps_.begin(), steps_.end(), step);
+  if (it == steps_.end() || *it != step) {
+    return steps_.size();
+  }
+  return it - steps_.begin();
+}
+
+SDRClassifier::HistoryEntry &
+SDRClassifier::pushHistory_(UInt recordNum, const vector<UInt> &patternNZ) {
+  NTA_CHECK(!history_.empty()) << "SDRClassifier: maxSteps must be positive";
+  if (historySize_ < history_.size()) {
+    ++historySize_;
+  } else {
+    historyBegin_ = (historyBegin_ + 1) % history_.size();
+  }
+  HistoryEntry &entry = historyEntry_(historySize_ - 1);
+  entry.recordNum = recordNum;
+  entry.patternNZ.assign(patternNZ.begin(), patternNZ.end());
+  return entry;
+}
+
+void SDRClassifier::clearHistory_() {
+  history_.assign(maxSteps_, HistoryEntry());
+  historyBegin_ = 0;
+  historySize_ = 0;
+}
+
+Real64 SDRClassifier::getWeight_(UInt bit, UInt stepIdx,
+                                 UInt bucketIdx) const {
+  if (weightPrecision_ == WeightPrecision::REAL32) {
+    return weights32Row_(bit, stepIdx)[bucketIdx];
+  }
+  return weightsRow_(bit, stepIdx)[bucketIdx];
+}
+
+void SDRClassifier::setWeight_(UInt bit, UInt stepIdx, UInt bucketIdx,
+                               Real64 weight) {
+  if (weightPrecision_ == WeightPrecision::REAL32) {
+    weights32Row_(bit, stepIdx)[bucketIdx] = (Real32)weight;
+  } else {
+    weightsRow_(bit, stepIdx)[bucketIdx] = weight;
   }
 }
 
+void SDRClassifier::resizeWeights_() {
+  if (weightPrecision_ == WeightPrecision::REAL32) {
+    weights32_.resize((maxInputIdx_ + 1) * steps_.size(), maxBucketIdx_ + 1);
+  } else {
+    weights_.resize((maxInputIdx_ + 1) * steps_.size(), maxBucketIdx_ + 1);
+  }
+  for (UInt i = 0; i < historySize_; ++i) {
+    historyEntry_(i).activations.resize(steps_.size(), maxBucketIdx_ + 1);
+  }
+  bitCounts_.resize(maxInputIdx_ + 1, 0);
+}
+
 UInt SDRClassifier::version() const { return version_; }
 
 UInt SDRClassifier::getVerbosity() const { return verbosity_; }
@@ -251,6 +461,10 @@ void SDRClassifier::setVerbosity(UInt verbosity) { verbosity_ = verbosity; }
 
 UInt SDRClassifier::getAlpha() const { return alpha_; }
 
+SDRClassifier::WeightPrecision SDRClassifier::getWeightPrecision() const {
+  return weightPrecision_;
+}
+
 void SDRClassifier::save(ostream &outStream) const {
   // Write a starting marker and version.
   outStream << "SDRClassifier" << endl;
@@ -262,9 +476,9 @@ void SDRClassifier::save(ostream &outStream) const {
             << verbosity_ << " " << endl;
 
   // V1 additions.
-  outStream << recordNumHistory_.size() << " ";
-  for (const auto &elem : recordNumHistory_) {
-    outStream << elem << " ";
+  outStream << historySize_ << " ";
+  for (UInt i = 0; i < historySize_; ++i) {
+    outStream << historyEntry_(i).recordNum << " ";
   }
   outStream << endl;
 
@@ -276,8 +490,9 @@ void SDRClassifier::save(ostream &outStream) const {
   outStream << endl;
 
   // Store the pattern history.
-  outStream << patternNZHistory_.size() << " ";
-  for (auto &pattern : patternNZHistory_) {
+  outStream << historySize_ << " ";
+  for (UInt i = 0; i < historySize_; ++i) {
+    const vector<UInt> &pattern = historyEntry_(i).patternNZ;
     outStream << pattern.size() << " ";
     for (auto &pattern_j : pattern) {
       outStream << pattern_j << " ";
@@ -286,10 +501,15 @@ void SDRClassifier::save(ostream &outStream) const {
   outStream << endl;
 
   // Store weight matrix
-  outStream << weightMatrix_.size() << " ";
-  for (const auto &elem : weightMatrix_) {
-    outStream << elem.first << " ";
-    outStream << elem.second;
+  outStream << steps_.size() << " ";
+  for (UInt stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+    outStream << steps_[stepIdx] << " ";
+    for (UInt i = 0; i <= maxInputIdx_; ++i) {
+      for (UInt j = 0; j <= maxBucketIdx_; ++j) {
+        outStream << getWeight_(i, stepIdx, j) << " ";
+      }
+      outStream << endl;
+    }
   }
   outStream << endl;
 
@@ -308,11 +528,12 @@ void SDRClassifier::save(ostream &outStream) const {
 void SDRClassifier::load(istream &inStream) {
   // Clean up the existing data structures before loading
   steps_.clear();
-  recordNumHistory_.clear();
-  patternNZHistory_.clear();
   actualValues_.clear();
   actualValuesSet_.clear();
-  weightMatrix_.clear();
+  weights_ = Matrix();
+  weights32_ = GrowableMatrix<Real32>();
+  // The text format doesn't record the precision of the weights.
+  weightPrecision_ = WeightPrecision::REAL64;
 
   // Check the starting marker.
   string marker;
@@ -329,12 +550,12 @@ void SDRClassifier::load(istream &inStream) {
       maxBucketIdx_ >> maxInputIdx_ >> verbosity_;
 
   UInt recordNumHistory;
-  UInt curRecordNum;
+  vector<UInt> recordNums;
   if (version == 1) {
     inStream >> recordNumHistory;
+    recordNums.resize(recordNumHistory);
     for (UInt i = 0; i < recordNumHistory; ++i) {
-      inStream >> curRecordNum;
-      recordNumHistory_.push_back(curRecordNum);
+      inStream >> recordNums[i];
     }
   }
 
@@ -348,26 +569,36 @@ void SDRClassifier::load(istream &inStream) {
   }
 
   // Load the input pattern history.
+  // Version 0 has no record numbers, so its patterns can't be learned
+  // from and are dropped.
+  clearHistory_();
   inStream >> size;
   UInt vSize;
+  vector<UInt> pattern;
   for (UInt i = 0; i < size; ++i) {
     inStream >> vSize;
-    patternNZHistory_.emplace_back(vSize);
+    pattern.resize(vSize);
     for (UInt j = 0; j < vSize; ++j) {
-      inStream >> patternNZHistory_[i][j];
+      inStream >> pattern[j];
+    }
+    if (i < recordNums.size()) {
+      pushHistory_(recordNums[i], pattern);
     }
   }
 
   // Load weight matrix.
   UInt numSteps;
   inStream >> numSteps;
+  resizeWeights_();
   for (UInt s = 0; s < numSteps; ++s) {
     inStream >> step;
-    // Insert the step to initialize the weight matrix
-    weightMatrix_[step] = Matrix(maxInputIdx_ + 1, maxBucketIdx_ + 1);
+    const UInt stepIdx = stepIndex_(step);
+    NTA_CHECK(stepIdx < steps_.size());
     for (UInt i = 0; i <= maxInputIdx_; ++i) {
       for (UInt j = 0; j <= maxBucketIdx_; ++j) {
-        inStream >> weightMatrix_[step].at(i, j);
+        Real64 weight;
+        inStream >> weight;
+        setWeight_(i, stepIdx, j, weight);
       }
     }
   }
@@ -388,6 +619,12 @@ void SDRClassifier::load(istream &inStream) {
   inStream >> marker;
   NTA_CHECK(marker == "~SDRClassifier");
 
+  // Recompute the activations of the history.
+  for (UInt i = 0; i < historySize_; ++i) {
+    HistoryEntry &entry = historyEntry_(i);
+    computeActivations_(entry.patternNZ, entry.activations);
+  }
+
   // Update the version number.
   version_ = sdrClassifierVersion;
 }
@@ -402,41 +639,40 @@ void SDRClassifier::write(SdrClassifierProto::Builder &proto) const {
   proto.setActValueAlpha(actValueAlpha_);
   proto.setMaxSteps(maxSteps_);
 
-  auto patternNZHistoryProto =
-      proto.initPatternNZHistory(patternNZHistory_.size());
-  for (UInt i = 0; i < patternNZHistory_.size(); i++) {
-    const auto &pattern = patternNZHistory_[i];
+  auto patternNZHistoryProto = proto.initPatternNZHistory(historySize_);
+  for (UInt i = 0; i < historySize_; i++) {
+    const auto &pattern = historyEntry_(i).patternNZ;
     auto patternProto = patternNZHistoryProto.init(i, pattern.size());
     for (UInt j = 0; j < pattern.size(); j++) {
       patternProto.set(j, pattern[j]);
     }
   }
 
-  auto recordNumHistoryProto =
-      proto.initRecordNumHistory(recordNumHistory_.size());
-  for (UInt i = 0; i < recordNumHistory_.size(); i++) {
-    recordNumHistoryProto.set(i, recordNumHistory_[i]);
+  auto recordNumHistoryProto = proto.initRecordNumHistory(historySize_);
+  for (UInt i = 0; i < historySize_; i++) {
+    recordNumHistoryProto.set(i, historyEntry_(i).recordNum);
   }
 
   proto.setMaxBucketIdx(maxBucketIdx_);
   proto.setMaxInputIdx(maxInputIdx_);
-
-  auto weightMatrixProtos = proto.initWeightMatrix(weightMatrix_.size());
-  UInt k = 0;
-  for (const auto &stepWeightMatrix : weightMatrix_) {
-    auto stepWeightMatrixProto = weightMatrixProtos[k];
-    stepWeightMatrixProto.setSteps(stepWeightMatrix.first);
+  proto.setWeightPrecision(weightPrecision_ == WeightPrecision::REAL32
+                               ? SdrClassifierProto::WeightPrecision::REAL32
+                               : SdrClassifierProto::WeightPrecision::REAL64);
+
+  auto weightMatrixProtos = proto.initWeightMatrix(steps_.size());
+  for (UInt stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+    auto stepWeightMatrixProto = weightMatrixProtos[stepIdx];
+    stepWeightMatrixProto.setSteps(steps_[stepIdx]);
     auto weightProto = stepWeightMatrixProto.initWeight((maxInputIdx_ + 1) *
                                                         (maxBucketIdx_ + 1));
     // flatten weight matrix, serialized as a list of floats
     UInt idx = 0;
     for (UInt i = 0; i <= maxInputIdx_; ++i) {
       for (UInt j = 0; j <= maxBucketIdx_; ++j) {
-        weightProto.set(idx, stepWeightMatrix.second.at(i, j));
+        weightProto.set(idx, getWeight_(i, stepIdx, j));
         idx++;
       }
     }
-    k++;
   }
 
   auto actualValuesProto = proto.initActualValues(actualValues_.size());
@@ -457,11 +693,10 @@ void SDRClassifier::write(SdrClassifierProto::Builder &proto) const {
 void SDRClassifier::read(SdrClassifierProto::Reader &proto) {
   // Clean up the existing data structures before loading
   steps_.clear();
-  recordNumHistory_.clear();
-  patternNZHistory_.clear();
   actualValues_.clear();
   actualValuesSet_.clear();
-  weightMatrix_.clear();
+  weights_ = Matrix();
+  weights32_ = GrowableMatrix<Real32>();
 
   for (auto step : proto.getSteps()) {
     steps_.push_back(step);
@@ -471,33 +706,38 @@ void SDRClassifier::read(SdrClassifierProto::Reader &proto) {
   actValueAlpha_ = proto.getActValueAlpha();
   maxSteps_ = proto.getMaxSteps();
 
+  clearHistory_();
   auto patternNZHistoryProto = proto.getPatternNZHistory();
+  auto recordNumHistoryProto = proto.getRecordNumHistory();
+  NTA_CHECK(patternNZHistoryProto.size() == recordNumHistoryProto.size());
+  vector<UInt> pattern;
   for (UInt i = 0; i < patternNZHistoryProto.size(); i++) {
-    patternNZHistory_.emplace_back(patternNZHistoryProto[i].size());
+    pattern.resize(patternNZHistoryProto[i].size());
     for (UInt j = 0; j < patternNZHistoryProto[i].size(); j++) {
-      patternNZHistory_[i][j] = patternNZHistoryProto[i][j];
+      pattern[j] = patternNZHistoryProto[i][j];
     }
-  }
-
-  auto recordNumHistoryProto = proto.getRecordNumHistory();
-  for (UInt i = 0; i < recordNumHistoryProto.size(); i++) {
-    recordNumHistory_.push_back(recordNumHistoryProto[i]);
+    pushHistory_(recordNumHistoryProto[i], pattern);
   }
 
   maxBucketIdx_ = proto.getMaxBucketIdx();
   maxInputIdx_ = proto.getMaxInputIdx();
 
+  weightPrecision_ =
+      proto.getWeightPrecision() == SdrClassifierProto::WeightPrecision::REAL32
+          ? WeightPrecision::REAL32
+          : WeightPrecision::REAL64;
+  resizeWeights_();
   auto weightMatrixProto = proto.getWeightMatrix();
   for (UInt i = 0; i < weightMatrixProto.size(); ++i) {
     auto stepWeightMatrix = weightMatrixProto[i];
-    UInt steps = stepWeightMatrix.getSteps();
-    weightMatrix_[steps] = Matrix(maxInputIdx_ + 1, maxBucketIdx_ + 1);
+    const UInt stepIdx = stepIndex_(stepWeightMatrix.getSteps());
+    NTA_CHECK(stepIdx < steps_.size());
     auto weights = stepWeightMatrix.getWeight();
     UInt j = 0;
     // un-flatten weight matrix, serialized as a list of floats
     for (UInt row = 0; row <= maxInputIdx_; ++row) {
       for (UInt col = 0; col <= maxBucketIdx_; ++col) {
-        weightMatrix_[steps].at(row, col) = weights[j];
+        setWeight_(row, stepIdx, col, weights[j]);
         j++;
       }
     }
@@ -513,6 +753,12 @@ void SDRClassifier::read(SdrClassifierProto::Reader &proto) {
 
   version_ = proto.getVersion();
   verbosity_ = proto.getVerbosity();
+
+  // Recompute the activations of the history.
+  for (UInt i = 0; i < historySize_; ++i) {
+    HistoryEntry &entry = historyEntry_(i);
+    computeActivations_(entry.patternNZ, entry.activations);
+  }
 }
 
 bool SDRClassifier::operator==(const SDRClassifier &other) const {
@@ -531,27 +777,14 @@ bool SDRClassifier::operator==(const SDRClassifier &other) const {
     return false;
   }
 
-  if (patternNZHistory_.size() != other.patternNZHistory_.size()) {
+  if (historySize_ != other.historySize_) {
     return false;
   }
-  for (UInt i = 0; i < patternNZHistory_.size(); i++) {
-    if (patternNZHistory_.at(i).size() !=
-        other.patternNZHistory_.at(i).size()) {
-      return false;
-    }
-    for (UInt j = 0; j < patternNZHistory_.at(i).size(); j++) {
-      if (patternNZHistory_.at(i).at(j) !=
-          other.patternNZHistory_.at(i).at(j)) {
-        return false;
-      }
-    }
-  }
-
-  if (recordNumHistory_.size() != other.recordNumHistory_.size()) {
-    return false;
-  }
-  for (UInt i = 0; i < recordNumHistory_.size(); i++) {
-    if (recordNumHistory_.at(i) != other.recordNumHistory_.at(i)) {
+  for (UInt i = 0; i < historySize_; i++) {
+    const HistoryEntry &entry = historyEntry_(i);
+    const HistoryEntry &otherEntry = other.historyEntry_(i);
+    if (entry.recordNum != otherEntry.recordNum ||
+        entry.patternNZ != otherEntry.patternNZ) {
       return false;
     }
   }
@@ -564,15 +797,14 @@ bool SDRClassifier::operator==(const SDRClassifier &other) const {
     return false;
   }
 
-  if (weightMatrix_.size() != other.weightMatrix_.size()) {
+  if (weightPrecision_ != other.weightPrecision_) {
     return false;
   }
-  for (auto it = weightMatrix_.begin(); it != weightMatrix_.end(); it++) {
-    Matrix thisWeights = it->second;
-    Matrix otherWeights = other.weightMatrix_.at(it->first);
+
+  for (UInt stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
     for (UInt i = 0; i <= maxInputIdx_; ++i) {
       for (UInt j = 0; j <= maxBucketIdx_; ++j) {
-        if (thisWeights.at(i, j) != otherWeights.at(i, j)) {
+        if (getWeight_(i, stepIdx, j) != other.getWeight_(i, stepIdx, j)) {
           return false;
         }
       }
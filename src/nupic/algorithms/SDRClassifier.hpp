@@ -27,14 +27,13 @@
 #ifndef NTA_SDR_CLASSIFIER_HPP
 #define NTA_SDR_CLASSIFIER_HPP
 
-#include <deque>
 #include <iostream>
 #include <map>
 #include <string>
 #include <vector>
 
 #include <nupic/algorithms/ClassifierResult.hpp>
-#include <nupic/math/DenseMatrix.hpp>
+#include <nupic/math/GrowableMatrix.hpp>
 #include <nupic/proto/SdrClassifier.capnp.h>
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Types.hpp>
@@ -48,17 +47,37 @@ namespace sdr_classifier {
 
 const UInt sdrClassifierVersion = 1;
 
-typedef Dense<UInt, Real64> Matrix;
+typedef GrowableMatrix<Real64> Matrix;
 
 class SDRClassifier : public Serializable<SdrClassifierProto> {
   // Make test class friend so it can unit test private members directly
   friend class SDRClassifierTest;
 
 public:
+  /**
+   * How the weights are stored. REAL32 halves their memory and the
+   * bandwidth used by learning and inference. Activations and likelihoods
+   * are computed in double precision either way.
+   */
+  enum class WeightPrecision { REAL64, REAL32 };
+
+  /**
+   * One of the most likely buckets for a prediction step.
+   */
+  struct BucketPrediction {
+    UInt bucketIdx;
+    Real64 likelihood;
+    // The value used when predicting the bucket, see the actual values of
+    // compute's result.
+    Real64 actualValue;
+  };
+
   /**
    * Constructor for use when deserializing.
    */
-  SDRClassifier() {}
+  SDRClassifier()
+      : historyBegin_(0), historySize_(0),
+        weightPrecision_(WeightPrecision::REAL64) {}
 
   /**
    * Constructor.
@@ -68,9 +87,11 @@ public:
    * @param actValueAlpha The alpha to use when decaying the actual
    *                      values for each bucket.
    * @param verbosity The logging verbosity.
+   * @param weightPrecision How to store the weights.
    */
   SDRClassifier(const vector<UInt> &steps, Real64 alpha, Real64 actValueAlpha,
-                UInt verbosity);
+                UInt verbosity,
+                WeightPrecision weightPrecision = WeightPrecision::REAL64);
 
   /**
    * Destructor.
@@ -99,6 +120,24 @@ public:
                        const vector<Real64> &actValueList, bool category,
                        bool learn, bool infer, ClassifierResult *result);
 
+  /**
+   * Same as compute with inference, but only returns the topK most likely
+   * buckets of each prediction step instead of the likelihoods of all the
+   * buckets. Nothing is allocated once predictions has grown to its final
+   * size, which makes this the cheaper choice when there are many buckets.
+   *
+   * @param topK The maximum number of buckets to return for each step.
+   * @param predictions Receives one vector per prediction step, in the
+   *                    order of the sorted steps, each sorted from the
+   *                    most to the least likely bucket. Ties go to the
+   *                    lowest bucket index. The likelihoods are the same
+   *                    as the ones computed by compute.
+   */
+  void compute(UInt recordNum, const vector<UInt> &patternNZ,
+               const vector<UInt> &bucketIdxList,
+               const vector<Real64> &actValueList, bool category, bool learn,
+               UInt topK, vector<vector<BucketPrediction>> &predictions);
+
   /**
    * Gets the version number
    */
@@ -115,6 +154,11 @@ public:
    */
   UInt getAlpha() const;
 
+  /**
+   * Gets how the weights are stored.
+   */
+  WeightPrecision getWeightPrecision() const;
+
   /**
    * Get the size of the string needed for the serialized state.
    */
@@ -159,13 +203,101 @@ public:
   virtual bool operator==(const SDRClassifier &other) const;
 
 private:
-  // Helper function for inference mode
-  void infer_(const vector<UInt> &patternNZ, const vector<Real64> &actValue,
+  // An input pattern of the history together with its activations: the sums
+  // of the weights of its active bits, with one row per prediction step and
+  // one column per bucket. The softmax of a row is the distribution that the
+  // classifier predicts for that step. The activations are computed once,
+  // when the pattern arrives, and are then kept up to date while the
+  // weights learn, so learning never recomputes them.
+  struct HistoryEntry {
+    UInt recordNum;
+    vector<UInt> patternNZ;
+    Matrix activations;
+  };
+
+  // Checks the record number, grows the weights for new input bits, and
+  // appends patternNZ to the history if recordNum is a new record. Returns
+  // the activations of patternNZ. A new record always gets its activations,
+  // since learning needs them, but those of a repeated record are only
+  // computed when infer is true, and are stale otherwise.
+  const Matrix &addRecord_(UInt recordNum, const vector<UInt> &patternNZ,
+                           bool infer);
+
+  // Helper function for learning mode
+  void learn_(UInt recordNum, const vector<UInt> &bucketIdxList,
+              const vector<Real64> &actValueList, bool category);
+
+  // Helper function for inference mode, from the activations of the input
+  // pattern.
+  void infer_(const Matrix &activations, const vector<Real64> &actValue,
               ClassifierResult *result);
 
-  // Helper function to compute the error signal in learning mode
+  // Same as infer_, keeping only the topK most likely buckets of each step.
+  void inferTopK_(const Matrix &activations, const vector<Real64> &actValue,
+                  UInt topK, vector<vector<BucketPrediction>> &predictions);
+
+  // The value returned as the actual value of a bucket by inference.
+  Real64 actualValue_(UInt bucketIdx, const vector<Real64> &actValue) const;
+
+  // Helper function to compute the error signal in learning mode, from the
+  // activations of the pattern for one prediction step.
   vector<Real64> calculateError_(const vector<UInt> &bucketIdxList,
-                                 const vector<UInt> patternNZ, UInt step);
+                                 const Real64 *activations);
+
+  // Fused rank-1 update of the weights of the active bits of patternNZ for
+  // prediction step steps_[stepIdx], which also moves the activations of
+  // the history by the same amount. Weights within nupic::Epsilon of 0 are
+  // zeroed.
+  void updateWeights_(const vector<UInt> &patternNZ, UInt stepIdx,
+                      const vector<Real64> &error);
+
+  // Sums the weights of the active bits into activations.
+  void computeActivations_(const vector<UInt> &patternNZ,
+                           Matrix &activations) const;
+
+  // Index of a prediction step in steps_, or steps_.size() if the
+  // classifier doesn't predict that step.
+  UInt stepIndex_(UInt step) const;
+
+  // The weights of input bit bit for prediction step steps_[stepIdx], when
+  // the weights are stored as Real64.
+  inline Real64 *weightsRow_(UInt bit, UInt stepIdx) {
+    return weights_.row(bit * steps_.size() + stepIdx);
+  }
+  inline const Real64 *weightsRow_(UInt bit, UInt stepIdx) const {
+    return weights_.row(bit * steps_.size() + stepIdx);
+  }
+
+  // Same as weightsRow_, when the weights are stored as Real32.
+  inline Real32 *weights32Row_(UInt bit, UInt stepIdx) {
+    return weights32_.row(bit * steps_.size() + stepIdx);
+  }
+  inline const Real32 *weights32Row_(UInt bit, UInt stepIdx) const {
+    return weights32_.row(bit * steps_.size() + stepIdx);
+  }
+
+  // A single weight, whatever the precision of the weights.
+  Real64 getWeight_(UInt bit, UInt stepIdx, UInt bucketIdx) const;
+  void setWeight_(UInt bit, UInt stepIdx, UInt bucketIdx, Real64 weight);
+
+  // The i-th oldest entry of the history.
+  inline HistoryEntry &historyEntry_(UInt i) {
+    return history_[(historyBegin_ + i) % history_.size()];
+  }
+  inline const HistoryEntry &historyEntry_(UInt i) const {
+    return history_[(historyBegin_ + i) % history_.size()];
+  }
+
+  // Appends a pattern to the history, dropping the oldest one when the
+  // history is full. The activations of the new entry are not computed.
+  HistoryEntry &pushHistory_(UInt recordNum, const vector<UInt> &patternNZ);
+
+  // Empties the history and makes room for maxSteps_ entries.
+  void clearHistory_();
+
+  // Resize the weights to maxInputIdx_ + 1 input bits and maxBucketIdx_ + 1
+  // buckets, along with the activations of the history.
+  void resizeWeights_();
 
   // softmax function
   void softmax_(vector<Real64>::iterator begin, vector<Real64>::iterator end);
@@ -183,12 +315,29 @@ private:
   UInt maxSteps_;
 
   // Stores the input pattern history, starting with the previous input
-  // and containing _maxSteps total input patterns.
-  deque<vector<UInt>> patternNZHistory_;
-  deque<UInt> recordNumHistory_;
-
-  // Weight matrices for the classifier (one per prediction step)
-  map<UInt, Matrix> weightMatrix_;
+  // and containing _maxSteps total input patterns. This is a ring buffer of
+  // maxSteps_ entries, the oldest one at historyBegin_. Entries are reused,
+  // so their vectors keep their capacity from one record to the next.
+  vector<HistoryEntry> history_;
+  UInt historyBegin_;
+  UInt historySize_;
+
+  // Scratch space for updateWeights_: how many times each input bit is
+  // active in the pattern being learned. All 0 between calls.
+  vector<UInt> bitCounts_;
+
+  // Weights of the classifier, one column per bucket. Input bit i has one
+  // row for each prediction step, rows i * steps_.size() to
+  // (i + 1) * steps_.size() - 1, so a single walk over the active bits
+  // accumulates the likelihoods of all steps. The matrix grows
+  // geometrically as new input bits and buckets are seen. Only one of
+  // weights_ and weights32_ is used, depending on weightPrecision_.
+  Matrix weights_;
+  GrowableMatrix<Real32> weights32_;
+  WeightPrecision weightPrecision_;
+
+  // The activations of an input pattern that isn't added to the history.
+  Matrix activations_;
 
   // The highest input bit that the classifier has seen so far.
   UInt maxInputIdx_;
@@ -24,11 +24,16 @@
  * Implementation of SpatialPooler
  */
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <capnp/any.h>
+
 #include <nupic/algorithms/SpatialPooler.hpp>
 #include <nupic/math/Math.hpp>
 #include <nupic/math/Topology.hpp>
@@ -41,6 +46,18 @@ using namespace nupic::math::topology;
 
 static const Real PERMANENCE_EPSILON = 0.000001;
 
+// With the AUTO backend, connected synapses are bit-packed when on average
+// there is at least one of them per 64 bit word of a packed row. Below that
+// the sparse indices touch less memory than the packed rows.
+static const Real PACKED_CONNECTED_DENSITY = 1.0 / 64;
+
+// AUTO never chooses a packed copy larger than this, whatever the density.
+static const UInt64 PACKED_CONNECTED_MAX_BYTES = 64 << 20;
+
+// Number of records of a batch whose overlaps are computed in a single pass
+// over the connected synapses.
+static const UInt BATCH_BLOCK_SIZE = 16;
+
 // MSVC doesn't provide round() which only became standard in C99 or C++11
 #if defined(NTA_COMPILER_MSVC)
 template <typename T> T round(T num) {
@@ -56,6 +73,27 @@ static Real round5_(const Real f) {
   return p;
 }
 
+// Copies a list of primitives from a message into a vector, with a single
+// allocation. A list of the vector's own element type is copied as one
+// block when the host has the little-endian byte order of the message.
+template <typename T, typename ListReader>
+static void copyList_(ListReader list, vector<T> &vec) {
+  vec.resize(list.size());
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (std::is_same<ListReader, typename capnp::List<T>::Reader>::value) {
+    const kj::ArrayPtr<const capnp::byte> bytes =
+        capnp::AnyList::Reader(list).getRawBytes();
+    if (bytes.size() == vec.size() * sizeof(T)) {
+      if (!vec.empty())
+        ::memcpy(vec.data(), bytes.begin(), bytes.size());
+      return;
+    }
+  }
+#endif
+  for (UInt i = 0; i < list.size(); ++i)
+    vec[i] = list[i];
+}
+
 class CoordinateConverter2D {
 
 public:
@@ -105,6 +143,9 @@ private:
 SpatialPooler::SpatialPooler() {
   // The current version number.
   version_ = 2;
+  connectedBackend_ = ConnectedBackend::SPARSE;
+  permanenceBackend_ = PermanenceBackend::REAL;
+  quantized_ = QuantizedParameters();
 }
 
 SpatialPooler::SpatialPooler(
@@ -113,13 +154,16 @@ SpatialPooler::SpatialPooler(
     Real localAreaDensity, UInt numActiveColumnsPerInhArea,
     UInt stimulusThreshold, Real synPermInactiveDec, Real synPermActiveInc,
     Real synPermConnected, Real minPctOverlapDutyCycles, UInt dutyCyclePeriod,
-    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround)
+    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround,
+    ConnectedBackend connectedBackend, UInt initThreads,
+    PermanenceBackend permanenceBackend)
     : SpatialPooler::SpatialPooler() {
   initialize(inputDimensions, columnDimensions, potentialRadius, potentialPct,
              globalInhibition, localAreaDensity, numActiveColumnsPerInhArea,
              stimulusThreshold, synPermInactiveDec, synPermActiveInc,
              synPermConnected, minPctOverlapDutyCycles, dutyCyclePeriod,
-             boostStrength, seed, spVerbosity, wrapAround);
+             boostStrength, seed, spVerbosity, wrapAround, connectedBackend,
+             initThreads, permanenceBackend);
 }
 
 vector<UInt> SpatialPooler::getColumnDimensions() const {
@@ -229,12 +273,18 @@ Real SpatialPooler::getSynPermTrimThreshold() const {
 
 void SpatialPooler::setSynPermTrimThreshold(Real synPermTrimThreshold) {
   synPermTrimThreshold_ = synPermTrimThreshold;
+  if (permanenceBackend_ != PermanenceBackend::REAL) {
+    updateQuantizedParameters_();
+  }
 }
 
 Real SpatialPooler::getSynPermActiveInc() const { return synPermActiveInc_; }
 
 void SpatialPooler::setSynPermActiveInc(Real synPermActiveInc) {
   synPermActiveInc_ = synPermActiveInc;
+  if (permanenceBackend_ != PermanenceBackend::REAL) {
+    updateQuantizedParameters_();
+  }
 }
 
 Real SpatialPooler::getSynPermInactiveDec() const {
@@ -243,6 +293,9 @@ Real SpatialPooler::getSynPermInactiveDec() const {
 
 void SpatialPooler::setSynPermInactiveDec(Real synPermInactiveDec) {
   synPermInactiveDec_ = synPermInactiveDec;
+  if (permanenceBackend_ != PermanenceBackend::REAL) {
+    updateQuantizedParameters_();
+  }
 }
 
 Real SpatialPooler::getSynPermBelowStimulusInc() const {
@@ -251,17 +304,29 @@ Real SpatialPooler::getSynPermBelowStimulusInc() const {
 
 void SpatialPooler::setSynPermBelowStimulusInc(Real synPermBelowStimulusInc) {
   synPermBelowStimulusInc_ = synPermBelowStimulusInc;
+  if (permanenceBackend_ != PermanenceBackend::REAL) {
+    updateQuantizedParameters_();
+  }
 }
 
 Real SpatialPooler::getSynPermConnected() const { return synPermConnected_; }
 
 void SpatialPooler::setSynPermConnected(Real synPermConnected) {
   synPermConnected_ = synPermConnected;
+  if (permanenceBackend_ != PermanenceBackend::REAL) {
+    updateQuantizedParameters_();
+  }
 }
 
 Real SpatialPooler::getSynPermMax() const { return synPermMax_; }
 
-void SpatialPooler::setSynPermMax(Real synPermMax) { synPermMax_ = synPermMax; }
+void SpatialPooler::setSynPermMax(Real synPermMax) {
+  // The fixed-point steps are relative to synPermMax_.
+  const PermanenceBackend permanenceBackend = permanenceBackend_;
+  setPermanenceBackend(PermanenceBackend::REAL);
+  synPermMax_ = synPermMax;
+  setPermanenceBackend(permanenceBackend);
+}
 
 Real SpatialPooler::getMinPctOverlapDutyCycles() const {
   return minPctOverlapDutyCycles_;
@@ -314,12 +379,27 @@ void SpatialPooler::getPotential(UInt column, UInt potential[]) const {
 
 void SpatialPooler::setPotential(UInt column, UInt potential[]) {
   NTA_ASSERT(column < numColumns_);
+  if (permanenceBackend_ == PermanenceBackend::REAL) {
+    potentialPools_.rowFromDense(column, &potential[0], &potential[numInputs_]);
+    return;
+  }
+
+  // Fixed-point permanences are stored along the potential pool.
+  vector<Real> perm(numInputs_);
+  getPermanence(column, perm.data());
   potentialPools_.rowFromDense(column, &potential[0], &potential[numInputs_]);
+  updatePermanencesForColumn_(perm, column, false);
 }
 
 void SpatialPooler::getPermanence(UInt column, Real permanences[]) const {
   NTA_ASSERT(column < numColumns_);
-  permanences_.getRowToDense(column, permanences);
+  if (permanenceBackend_ == PermanenceBackend::UINT16) {
+    getQuantizedPermanence_(permanences16_, column, permanences);
+  } else if (permanenceBackend_ == PermanenceBackend::UINT8) {
+    getQuantizedPermanence_(permanences8_, column, permanences);
+  } else {
+    permanences_.getRowToDense(column, permanences);
+  }
 }
 
 void SpatialPooler::setPermanence(UInt column, Real permanences[]) {
@@ -340,6 +420,89 @@ void SpatialPooler::getConnectedCounts(UInt connectedCounts[]) const {
   copy(connectedCounts_.begin(), connectedCounts_.end(), connectedCounts);
 }
 
+ConnectedBackend SpatialPooler::getConnectedBackend() const {
+  return connectedBackend_;
+}
+
+void SpatialPooler::setConnectedBackend(ConnectedBackend connectedBackend) {
+  if (connectedBackend == ConnectedBackend::AUTO) {
+    UInt64 numConnected = 0;
+    for (UInt count : connectedCounts_) {
+      numConnected += count;
+    }
+    const Real density = (Real)numConnected / numColumns_ / numInputs_;
+    const UInt64 packedBytes = (UInt64)numColumns_ *
+                               PackedBinaryMatrix::nWords(numInputs_) *
+                               sizeof(UInt64);
+    connectedBackend = density >= PACKED_CONNECTED_DENSITY &&
+                               packedBytes <= PACKED_CONNECTED_MAX_BYTES
+                           ? ConnectedBackend::PACKED
+                           : ConnectedBackend::SPARSE;
+  }
+
+  connectedBackend_ = connectedBackend;
+  if (connectedBackend_ == ConnectedBackend::PACKED) {
+    packedConnectedSynapses_.resize(numColumns_, numInputs_);
+    for (UInt i = 0; i < numColumns_; i++) {
+      const auto &connected = connectedSynapses_.getSparseRow(i);
+      packedConnectedSynapses_.replaceSparseRow(i, connected.begin(),
+                                                connected.end());
+    }
+  } else {
+    packedConnectedSynapses_.resize(0, 0);
+  }
+}
+
+PermanenceBackend SpatialPooler::getPermanenceBackend() const {
+  return permanenceBackend_;
+}
+
+void SpatialPooler::setPermanenceBackend(PermanenceBackend permanenceBackend) {
+  if (permanenceBackend == permanenceBackend_) {
+    return;
+  }
+
+  vector<Real> perm(numInputs_);
+  if (permanenceBackend_ != PermanenceBackend::REAL) {
+    // Always go through REAL values, the fixed-point backends have
+    // different steps.
+    permanences_.resize(numColumns_, numInputs_);
+    for (UInt i = 0; i < numColumns_; i++) {
+      getPermanence(i, perm.data());
+      permanences_.setRowFromDense(i, perm);
+    }
+    permanenceBackend_ = PermanenceBackend::REAL;
+    vector<vector<UInt16>>().swap(permanences16_);
+    vector<vector<UInt8>>().swap(permanences8_);
+
+    if (permanenceBackend == PermanenceBackend::REAL) {
+      // Recompute the connected synapses from the REAL values.
+      for (UInt i = 0; i < numColumns_; i++) {
+        permanences_.getRowToDense(i, perm);
+        updatePermanencesForColumn_(perm, i, false);
+      }
+      return;
+    }
+  }
+
+  permanenceBackend_ = permanenceBackend;
+  updateQuantizedParameters_();
+  if (permanenceBackend_ == PermanenceBackend::UINT16) {
+    permanences16_.resize(numColumns_);
+  } else {
+    permanences8_.resize(numColumns_);
+  }
+  for (UInt i = 0; i < numColumns_; i++) {
+    permanences_.getRowToDense(i, perm);
+    if (permanenceBackend_ == PermanenceBackend::UINT16) {
+      setQuantizedPermanence_(permanences16_, i, perm, false);
+    } else {
+      setQuantizedPermanence_(permanences8_, i, perm, false);
+    }
+  }
+  permanences_ = SparseMatrix<UInt, Real, Int, Real64>(numColumns_, numInputs_);
+}
+
 const vector<UInt> &SpatialPooler::getOverlaps() const { return overlaps_; }
 
 const vector<Real> &SpatialPooler::getBoostedOverlaps() const {
@@ -352,7 +515,9 @@ void SpatialPooler::initialize(
     Real localAreaDensity, UInt numActiveColumnsPerInhArea,
     UInt stimulusThreshold, Real synPermInactiveDec, Real synPermActiveInc,
     Real synPermConnected, Real minPctOverlapDutyCycles, UInt dutyCyclePeriod,
-    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround) {
+    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround,
+    ConnectedBackend connectedBackend, UInt initThreads,
+    PermanenceBackend permanenceBackend) {
 
   numInputs_ = 1;
   inputDimensions_.clear();
@@ -422,12 +587,22 @@ void SpatialPooler::initialize(
 
   inhibitionRadius_ = 0;
 
-  for (UInt i = 0; i < numColumns_; ++i) {
-    vector<UInt> potential = mapPotential_(i, wrapAround_);
-    vector<Real> perm = initPermanence_(potential, initConnectedPct_);
-    potentialPools_.rowFromDense(i, potential.begin(), potential.end());
-    updatePermanencesForColumn_(perm, i, true);
+  connectedBackend_ = ConnectedBackend::SPARSE;
+  permanenceBackend_ = PermanenceBackend::REAL;
+  vector<vector<UInt16>>().swap(permanences16_);
+  vector<vector<UInt8>>().swap(permanences8_);
+  if (initThreads > 0) {
+    initializeColumnsFast_(rng_.getUInt64(), initThreads);
+  } else {
+    for (UInt i = 0; i < numColumns_; ++i) {
+      vector<UInt> potential = mapPotential_(i, wrapAround_);
+      vector<Real> perm = initPermanence_(potential, initConnectedPct_);
+      potentialPools_.rowFromDense(i, potential.begin(), potential.end());
+      updatePermanencesForColumn_(perm, i, true);
+    }
   }
+  setConnectedBackend(connectedBackend);
+  setPermanenceBackend(permanenceBackend);
 
   updateInhibitionRadius_();
 
@@ -440,6 +615,191 @@ void SpatialPooler::initialize(
 void SpatialPooler::compute(UInt inputArray[], bool learn, UInt activeArray[]) {
   updateBookeepingVars_(learn);
   calculateOverlap_(inputArray, overlaps_);
+  computeActiveColumns_(inputArray, learn, activeArray);
+}
+
+void SpatialPooler::computePacked(const UInt64 packedInput[], bool learn,
+                                  UInt activeArray[]) {
+  updateBookeepingVars_(learn);
+
+  // Learning needs the dense input, and so does the SPARSE overlap.
+  UInt *inputArray = nullptr;
+  if (learn || connectedBackend_ != ConnectedBackend::PACKED) {
+    denseInput_.resize(numInputs_);
+    PackedBinaryMatrix::unpack(packedInput, numInputs_, denseInput_.data());
+    inputArray = denseInput_.data();
+  }
+
+  if (connectedBackend_ == ConnectedBackend::PACKED) {
+    calculateOverlapPacked_(packedInput, overlaps_);
+  } else {
+    calculateOverlap_(inputArray, overlaps_);
+  }
+  computeActiveColumns_(inputArray, learn, activeArray);
+}
+
+void SpatialPooler::computeBatch(const UInt inputVectors[], UInt batchSize,
+                                 UInt activeVectors[], UInt numThreads) {
+  computeBatch_(inputVectors, nullptr, nullptr, batchSize, activeVectors,
+                numThreads);
+}
+
+void SpatialPooler::computeBatchSparse(const UInt inputIndices[],
+                                       const UInt inputOffsets[],
+                                       UInt batchSize, UInt activeVectors[],
+                                       UInt numThreads) {
+  computeBatch_(nullptr, inputIndices, inputOffsets, batchSize, activeVectors,
+                numThreads);
+}
+
+void SpatialPooler::computeBatch_(const UInt inputVectors[],
+                                  const UInt inputIndices[],
+                                  const UInt inputOffsets[], UInt batchSize,
+                                  UInt activeVectors[], UInt numThreads) {
+  if (batchSize == 0) {
+    return;
+  }
+
+  // Give every thread at least one block.
+  const UInt numBlocks = (batchSize + BATCH_BLOCK_SIZE - 1) / BATCH_BLOCK_SIZE;
+  numThreads = max((UInt)1, min(numThreads, numBlocks));
+  const UInt blocksPerThread = (numBlocks + numThreads - 1) / numThreads;
+
+  vector<UInt> lastOverlaps(numColumns_);
+  vector<std::thread> threads;
+  for (UInt t = 0; t < numThreads; t++) {
+    const UInt begin = min(batchSize, t * blocksPerThread * BATCH_BLOCK_SIZE);
+    const UInt end = min(batchSize, begin + blocksPerThread * BATCH_BLOCK_SIZE);
+    if (t == numThreads - 1) {
+      // Run the last range on this thread.
+      computeBatchRange_(inputVectors, inputIndices, inputOffsets, begin, end,
+                         batchSize, activeVectors, lastOverlaps);
+    } else {
+      threads.emplace_back(&SpatialPooler::computeBatchRange_, this,
+                           inputVectors, inputIndices, inputOffsets, begin,
+                           end, batchSize, activeVectors,
+                           std::ref(lastOverlaps));
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Leave the same state behind as batchSize calls to compute would.
+  iterationNum_ += batchSize;
+  overlaps_ = lastOverlaps;
+  calculateOverlapPct_(overlaps_, overlapsPct_);
+  boostedOverlaps_.assign(overlaps_.begin(), overlaps_.end());
+}
+
+void SpatialPooler::computeBatchRange_(const UInt inputVectors[],
+                                       const UInt inputIndices[],
+                                       const UInt inputOffsets[], UInt begin,
+                                       UInt end, UInt batchSize,
+                                       UInt activeVectors[],
+                                       vector<UInt> &lastOverlaps) {
+  const bool packed = connectedBackend_ == ConnectedBackend::PACKED;
+  const UInt numWords = PackedBinaryMatrix::nWords(numInputs_);
+
+  // With the SPARSE backend the block of inputs is transposed, so that the
+  // BATCH_BLOCK_SIZE values of one input bit are contiguous. With the PACKED
+  // backend each input is packed separately.
+  vector<Byte> inputBlock;
+  vector<UInt64> packedBlock;
+  if (packed) {
+    packedBlock.resize((size_t)BATCH_BLOCK_SIZE * numWords);
+  } else {
+    inputBlock.resize((size_t)numInputs_ * BATCH_BLOCK_SIZE);
+  }
+
+  vector<UInt> overlaps((size_t)BATCH_BLOCK_SIZE * numColumns_);
+  vector<Real> boostedOverlaps(numColumns_);
+  vector<UInt> activeColumns;
+
+  for (UInt blockBegin = begin; blockBegin < end;
+       blockBegin += BATCH_BLOCK_SIZE) {
+    const UInt blockSize = min(BATCH_BLOCK_SIZE, end - blockBegin);
+
+    for (UInt k = 0; k < blockSize; k++) {
+      const UInt record = blockBegin + k;
+      if (packed) {
+        UInt64 *words = &packedBlock[(size_t)k * numWords];
+        if (inputVectors != nullptr) {
+          PackedBinaryMatrix::pack(inputVectors + (size_t)record * numInputs_,
+                                   numInputs_, words);
+        } else {
+          std::fill(words, words + numWords, 0);
+          for (UInt j = inputOffsets[record]; j < inputOffsets[record + 1];
+               j++) {
+            const UInt input = inputIndices[j];
+            NTA_ASSERT(input < numInputs_);
+            words[input / 64] |= (UInt64)1 << (input % 64);
+          }
+        }
+      } else {
+        if (inputVectors != nullptr) {
+          const UInt *input = inputVectors + (size_t)record * numInputs_;
+          for (UInt i = 0; i < numInputs_; i++) {
+            inputBlock[(size_t)i * BATCH_BLOCK_SIZE + k] = input[i] != 0;
+          }
+        } else {
+          for (UInt j = inputOffsets[record]; j < inputOffsets[record + 1];
+               j++) {
+            NTA_ASSERT(inputIndices[j] < numInputs_);
+            inputBlock[(size_t)inputIndices[j] * BATCH_BLOCK_SIZE + k] = 1;
+          }
+        }
+      }
+    }
+
+    if (packed) {
+      packedConnectedSynapses_.rightVecSumAtNZPacked(
+          packedBlock.data(), blockSize, overlaps.begin());
+    } else {
+      UInt counts[BATCH_BLOCK_SIZE];
+      for (UInt column = 0; column < numColumns_; column++) {
+        std::fill(counts, counts + BATCH_BLOCK_SIZE, 0);
+        for (UInt input : connectedSynapses_.getSparseRow(column)) {
+          const Byte *values = &inputBlock[(size_t)input * BATCH_BLOCK_SIZE];
+          for (UInt k = 0; k < BATCH_BLOCK_SIZE; k++) {
+            counts[k] += values[k];
+          }
+        }
+        for (UInt k = 0; k < blockSize; k++) {
+          overlaps[(size_t)k * numColumns_ + column] = counts[k];
+        }
+      }
+
+      // Reset the block for the next records.
+      if (inputVectors != nullptr) {
+        std::fill(inputBlock.begin(), inputBlock.end(), 0);
+      } else {
+        for (UInt j = inputOffsets[blockBegin];
+             j < inputOffsets[blockBegin + blockSize]; j++) {
+          std::fill_n(&inputBlock[(size_t)inputIndices[j] * BATCH_BLOCK_SIZE],
+                 BATCH_BLOCK_SIZE, 0);
+        }
+      }
+    }
+
+    // Without learning there is no boosting, see compute.
+    for (UInt k = 0; k < blockSize; k++) {
+      const UInt record = blockBegin + k;
+      auto recordOverlaps = overlaps.begin() + (size_t)k * numColumns_;
+      boostedOverlaps.assign(recordOverlaps, recordOverlaps + numColumns_);
+      inhibitColumns_(boostedOverlaps, activeColumns);
+      toDense_(activeColumns, activeVectors + (size_t)record * numColumns_,
+               numColumns_);
+
+      if (record == batchSize - 1) {
+        lastOverlaps.assign(recordOverlaps, recordOverlaps + numColumns_);
+      }
+    }
+  }
+}
+
+void SpatialPooler::computeActiveColumns_(UInt inputArray[], bool learn,
+                                          UInt activeArray[]) {
   calculateOverlapPct_(overlaps_, overlapsPct_);
 
   if (learn) {
@@ -565,6 +925,138 @@ vector<Real> SpatialPooler::initPermanence_(vector<UInt> &potential,
   return perm;
 }
 
+void SpatialPooler::initializeColumnsFast_(UInt64 baseSeed, UInt numThreads) {
+  vector<vector<UInt>> potentials(numColumns_);
+  vector<vector<UInt>> permIndices(numColumns_);
+  vector<vector<Real>> perms(numColumns_);
+  vector<vector<UInt>> connected(numColumns_);
+
+  auto initializeColumns = [&](UInt begin, UInt end) {
+    vector<UInt> columnInputs;
+    for (UInt column = begin; column < end; column++) {
+      // A splitmix64 step, so that neighboring columns get unrelated seeds.
+      // Random treats a seed of 0 as "seed from the clock", avoid it.
+      UInt64 z = baseSeed + (column + 1) * 0x9E3779B97F4A7C15ULL;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      z ^= z >> 31;
+      Random rng(z % Random::MAX32 == 0 ? 1 : z);
+
+      const UInt centerInput = mapColumn_(column);
+      columnInputs.clear();
+      if (wrapAround_) {
+        for (UInt input : WrappingNeighborhood(centerInput, potentialRadius_,
+                                               inputDimensions_)) {
+          columnInputs.push_back(input);
+        }
+      } else {
+        for (UInt input :
+             Neighborhood(centerInput, potentialRadius_, inputDimensions_)) {
+          columnInputs.push_back(input);
+        }
+      }
+
+      const UInt numPotential = round(columnInputs.size() * potentialPct_);
+      vector<UInt> &potential = potentials[column];
+      potential.resize(numPotential);
+      if (numPotential > 0) {
+        rng.sample(&columnInputs.front(), columnInputs.size(),
+                   &potential.front(), numPotential);
+      }
+      // Wrapping neighborhoods are not visited in index order.
+      std::sort(potential.begin(), potential.end());
+
+      // Same as initPermanence_ followed by clip_, restricted to the
+      // potential pool.
+      vector<Real> &perm = perms[column];
+      perm.resize(numPotential);
+      for (UInt j = 0; j < numPotential; j++) {
+        Real p;
+        if (rng.getReal64() <= initConnectedPct_) {
+          p = round5_(synPermConnected_ +
+                      (synPermMax_ - synPermConnected_) * rng.getReal64());
+        } else {
+          p = round5_(synPermConnected_ * rng.getReal64());
+        }
+        p = p < synPermTrimThreshold_ ? 0 : p;
+        p = p > synPermMax_ ? synPermMax_ : p;
+        perm[j] = p < synPermMin_ ? synPermMin_ : p;
+      }
+
+      // Same as raisePermanencesToThreshold_.
+      UInt numConnected;
+      while (true) {
+        numConnected = 0;
+        for (Real p : perm) {
+          if (p >= synPermConnected_ - PERMANENCE_EPSILON) {
+            ++numConnected;
+          }
+        }
+        if (numConnected >= stimulusThreshold_ || numPotential == 0)
+          break;
+
+        for (Real &p : perm) {
+          p += synPermBelowStimulusInc_;
+        }
+      }
+
+      // Same as updatePermanencesForColumn_: record the connected synapses,
+      // then trim, keeping only the non-zeros.
+      vector<UInt> &connectedColumn = connected[column];
+      vector<UInt> &indices = permIndices[column];
+      connectedColumn.reserve(numConnected);
+      indices.reserve(numPotential);
+      UInt numNonZeros = 0;
+      for (UInt j = 0; j < numPotential; j++) {
+        Real p = perm[j];
+        if (p >= synPermConnected_ - PERMANENCE_EPSILON) {
+          connectedColumn.push_back(potential[j]);
+        }
+        p = p > synPermMax_ ? synPermMax_ : p;
+        p = p < synPermTrimThreshold_ ? synPermMin_ : p;
+        if (p != 0) {
+          indices.push_back(potential[j]);
+          perm[numNonZeros++] = p;
+        }
+      }
+      perm.resize(numNonZeros);
+    }
+  };
+
+  numThreads = max((UInt)1, min(numThreads, numColumns_));
+  const UInt columnsPerThread = (numColumns_ + numThreads - 1) / numThreads;
+  vector<std::thread> threads;
+  for (UInt t = 0; t < numThreads; t++) {
+    const UInt begin = min(numColumns_, t * columnsPerThread);
+    const UInt end = min(numColumns_, begin + columnsPerThread);
+    if (t == numThreads - 1) {
+      initializeColumns(begin, end);
+    } else {
+      threads.emplace_back(initializeColumns, begin, end);
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (UInt column = 0; column < numColumns_; column++) {
+    potentialPools_.replaceSparseRow(column, potentials[column].begin(),
+                                     potentials[column].end());
+    permanences_.setRowFromSparse(column, permIndices[column].begin(),
+                                  permIndices[column].end(),
+                                  perms[column].begin());
+    connectedSynapses_.replaceSparseRow(column, connected[column].begin(),
+                                        connected[column].end());
+    connectedCounts_[column] = connected[column].size();
+
+    // Release the column's memory as we go.
+    vector<UInt>().swap(potentials[column]);
+    vector<UInt>().swap(permIndices[column]);
+    vector<Real>().swap(perms[column]);
+    vector<UInt>().swap(connected[column]);
+  }
+}
+
 void SpatialPooler::clip_(vector<Real> &perm, bool trim = false) {
   Real minVal = trim ? synPermTrimThreshold_ : synPermMin_;
   for (auto &elem : perm) {
@@ -575,6 +1067,14 @@ void SpatialPooler::clip_(vector<Real> &perm, bool trim = false) {
 
 void SpatialPooler::updatePermanencesForColumn_(vector<Real> &perm, UInt column,
                                                 bool raisePerm) {
+  if (permanenceBackend_ == PermanenceBackend::UINT16) {
+    setQuantizedPermanence_(permanences16_, column, perm, raisePerm);
+    return;
+  } else if (permanenceBackend_ == PermanenceBackend::UINT8) {
+    setQuantizedPermanence_(permanences8_, column, perm, raisePerm);
+    return;
+  }
+
   vector<UInt> connectedSparse;
 
   UInt numConnected;
@@ -596,10 +1096,136 @@ void SpatialPooler::updatePermanencesForColumn_(vector<Real> &perm, UInt column,
   clip_(perm, true);
   connectedSynapses_.replaceSparseRow(column, connectedSparse.begin(),
                                       connectedSparse.end());
+  if (connectedBackend_ == ConnectedBackend::PACKED) {
+    packedConnectedSynapses_.replaceSparseRow(column, connectedSparse.begin(),
+                                              connectedSparse.end());
+  }
   permanences_.setRowFromDense(column, perm);
   connectedCounts_[column] = numConnected;
 }
 
+void SpatialPooler::updateQuantizedParameters_() {
+  QuantizedParameters &q = quantized_;
+  q.max = permanenceBackend_ == PermanenceBackend::UINT8 ? 255 : 65535;
+  q.step = synPermMax_ / q.max;
+
+  // Increments round to the nearest step, but are at least one step.
+  auto increment = [&q](Real value) {
+    return max((UInt)1, (UInt)round(value / q.step));
+  };
+  // Thresholds round up, so that a value is above a threshold in steps
+  // exactly when it is above it as a Real.
+  auto threshold = [&q](Real value) {
+    return min(q.max, (UInt)max((Real)0, ceil(value / q.step)));
+  };
+
+  q.activeInc = increment(synPermActiveInc_);
+  q.inactiveDec = increment(synPermInactiveDec_);
+  q.belowStimulusInc = increment(synPermBelowStimulusInc_);
+  q.connected = threshold(synPermConnected_ - PERMANENCE_EPSILON);
+  q.trimThreshold = threshold(synPermTrimThreshold_);
+}
+
+template <typename T>
+void SpatialPooler::getQuantizedPermanence_(const vector<vector<T>> &rows,
+                                            UInt column,
+                                            Real permanences[]) const {
+  std::fill(permanences, permanences + numInputs_, (Real)0);
+  const auto &potential = potentialPools_.getSparseRow(column);
+  const vector<T> &row = rows[column];
+  for (UInt j = 0; j < row.size(); j++) {
+    permanences[potential[j]] = row[j] * quantized_.step;
+  }
+}
+
+template <typename T>
+void SpatialPooler::setQuantizedPermanence_(vector<vector<T>> &rows,
+                                            UInt column,
+                                            const vector<Real> &perm,
+                                            bool raisePerm) {
+  const auto &potential = potentialPools_.getSparseRow(column);
+  vector<T> &row = rows[column];
+  row.resize(potential.size());
+  for (UInt j = 0; j < row.size(); j++) {
+    Real p = perm[potential[j]];
+    p = p > synPermMax_ ? synPermMax_ : p;
+    p = p < synPermMin_ ? synPermMin_ : p;
+    row[j] = (T)round(p / quantized_.step);
+  }
+  updateQuantizedColumn_(row, column, raisePerm);
+}
+
+template <typename T>
+void SpatialPooler::updateQuantizedColumn_(vector<T> &row, UInt column,
+                                           bool raisePerm) {
+  const QuantizedParameters &q = quantized_;
+  const auto &potential = potentialPools_.getSparseRow(column);
+
+  UInt numConnected = 0;
+  for (T value : row) {
+    numConnected += value >= q.connected;
+  }
+
+  if (raisePerm) {
+    // Values saturate at q.max, so stop once every synapse is connected.
+    while (numConnected < stimulusThreshold_ && numConnected < row.size()) {
+      numConnected = 0;
+      for (T &value : row) {
+        value = (T)min(q.max, value + q.belowStimulusInc);
+        numConnected += value >= q.connected;
+      }
+    }
+  }
+
+  vector<UInt> connectedSparse;
+  connectedSparse.reserve(numConnected);
+  for (UInt j = 0; j < row.size(); j++) {
+    if (row[j] >= q.connected) {
+      connectedSparse.push_back(potential[j]);
+    } else if (row[j] < q.trimThreshold) {
+      row[j] = 0;
+    }
+  }
+
+  connectedSynapses_.replaceSparseRow(column, connectedSparse.begin(),
+                                      connectedSparse.end());
+  if (connectedBackend_ == ConnectedBackend::PACKED) {
+    packedConnectedSynapses_.replaceSparseRow(column, connectedSparse.begin(),
+                                              connectedSparse.end());
+  }
+  connectedCounts_[column] = numConnected;
+}
+
+template <typename T>
+void SpatialPooler::adaptQuantizedSynapses_(vector<vector<T>> &rows,
+                                            UInt inputVector[],
+                                            const vector<UInt> &activeColumns) {
+  const QuantizedParameters &q = quantized_;
+  for (UInt column : activeColumns) {
+    const auto &potential = potentialPools_.getSparseRow(column);
+    vector<T> &row = rows[column];
+    for (UInt j = 0; j < row.size(); j++) {
+      const UInt value = row[j];
+      if (inputVector[potential[j]] > 0) {
+        row[j] = (T)min(q.max, value + q.activeInc);
+      } else {
+        row[j] = (T)(value > q.inactiveDec ? value - q.inactiveDec : 0);
+      }
+    }
+    updateQuantizedColumn_(row, column, true);
+  }
+}
+
+template <typename T>
+void SpatialPooler::bumpUpQuantizedColumn_(vector<vector<T>> &rows,
+                                           UInt column) {
+  vector<T> &row = rows[column];
+  for (T &value : row) {
+    value = (T)min(quantized_.max, value + quantized_.belowStimulusInc);
+  }
+  updateQuantizedColumn_(row, column, false);
+}
+
 UInt SpatialPooler::countConnected_(vector<Real> &perm) {
   UInt numConnected = 0;
   for (auto &elem : perm) {
@@ -667,24 +1293,12 @@ void SpatialPooler::updateMinDutyCyclesGlobal_() {
 }
 
 void SpatialPooler::updateMinDutyCyclesLocal_() {
-  for (UInt i = 0; i < numColumns_; i++) {
-    Real maxActiveDuty = 0;
-    Real maxOverlapDuty = 0;
-    if (wrapAround_) {
-      for (UInt column :
-           WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        maxActiveDuty = max(maxActiveDuty, activeDutyCycles_[column]);
-        maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[column]);
-      }
-    } else {
-      for (UInt column :
-           Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        maxActiveDuty = max(maxActiveDuty, activeDutyCycles_[column]);
-        maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[column]);
-      }
-    }
+  vector<Real> maxOverlapDuty;
+  neighborhoodMaxima(overlapDutyCycles_, inhibitionRadius_, columnDimensions_,
+                     wrapAround_, maxOverlapDuty);
 
-    minOverlapDutyCycles_[i] = maxOverlapDuty * minPctOverlapDutyCycles_;
+  for (UInt i = 0; i < numColumns_; i++) {
+    minOverlapDutyCycles_[i] = maxOverlapDuty[i] * minPctOverlapDutyCycles_;
   }
 }
 
@@ -788,6 +1402,14 @@ Real SpatialPooler::avgConnectedSpanForColumnND_(UInt column) {
 
 void SpatialPooler::adaptSynapses_(UInt inputVector[],
                                    vector<UInt> &activeColumns) {
+  if (permanenceBackend_ == PermanenceBackend::UINT16) {
+    adaptQuantizedSynapses_(permanences16_, inputVector, activeColumns);
+    return;
+  } else if (permanenceBackend_ == PermanenceBackend::UINT8) {
+    adaptQuantizedSynapses_(permanences8_, inputVector, activeColumns);
+    return;
+  }
+
   vector<Real> permChanges(numInputs_, -1 * synPermInactiveDec_);
   for (UInt i = 0; i < numInputs_; i++) {
     if (inputVector[i] > 0) {
@@ -815,6 +1437,13 @@ void SpatialPooler::bumpUpWeakColumns_() {
     if (overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
       continue;
     }
+    if (permanenceBackend_ == PermanenceBackend::UINT16) {
+      bumpUpQuantizedColumn_(permanences16_, i);
+      continue;
+    } else if (permanenceBackend_ == PermanenceBackend::UINT8) {
+      bumpUpQuantizedColumn_(permanences8_, i);
+      continue;
+    }
     vector<Real> perm(numInputs_, 0);
     vector<UInt> potential;
     potential.resize(potentialPools_.nNonZerosOnRow(i));
@@ -865,25 +1494,12 @@ void SpatialPooler::updateBoostFactorsGlobal_() {
 }
 
 void SpatialPooler::updateBoostFactorsLocal_() {
-  for (UInt i = 0; i < numColumns_; ++i) {
-    UInt numNeighbors = 0;
-    Real localActivityDensity = 0;
-
-    if (wrapAround_) {
-      for (UInt neighbor :
-           WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
-      }
-    } else {
-      for (UInt neighbor :
-           Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
-      }
-    }
+  vector<Real> localActivityDensity;
+  neighborhoodMeans(activeDutyCycles_, inhibitionRadius_, columnDimensions_,
+                    wrapAround_, localActivityDensity);
 
-    Real targetDensity = localActivityDensity / numNeighbors;
+  for (UInt i = 0; i < numColumns_; ++i) {
+    Real targetDensity = localActivityDensity[i];
     boostFactors_[i] =
         exp((targetDensity - activeDutyCycles_[i]) * boostStrength_);
   }
@@ -898,11 +1514,32 @@ void SpatialPooler::updateBookeepingVars_(bool learn) {
 
 void SpatialPooler::calculateOverlap_(UInt inputVector[],
                                       vector<UInt> &overlaps) {
+  if (connectedBackend_ == ConnectedBackend::PACKED) {
+    packedInput_.resize(PackedBinaryMatrix::nWords(numInputs_));
+    PackedBinaryMatrix::pack(inputVector, numInputs_, packedInput_.data());
+    calculateOverlapPacked_(packedInput_.data(), overlaps);
+    return;
+  }
+
   overlaps.assign(numColumns_, 0);
   connectedSynapses_.rightVecSumAtNZ(inputVector, inputVector + numInputs_,
                                      overlaps.begin(), overlaps.end());
 }
 
+void SpatialPooler::calculateOverlapPacked_(const UInt64 packedInput[],
+                                            vector<UInt> &overlaps) {
+  if (connectedBackend_ != ConnectedBackend::PACKED) {
+    denseInput_.resize(numInputs_);
+    PackedBinaryMatrix::unpack(packedInput, numInputs_, denseInput_.data());
+    calculateOverlap_(denseInput_.data(), overlaps);
+    return;
+  }
+
+  overlaps.assign(numColumns_, 0);
+  packedConnectedSynapses_.rightVecSumAtNZPacked(packedInput, overlaps.begin(),
+                                                 overlaps.end());
+}
+
 void SpatialPooler::calculateOverlapPct_(vector<UInt> &overlaps,
                                          vector<Real> &overlapPct) {
   overlapPct.assign(numColumns_, 0);
@@ -1145,11 +1782,16 @@ void SpatialPooler::save(ostream &outStream) const {
   }
   outStream << endl;
 
+  vector<Real> dense(numInputs_);
   for (UInt i = 0; i < numColumns_; i++) {
     vector<pair<UInt, Real>> perm;
-    perm.resize(permanences_.nNonZerosOnRow(i));
+    getPermanence(i, dense.data());
+    for (UInt j = 0; j < numInputs_; j++) {
+      if (dense[j] != 0) {
+        perm.push_back(make_pair(j, dense[j]));
+      }
+    }
     outStream << perm.size() << endl;
-    permanences_.getRowToSparse(i, perm.begin());
     for (auto &elem : perm) {
       outStream << elem.first << " ";
       saveFloat_(outStream, elem.second);
@@ -1251,6 +1893,10 @@ void SpatialPooler::load(istream &inStream) {
   permanences_.resize(numColumns_, numInputs_);
   connectedSynapses_.resize(numColumns_, numInputs_);
   connectedCounts_.resize(numColumns_);
+  connectedBackend_ = ConnectedBackend::SPARSE;
+  permanenceBackend_ = PermanenceBackend::REAL;
+  vector<vector<UInt16>>().swap(permanences16_);
+  vector<vector<UInt8>>().swap(permanences8_);
   for (UInt i = 0; i < numColumns_; i++) {
     UInt nNonZerosOnRow;
     inStream >> nNonZerosOnRow;
@@ -1265,6 +1911,7 @@ void SpatialPooler::load(istream &inStream) {
     }
     updatePermanencesForColumn_(perm, i, false);
   }
+  setConnectedBackend(ConnectedBackend::SPARSE);
 
   inStream >> rng_;
 
@@ -1331,8 +1978,27 @@ void SpatialPooler::write(SpatialPoolerProto::Builder &proto) const {
     }
   }
 
+  // Fixed-point permanences are written as their REAL values.
   auto permanences = proto.initPermanences();
-  permanences_.write(permanences);
+  if (permanenceBackend_ == PermanenceBackend::REAL) {
+    permanences_.write(permanences);
+  } else {
+    SparseMatrix<UInt, Real, Int, Real64> realPermanences(numColumns_,
+                                                          numInputs_);
+    vector<Real> perm(numInputs_);
+    for (UInt i = 0; i < numColumns_; ++i) {
+      getPermanence(i, perm.data());
+      realPermanences.setRowFromDense(i, perm);
+    }
+    realPermanences.write(permanences);
+  }
+  if (permanenceBackend_ == PermanenceBackend::UINT16) {
+    proto.setPermanenceBackend(SpatialPoolerProto::PermanenceBackend::UINT16);
+  } else if (permanenceBackend_ == PermanenceBackend::UINT8) {
+    proto.setPermanenceBackend(SpatialPoolerProto::PermanenceBackend::UINT8);
+  } else {
+    proto.setPermanenceBackend(SpatialPoolerProto::PermanenceBackend::REAL);
+  }
 
   auto tieBreaker = proto.initTieBreaker(numColumns_);
   for (UInt i = 0; i < numColumns_; ++i) {
@@ -1411,6 +2077,10 @@ void SpatialPooler::read(SpatialPoolerProto::Reader &proto) {
 
   connectedSynapses_.resize(numColumns_, numInputs_);
   connectedCounts_.resize(numColumns_);
+  connectedBackend_ = ConnectedBackend::SPARSE;
+  permanenceBackend_ = PermanenceBackend::REAL;
+  vector<vector<UInt16>>().swap(permanences16_);
+  vector<vector<UInt8>>().swap(permanences8_);
 
   // since updatePermanencesForColumn_, used below for initialization, is
   // used elsewhere and necessarily updates permanences_, there is no need
@@ -1418,38 +2088,32 @@ void SpatialPooler::read(SpatialPoolerProto::Reader &proto) {
   auto permanences = proto.getPermanences();
   permanences_.resize(permanences.getNumRows(), permanences.getNumColumns());
   auto permanenceValues = permanences.getRows();
+  vector<Real> colPerms;
   for (UInt i = 0; i < numColumns_; ++i) {
-    vector<Real> colPerms(numInputs_, 0);
+    colPerms.assign(numInputs_, 0);
     for (auto perm : permanenceValues[i].getValues()) {
       colPerms[perm.getIndex()] = perm.getValue();
     }
     updatePermanencesForColumn_(colPerms, i, false);
   }
+  setConnectedBackend(ConnectedBackend::SPARSE);
 
-  tieBreaker_.clear();
-  for (auto value : proto.getTieBreaker()) {
-    tieBreaker_.push_back(value);
+  switch (proto.getPermanenceBackend()) {
+  case SpatialPoolerProto::PermanenceBackend::UINT16:
+    setPermanenceBackend(PermanenceBackend::UINT16);
+    break;
+  case SpatialPoolerProto::PermanenceBackend::UINT8:
+    setPermanenceBackend(PermanenceBackend::UINT8);
+    break;
+  default:
+    break;
   }
 
-  overlapDutyCycles_.clear();
-  for (auto value : proto.getOverlapDutyCycles()) {
-    overlapDutyCycles_.push_back(value);
-  }
-
-  activeDutyCycles_.clear();
-  for (auto value : proto.getActiveDutyCycles()) {
-    activeDutyCycles_.push_back(value);
-  }
-
-  minOverlapDutyCycles_.clear();
-  for (auto value : proto.getMinOverlapDutyCycles()) {
-    minOverlapDutyCycles_.push_back(value);
-  }
-
-  boostFactors_.clear();
-  for (auto value : proto.getBoostFactors()) {
-    boostFactors_.push_back(value);
-  }
+  copyList_(proto.getTieBreaker(), tieBreaker_);
+  copyList_(proto.getOverlapDutyCycles(), overlapDutyCycles_);
+  copyList_(proto.getActiveDutyCycles(), activeDutyCycles_);
+  copyList_(proto.getMinOverlapDutyCycles(), minOverlapDutyCycles_);
+  copyList_(proto.getBoostFactors(), boostFactors_);
 
   // Initialize ephemerals
   overlaps_.resize(numColumns_);
@@ -30,6 +30,7 @@
 #include <capnp/message.h>
 #include <cstring>
 #include <iostream>
+#include <nupic/math/PackedBinaryMatrix.hpp>
 #include <nupic/math/SparseBinaryMatrix.hpp>
 #include <nupic/math/SparseMatrix.hpp>
 #include <nupic/proto/SpatialPoolerProto.capnp.h>
@@ -44,6 +45,38 @@ namespace nupic {
 namespace algorithms {
 namespace spatial_pooler {
 
+/**
+ * Storage used for the connected synapses when computing overlaps.
+ *
+ * SPARSE keeps the indices of the connected inputs of each column. PACKED
+ * additionally keeps one bit per (column, input), so that the overlap is
+ * computed by ANDing each column with the packed input and counting bits.
+ * PACKED is faster when columns are connected to more than a few percent of
+ * their inputs, at the cost of numColumns * numInputs / 8 bytes that are
+ * kept up to date on every permanence update. AUTO picks PACKED when the
+ * connected synapses are dense enough and the packed copy takes at most
+ * 64 MB, SPARSE otherwise. The default is SPARSE, and a spatial pooler read
+ * back from a checkpoint uses SPARSE as well.
+ */
+enum class ConnectedBackend { AUTO, SPARSE, PACKED };
+
+/**
+ * Storage used for the permanences.
+ *
+ * REAL keeps a Real value and a column index per non-zero permanence.
+ * UINT16 and UINT8 keep one fixed-point value per potential synapse, in
+ * steps of synPermMax / 65535 or synPermMax / 255, next to the potential
+ * pool's indices, so no index is stored for the permanences at all.
+ *
+ * With fixed-point storage, learning works directly on the stored values:
+ * synPermActiveInc, synPermInactiveDec and synPermBelowStimulusInc are
+ * rounded to the nearest step, but never to less than one step, so that
+ * learning never stalls. A synapse is connected when its value is at
+ * least synPermConnected, and it is trimmed to 0 when its value is below
+ * synPermTrimThreshold, both rounded up to the next step.
+ */
+enum class PermanenceBackend { REAL, UINT16, UINT8 };
+
 /**
  * CLA spatial pooler implementation in C++.
  *
@@ -78,7 +111,10 @@ public:
                 Real synPermActiveInc = 0.05, Real synPermConnected = 0.1,
                 Real minPctOverlapDutyCycles = 0.001,
                 UInt dutyCyclePeriod = 1000, Real boostStrength = 0.0,
-                Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true);
+                Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true,
+                ConnectedBackend connectedBackend = ConnectedBackend::SPARSE,
+                UInt initThreads = 0,
+                PermanenceBackend permanenceBackend = PermanenceBackend::REAL);
 
   virtual ~SpatialPooler() {}
 
@@ -202,6 +238,23 @@ public:
         at the beginning and end of an input dimension are considered
         neighbors for the purpose of mapping inputs to columns.
 
+  @param connectedBackend How the connected synapses are stored for the
+        overlap computation. See ConnectedBackend. With AUTO the choice is
+        made from the density of the initial connected synapses and the
+        size of the packed copy.
+
+  @param initThreads 0 (the default) initializes the columns one after the
+        other from the spatial pooler's random number generator. Any other
+        value uses the fast initialization: each column draws from its own
+        random stream derived from the seed, its potential pool and
+        permanences are built directly in sparse form, and the columns are
+        split across initThreads threads. The fast initialization gives a
+        different model than the default one, but that model only depends
+        on the seed, not on the number of threads.
+
+  @param permanenceBackend How the permanences are stored. See
+        PermanenceBackend.
+
    */
   virtual void
   initialize(vector<UInt> inputDimensions, vector<UInt> columnDimensions,
@@ -211,7 +264,10 @@ public:
              Real synPermInactiveDec = 0.01, Real synPermActiveInc = 0.1,
              Real synPermConnected = 0.1, Real minPctOverlapDutyCycles = 0.001,
              UInt dutyCyclePeriod = 1000, Real boostStrength = 0.0,
-             Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true);
+             Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true,
+             ConnectedBackend connectedBackend = ConnectedBackend::SPARSE,
+             UInt initThreads = 0,
+             PermanenceBackend permanenceBackend = PermanenceBackend::REAL);
 
   /**
   This is the main workshorse method of the SpatialPooler class. This
@@ -246,6 +302,54 @@ public:
    */
   virtual void compute(UInt inputVector[], bool learn, UInt activeVector[]);
 
+  /**
+  Same as compute, but the input is given as a packed bit vector: input
+  bit i is bit (i % 64) of packedInput[i / 64]. packedInput must hold
+  (getNumInputs() + 63) / 64 words, and the unused high bits of the last
+  word must be 0. See PackedBinaryMatrix::pack.
+
+  With the PACKED backend and learn=false the input is never expanded.
+   */
+  void computePacked(const UInt64 packedInput[], bool learn,
+                     UInt activeVector[]);
+
+  /**
+  Runs inference (learn=false) on a batch of input vectors.
+
+  The result is the same as calling compute(input, false, active) on each
+  input in turn, including the iteration count and the values returned by
+  getOverlaps and getBoostedOverlaps afterwards, which are those of the
+  last input. The overlaps are computed for blocks of inputs at a time, so
+  that each column's connected synapses are read once per block rather
+  than once per input.
+
+  @param inputVectors batchSize input vectors of getNumInputs() 0's and
+        1's, one after the other.
+
+  @param batchSize The number of input vectors.
+
+  @param activeVectors Receives batchSize active vectors of
+        getNumColumns() 0's and 1's, one after the other.
+
+  @param numThreads The number of threads to split the batch across.
+   */
+  void computeBatch(const UInt inputVectors[], UInt batchSize,
+                    UInt activeVectors[], UInt numThreads = 1);
+
+  /**
+  Same as computeBatch, but with the inputs given in compressed sparse row
+  form: the active bits of input vector b are
+  inputIndices[inputOffsets[b]] .. inputIndices[inputOffsets[b + 1] - 1].
+
+  @param inputIndices The indices of the active input bits of all input
+        vectors, one after the other.
+
+  @param inputOffsets batchSize + 1 offsets into inputIndices.
+   */
+  void computeBatchSparse(const UInt inputIndices[], const UInt inputOffsets[],
+                          UInt batchSize, UInt activeVectors[],
+                          UInt numThreads = 1);
+
   /**
    Removes the set of columns who have never been active from the set
    of active columns selected in the inhibition round. Such columns
@@ -762,6 +866,34 @@ public:
    */
   void printParameters() const;
 
+  /**
+  Returns the storage currently used for the connected synapses, SPARSE or
+  PACKED.
+   */
+  ConnectedBackend getConnectedBackend() const;
+
+  /**
+  Switches the storage used for the connected synapses. AUTO picks one
+  from the current density of connected synapses. The results of compute
+  don't depend on the backend.
+   */
+  void setConnectedBackend(ConnectedBackend connectedBackend);
+
+  /**
+  Returns the storage currently used for the permanences.
+   */
+  PermanenceBackend getPermanenceBackend() const;
+
+  /**
+  Switches the storage used for the permanences. Switching to a fixed-point
+  backend rounds the permanences to the nearest step and drops permanences
+  outside of the potential pools, then recomputes the connected synapses.
+
+  save() and load() always use REAL values, load() restores a REAL
+  spatial pooler. write() and read() preserve the backend.
+   */
+  void setPermanenceBackend(PermanenceBackend permanenceBackend);
+
   /**
   Returns the overlap score for each column.
    */
@@ -873,6 +1005,62 @@ public:
     the input bits that will start off in a connected state.
   */
   vector<Real> initPermanence_(vector<UInt> &potential, Real connectedPct);
+
+  /**
+    Fast initialization of the potential pools, permanences and connected
+    synapses of all columns. Each column gets the same treatment as in the
+    default initialization (mapPotential_, initPermanence_ and
+    updatePermanencesForColumn_ with raisePerm=true), but it only ever
+    works on the column's potential inputs, and draws from its own random
+    number generator seeded from baseSeed and the column index. Columns are
+    computed on numThreads threads and then copied into the matrices.
+
+    @param baseSeed    The seed the per-column seeds are derived from.
+
+    @param numThreads  The number of threads to use.
+  */
+  void initializeColumnsFast_(UInt64 baseSeed, UInt numThreads);
+
+  /**
+    Parameters of the fixed-point permanences, in steps. Computed from
+    synPermMax_ and the other synPerm parameters by
+    updateQuantizedParameters_().
+  */
+  struct QuantizedParameters {
+    Real step;
+    UInt max;
+    UInt activeInc;
+    UInt inactiveDec;
+    UInt belowStimulusInc;
+    UInt connected;
+    UInt trimThreshold;
+  };
+
+  void updateQuantizedParameters_();
+
+  /**
+    Counterparts of getPermanence, updatePermanencesForColumn_,
+    adaptSynapses_ and bumpUpWeakColumns_ for fixed-point permanences.
+    rows holds one vector per column, with one value per input of the
+    column's potential pool.
+  */
+  template <typename T>
+  void getQuantizedPermanence_(const vector<vector<T>> &rows, UInt column,
+                               Real permanences[]) const;
+
+  template <typename T>
+  void setQuantizedPermanence_(vector<vector<T>> &rows, UInt column,
+                               const vector<Real> &perm, bool raisePerm);
+
+  template <typename T>
+  void updateQuantizedColumn_(vector<T> &row, UInt column, bool raisePerm);
+
+  template <typename T>
+  void adaptQuantizedSynapses_(vector<vector<T>> &rows, UInt inputVector[],
+                               const vector<UInt> &activeColumns);
+
+  template <typename T>
+  void bumpUpQuantizedColumn_(vector<vector<T>> &rows, UInt column);
   void clip_(vector<Real> &perm, bool trim);
 
   /**
@@ -931,6 +1119,8 @@ public:
      input bits which are turned on.
   */
   void calculateOverlap_(UInt inputVector[], vector<UInt> &overlap);
+  void calculateOverlapPacked_(const UInt64 packedInput[],
+                               vector<UInt> &overlap);
   void calculateOverlapPct_(vector<UInt> &overlaps, vector<Real> &overlapPct);
 
   bool isWinner_(Real score, vector<pair<UInt, Real>> &winners,
@@ -1217,6 +1407,35 @@ public:
   */
   bool isUpdateRound_();
 
+  /**
+     Everything compute does after the overlaps have been calculated:
+     boosting, inhibition, and, if learn is true, learning.
+
+     @param inputVector
+     The dense input vector. Only used when learn is true.
+  */
+  void computeActiveColumns_(UInt inputVector[], bool learn,
+                             UInt activeVector[]);
+
+  /**
+     Shared implementation of computeBatch and computeBatchSparse. Exactly
+     one of inputVectors and inputIndices is non-null.
+  */
+  void computeBatch_(const UInt inputVectors[], const UInt inputIndices[],
+                     const UInt inputOffsets[], UInt batchSize,
+                     UInt activeVectors[], UInt numThreads);
+
+  /**
+     Runs inference on records [begin, end) of a batch. Only reads the
+     state of the spatial pooler, so several ranges can run concurrently.
+     The overlaps of the last record of the batch, if it is in this range,
+     are copied to lastOverlaps.
+  */
+  void computeBatchRange_(const UInt inputVectors[], const UInt inputIndices[],
+                          const UInt inputOffsets[], UInt begin, UInt end,
+                          UInt batchSize, UInt activeVectors[],
+                          vector<UInt> &lastOverlaps);
+
   /**
   Initialize the random seed
 
@@ -1275,10 +1494,19 @@ protected:
   Real minPctOverlapDutyCycles_;
 
   SparseMatrix<UInt, Real, Int, Real64> permanences_;
+  PermanenceBackend permanenceBackend_;
+  QuantizedParameters quantized_;
+  vector<vector<UInt16>> permanences16_;
+  vector<vector<UInt8>> permanences8_;
   SparseBinaryMatrix<UInt, UInt> potentialPools_;
   SparseBinaryMatrix<UInt, UInt> connectedSynapses_;
   vector<UInt> connectedCounts_;
 
+  ConnectedBackend connectedBackend_;
+  PackedBinaryMatrix packedConnectedSynapses_;
+  vector<UInt64> packedInput_;
+  vector<UInt> denseInput_;
+
   vector<UInt> overlaps_;
   vector<Real> overlapsPct_;
   vector<Real> boostedOverlaps_;
@@ -904,6 +904,7 @@ void TemporalMemory::write(TemporalMemoryProto::Builder &proto) const {
 void TemporalMemory::read(TemporalMemoryProto::Reader &proto) {
   numColumns_ = 1;
   columnDimensions_.clear();
+  columnDimensions_.reserve(proto.getColumnDimensions().size());
   for (UInt dimension : proto.getColumnDimensions()) {
     numColumns_ *= dimension;
     columnDimensions_.push_back(dimension);
@@ -934,17 +935,21 @@ void TemporalMemory::read(TemporalMemoryProto::Reader &proto) {
   auto random = proto.getRandom();
   rng_.read(random);
 
+  // Each list is copied into a single allocation.
   activeCells_.clear();
+  activeCells_.reserve(proto.getActiveCells().size());
   for (auto cell : proto.getActiveCells()) {
     activeCells_.push_back(cell);
   }
 
   winnerCells_.clear();
+  winnerCells_.reserve(proto.getWinnerCells().size());
   for (auto cell : proto.getWinnerCells()) {
     winnerCells_.push_back(cell);
   }
 
   activeSegments_.clear();
+  activeSegments_.reserve(proto.getActiveSegments().size());
   for (auto value : proto.getActiveSegments()) {
     const Segment segment =
         connections.getSegment(value.getCell(), value.getIdxOnCell());
@@ -952,6 +957,7 @@ void TemporalMemory::read(TemporalMemoryProto::Reader &proto) {
   }
 
   matchingSegments_.clear();
+  matchingSegments_.reserve(proto.getMatchingSegments().size());
   for (auto value : proto.getMatchingSegments()) {
     const Segment segment =
         connections.getSegment(value.getCell(), value.getIdxOnCell());
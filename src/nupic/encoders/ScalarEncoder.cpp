@@ -24,8 +24,11 @@
  * Implementations of the ScalarEncoder and PeriodicScalarEncoder
  */
 
+#include <algorithm>
 #include <cmath>
 #include <cstring> // memset
+#include <vector>
+
 #include <nupic/encoders/ScalarEncoder.hpp>
 #include <nupic/utils/Log.hpp>
 
@@ -73,7 +76,55 @@ ScalarEncoder::ScalarEncoder(int w, double minValue, double maxValue, int n,
 
 ScalarEncoder::~ScalarEncoder() {}
 
-int ScalarEncoder::encodeIntoArray(Real64 input, Real32 output[]) {
+int ScalarEncoderBase::encodeSparse(Real64 input, UInt32 indicesOut[]) {
+  std::vector<Real32> output(getOutputWidth());
+  const int iBucket = encodeIntoArray(input, output.data());
+  for (size_t i = 0; i < output.size(); i++) {
+    if (output[i] != 0) {
+      *indicesOut++ = i;
+    }
+  }
+  return iBucket;
+}
+
+int ScalarEncoderBase::getW() const {
+  // encodeIntoArray isn't const, but encoding keeps no state
+  std::vector<Real32> output(getOutputWidth());
+  const_cast<ScalarEncoderBase *>(this)->encodeIntoArray(0, output.data());
+  return std::count_if(output.begin(), output.end(),
+                       [](Real32 bit) { return bit != 0; });
+}
+
+void ScalarEncoderBase::encodeBatch(const Real64 inputs[], UInt count,
+                                    Real32 output[], int buckets[]) {
+  // Clear the whole batch at once, then set the active bits of each input.
+  const size_t n = getOutputWidth();
+  const int w = getW();
+  std::vector<UInt32> indices(w);
+  memset(output, 0, count * n * sizeof(output[0]));
+  for (UInt i = 0; i < count; i++) {
+    const int iBucket = encodeSparse(inputs[i], indices.data());
+    for (int j = 0; j < w; j++) {
+      output[i * n + indices[j]] = 1;
+    }
+    if (buckets != nullptr) {
+      buckets[i] = iBucket;
+    }
+  }
+}
+
+void ScalarEncoderBase::encodeSparseBatch(const Real64 inputs[], UInt count,
+                                          UInt32 indicesOut[], int buckets[]) {
+  const size_t w = getW();
+  for (UInt i = 0; i < count; i++) {
+    const int iBucket = encodeSparse(inputs[i], indicesOut + i * w);
+    if (buckets != nullptr) {
+      buckets[i] = iBucket;
+    }
+  }
+}
+
+int ScalarEncoder::bucketIndex_(Real64 input) const {
   if (input < minValue_) {
     if (clipInput_) {
       input = minValue_;
@@ -90,7 +141,11 @@ int ScalarEncoder::encodeIntoArray(Real64 input, Real32 output[]) {
     }
   }
 
-  const int iBucket = round((input - minValue_) / bucketWidth_);
+  return round((input - minValue_) / bucketWidth_);
+}
+
+int ScalarEncoder::encodeIntoArray(Real64 input, Real32 output[]) {
+  const int iBucket = bucketIndex_(input);
 
   const int firstBit = iBucket;
 
@@ -102,6 +157,17 @@ int ScalarEncoder::encodeIntoArray(Real64 input, Real32 output[]) {
   return iBucket;
 }
 
+int ScalarEncoder::encodeSparse(Real64 input, UInt32 indicesOut[]) {
+  const int iBucket = bucketIndex_(input);
+
+  const int firstBit = iBucket;
+  for (int i = 0; i < w_; i++) {
+    indicesOut[i] = firstBit + i;
+  }
+
+  return iBucket;
+}
+
 PeriodicScalarEncoder::PeriodicScalarEncoder(int w, double minValue,
                                              double maxValue, int n,
                                              double radius, double resolution)
@@ -143,13 +209,17 @@ PeriodicScalarEncoder::PeriodicScalarEncoder(int w, double minValue,
 
 PeriodicScalarEncoder::~PeriodicScalarEncoder() {}
 
-int PeriodicScalarEncoder::encodeIntoArray(Real64 input, Real32 output[]) {
+int PeriodicScalarEncoder::bucketIndex_(Real64 input) const {
   if (input < minValue_ || input >= maxValue_) {
     NTA_THROW << "input " << input << " not within range [" << minValue_ << ", "
               << maxValue_ << ")";
   }
 
-  const int iBucket = (int)((input - minValue_) / bucketWidth_);
+  return (int)((input - minValue_) / bucketWidth_);
+}
+
+int PeriodicScalarEncoder::encodeIntoArray(Real64 input, Real32 output[]) {
+  const int iBucket = bucketIndex_(input);
 
   const int middleBit = iBucket;
   const double reach = (w_ - 1) / 2.0;
@@ -168,4 +238,24 @@ int PeriodicScalarEncoder::encodeIntoArray(Real64 input, Real32 output[]) {
 
   return iBucket;
 }
+
+int PeriodicScalarEncoder::encodeSparse(Real64 input, UInt32 indicesOut[]) {
+  const int iBucket = bucketIndex_(input);
+
+  // The active bits are the w bits starting at firstBit, wrapping around
+  // the end. The ones that wrapped around come first in increasing order.
+  const int left = floor((w_ - 1) / 2.0);
+  const int firstBit = (iBucket - left < 0) ? iBucket - left + n_
+                                            : iBucket - left;
+  const int wrapped = std::max(firstBit + w_ - n_, 0);
+  int j = 0;
+  for (int i = 0; i < wrapped; i++) {
+    indicesOut[j++] = i;
+  }
+  for (int i = firstBit; i < firstBit + w_ - wrapped; i++) {
+    indicesOut[j++] = i;
+  }
+
+  return iBucket;
+}
 } // end namespace nupic
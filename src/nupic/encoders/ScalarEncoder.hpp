@@ -51,10 +51,50 @@ public:
    */
   virtual int encodeIntoArray(Real64 input, Real32 output[]) = 0;
 
+  /**
+   * Encodes input like encodeIntoArray, but writes the indices of the
+   * active bits, in increasing order, instead of the dense output.
+   *
+   * The default scans the output of encodeIntoArray. Encoders that know
+   * their active bits should override it.
+   *
+   * @param input The value to encode
+   * @param indicesOut Should have length of at least getW()
+   */
+  virtual int encodeSparse(Real64 input, UInt32 indicesOut[]);
+
+  /**
+   * Encodes count inputs with encodeIntoArray. The encoding of inputs[i] is
+   * written to output + i * getOutputWidth().
+   *
+   * @param output Should have length of at least count * getOutputWidth()
+   * @param buckets If not nullptr, receives the bucket number of each input
+   */
+  void encodeBatch(const Real64 inputs[], UInt count, Real32 output[],
+                   int buckets[] = nullptr);
+
+  /**
+   * Encodes count inputs with encodeSparse. The active bits of inputs[i]
+   * are written to indicesOut + i * getW().
+   *
+   * @param indicesOut Should have length of at least count * getW()
+   * @param buckets If not nullptr, receives the bucket number of each input
+   */
+  void encodeSparseBatch(const Real64 inputs[], UInt count,
+                         UInt32 indicesOut[], int buckets[] = nullptr);
+
   /**
    * Returns the output width, in bits.
    */
   virtual int getOutputWidth() const = 0;
+
+  /**
+   * Returns the number of active bits of an encoding.
+   *
+   * The default counts the active bits of the encoding of 0, so encoders
+   * that can't encode 0 have to override it.
+   */
+  virtual int getW() const;
 };
 
 /** Encodes a floating point number as a contiguous block of 1s.
@@ -105,9 +145,14 @@ public:
   ~ScalarEncoder() override;
 
   virtual int encodeIntoArray(Real64 input, Real32 output[]) override;
+  virtual int encodeSparse(Real64 input, UInt32 indicesOut[]) override;
   virtual int getOutputWidth() const override { return n_; }
+  virtual int getW() const override { return w_; }
 
 private:
+  // Checks or clips the input, and returns its bucket.
+  int bucketIndex_(Real64 input) const;
+
   int w_;
   int n_;
   double minValue_;
@@ -162,9 +207,14 @@ public:
   virtual ~PeriodicScalarEncoder() override;
 
   virtual int encodeIntoArray(Real64 input, Real32 output[]) override;
+  virtual int encodeSparse(Real64 input, UInt32 indicesOut[]) override;
   virtual int getOutputWidth() const override { return n_; }
+  virtual int getW() const override { return w_; }
 
 private:
+  // Checks or clips the input, and returns its bucket.
+  int bucketIndex_(Real64 input) const;
+
   int w_;
   int n_;
   double minValue_;
@@ -79,8 +79,27 @@ ScalarSensor::ScalarSensor(AnyPointer::Reader &proto, Region *region)
 ScalarSensor::~ScalarSensor() { delete encoder_; }
 
 void ScalarSensor::compute() {
+  Int32 iBucket = 0;
   Real32 *array = (Real32 *)encodedOutput_->getData().getBuffer();
-  const Int32 iBucket = encoder_->encodeIntoArray(sensedValue_, array);
+  if (computeSparse_) {
+    // Remove 'const' to update the variable length array
+    Array &sparse = const_cast<Array &>(encodedSparseOutput_->getData());
+    UInt32 *indices = (UInt32 *)sparse.getBuffer();
+    if (!computeDense_) {
+      // The dense output follows the sparse one, one active bit at a time
+      for (size_t i = 0; i < sparse.getCount(); i++)
+        array[indices[i]] = 0;
+    }
+    iBucket = encoder_->encodeSparse(sensedValue_, indices);
+    sparse.setCount(encoder_->getW());
+    if (!computeDense_) {
+      for (size_t i = 0; i < sparse.getCount(); i++)
+        array[indices[i]] = 1;
+    }
+  }
+  if (computeDense_) {
+    iBucket = encoder_->encodeIntoArray(sensedValue_, array);
+  }
   ((Int32 *)bucketOutput_->getData().getBuffer())[0] = iBucket;
 }
 
@@ -169,6 +188,15 @@ void ScalarSensor::compute() {
                                         true  // isDefaultOutput
                                         ));
 
+  ns->outputs.add("encodedSparse",
+                  OutputSpec("Indices of the active bits of the encoded value",
+                             NTA_BasicType_UInt32,
+                             0,     // elementCount
+                             true,  // isRegionLevel
+                             false, // isDefaultOutput
+                             true   // sparse
+                             ));
+
   ns->outputs.add("bucket", OutputSpec("Bucket number for this sensedValue",
                                        NTA_BasicType_Int32,
                                        0,    // elementCount
@@ -202,12 +230,22 @@ void ScalarSensor::setParameterFromBuffer(const std::string &name, Int64 index,
 
 void ScalarSensor::initialize() {
   encodedOutput_ = getOutput("encoded");
+  encodedSparseOutput_ = getOutput("encodedSparse");
   bucketOutput_ = getOutput("bucket");
+
+  // Links are in place by now. The dense output is still encoded when
+  // nothing is linked, for callers that read it directly, and when only
+  // the sparse output is linked, it is updated from the active bits.
+  computeSparse_ = region_->getOutput("encodedSparse")->hasOutgoingLinks();
+  computeDense_ = region_->getOutput("encoded")->hasOutgoingLinks() ||
+                  !computeSparse_;
 }
 
 size_t ScalarSensor::getNodeOutputElementCount(const std::string &outputName) {
   if (outputName == "encoded") {
     return encoder_->getOutputWidth();
+  } else if (outputName == "encodedSparse") {
+    return encoder_->getW();
   } else if (outputName == "bucket") {
     return 1;
   } else {
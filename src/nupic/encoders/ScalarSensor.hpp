@@ -48,6 +48,11 @@ namespace nupic {
  * API. As a network runs, the client will specify new encoder inputs by
  * setting the "sensedValue" parameter. On each compute, the ScalarSensor will
  * encode its "sensedValue" to output.
+ *
+ * The encoding is available both as the dense "encoded" output and as the
+ * sparse "encodedSparse" output, the indices of its active bits. When only
+ * "encodedSparse" is linked, the dense output is not computed, so a
+ * ScalarSensor feeding a sparse input never builds a dense vector.
  */
 class ScalarSensor : public RegionImpl {
 public:
@@ -84,7 +89,10 @@ private:
   Real64 sensedValue_;
   ScalarEncoderBase *encoder_;
   const Output *encodedOutput_;
+  const Output *encodedSparseOutput_;
   const Output *bucketOutput_;
+  bool computeDense_;
+  bool computeSparse_;
 };
 } // namespace nupic
 
@@ -37,9 +37,10 @@
 namespace nupic {
 
 Input::Input(Region &region, NTA_BasicType dataType, bool isRegionLevel,
-             bool isSparse)
+             bool isSparse, bool isReadOnly)
     : region_(region), isRegionLevel_(isRegionLevel), initialized_(false),
-      data_(dataType), name_("Unnamed"), isSparse_(isSparse) {}
+      data_(dataType), name_("Unnamed"), isSparse_(isSparse),
+      isReadOnly_(isReadOnly), zeroCopy_(false) {}
 
 Input::~Input() {
   uninitialize();
@@ -135,134 +136,237 @@ bool Input::isRegionLevel() { return isRegionLevel_; }
 
 bool Input::isSparse() { return isSparse_; }
 
+bool Input::isZeroCopy() const { return zeroCopy_; }
+
 // See header file for documentation
 size_t Input::evaluateLinks() {
   /**
    * It is not an error to call evaluateLinks() on an initialized
    * input -- just report that no links remain to be evaluated.
-   * This simplifies the logic in Region::evaluateLinks, which calls
-   * evaluateLinks on all its inputs at each iteration of network
-   * initialization.
    */
   if (initialized_)
     return 0;
 
   size_t nIncompleteLinks = 0;
-  std::vector<Link *>::iterator l;
-  for (l = links_.begin(); l != links_.end(); l++) {
-    Region &srcRegion = (*l)->getSrc().getRegion();
-    Region &destRegion = (*l)->getDest().getRegion();
-
-    /**
-     * The link and region need to be consistent at both
-     * ends of the link.
-     * - Region dimensions may be specified or unspecified
-     * - Link dimensions (at either end) may be specified,
-     *   unspecified, or dontcare.
-     * At each of the source and destination, we handle
-     * each of the six possible cases of Region/Link specification.
-     */
-
-    /* ------ look at the source side of the link ------- */
-
-    Dimensions srcRegionDims = srcRegion.getDimensions();
-    Dimensions srcLinkDims = (*l)->getSrcDimensions();
-
-    /* source region dimensions are unspecified */
-    if (srcRegionDims.isUnspecified()) {
-      if (srcLinkDims.isUnspecified()) {
-        // 1. link cares about src dimensions but they aren't set
-        // link is incomplete;
-      } else if (srcLinkDims.isDontcare()) {
-        // 2. Link doesn't care. We don't need to do anything.
-      } else {
-        // 3. Link specifies src dimensions but src region dimensions
-        // are unspecified. Induce dimensions on the source region.
+  for (auto link : links_) {
+    if (!evaluateLink(link))
+      nIncompleteLinks++;
+  }
 
-        // If source region is initialized, this is a logic error
-        NTA_CHECK(!srcRegion.isInitialized());
+  return nIncompleteLinks;
+}
 
-        if (!((*l)->getSrc().isRegionLevel())) {
-          // 3.1 Only set the dimensions if the link source is not region
-          // level
+bool Input::evaluateLink(Link *link) {
+  if (initialized_)
+    return true;
 
-          // Set the dimensions and record that we set them
-          srcRegion.setDimensions(srcLinkDims);
-          srcRegionDims = srcRegion.getDimensions();
+  Region &srcRegion = link->getSrc().getRegion();
+  Region &destRegion = link->getDest().getRegion();
 
-          std::stringstream ss;
-          ss << "Specified by source dimensions on link " << (*l)->toString();
-          srcRegion.setDimensionInfo(ss.str());
-        } else {
-          // 3.2 Link is incomplete
+  /**
+   * The link and region need to be consistent at both
+   * ends of the link.
+   * - Region dimensions may be specified or unspecified
+   * - Link dimensions (at either end) may be specified,
+   *   unspecified, or dontcare.
+   * At each of the source and destination, we handle
+   * each of the six possible cases of Region/Link specification.
+   */
+
+  /* ------ look at the source side of the link ------- */
+
+  Dimensions srcRegionDims = srcRegion.getDimensions();
+  Dimensions srcLinkDims = link->getSrcDimensions();
+
+  /* source region dimensions are unspecified */
+  if (srcRegionDims.isUnspecified()) {
+    if (srcLinkDims.isUnspecified()) {
+      // 1. link cares about src dimensions but they aren't set
+      // link is incomplete;
+    } else if (srcLinkDims.isDontcare()) {
+      // 2. Link doesn't care. We don't need to do anything.
+    } else {
+      // 3. Link specifies src dimensions but src region dimensions
+      // are unspecified. Induce dimensions on the source region.
+
+      // If source region is initialized, this is a logic error
+      NTA_CHECK(!srcRegion.isInitialized());
+
+      if (!(link->getSrc().isRegionLevel())) {
+        // 3.1 Only set the dimensions if the link source is not region
+        // level
+
+        // Set the dimensions and record that we set them
+        srcRegion.setDimensions(srcLinkDims);
+        srcRegionDims = srcRegion.getDimensions();
+
+        srcRegion.setDimensionInfo(
+            "Specified by source dimensions on link " + link->toString());
+      } else {
+        // 3.2 Link is incomplete
+      }
+    }
+  } else {
+    /* source region dimensions are specified */
+    if (srcLinkDims.isDontcare()) {
+      // 4. Link doesn't care. We don't need to do anything.
+    } else if (srcLinkDims.isUnspecified()) {
+      // 5. srcRegion dims set link dims
+
+      if (link->getSrc().isRegionLevel()) {
+        // 5.1 link source is region level, so use dimensions of [1]
+
+        Dimensions d;
+        for (size_t i = 0; i < srcRegionDims.size(); i++) {
+          d.push_back(1);
         }
+
+        link->setSrcDimensions(d);
+        srcLinkDims = d;
+      } else {
+        // 5.2 apply region dimensions to link
+
+        link->setSrcDimensions(srcRegionDims);
+        srcLinkDims = srcRegionDims;
       }
     } else {
-      /* source region dimensions are specified */
-      if (srcLinkDims.isDontcare()) {
-        // 4. Link doesn't care. We don't need to do anything.
-      } else if (srcLinkDims.isUnspecified()) {
-        // 5. srcRegion dims set link dims
+      // 6. Both region dims and link dims are specified.
+      // Verify that srcRegion dims are the same as
+      // link dims
+      if (srcRegionDims != srcLinkDims) {
+        Dimensions oneD(1);
 
-        if ((*l)->getSrc().isRegionLevel()) {
-          // 5.1 link source is region level, so use dimensions of [1]
+        bool inconsistentDimensions = false;
 
+        if (link->getSrc().isRegionLevel()) {
           Dimensions d;
           for (size_t i = 0; i < srcRegionDims.size(); i++) {
             d.push_back(1);
           }
 
-          (*l)->setSrcDimensions(d);
-          srcLinkDims = d;
+          if (srcLinkDims != d) {
+            NTA_THROW << "Internal error while processing Region "
+                      << srcRegion.getName() << ".  The link "
+                      << link->toString()
+                      << " has a region level source "
+                         "output, but the link dimensions are "
+                      << srcLinkDims.toString() << " instead of [1]";
+          }
+        } else if (srcRegionDims == oneD) {
+          Dimensions d;
+          for (size_t i = 0; i < srcLinkDims.size(); i++) {
+            d.push_back(1);
+          }
+
+          if (srcLinkDims != d) {
+            inconsistentDimensions = true;
+          }
         } else {
-          // 5.2 apply region dimensions to link
+          inconsistentDimensions = true;
+        }
+
+        if (inconsistentDimensions) {
+          NTA_THROW
+              << "Inconsistent dimension specification encountered. Region "
+              << srcRegion.getName() << " has dimensions "
+              << srcRegionDims.toString() << " but link " << link->toString()
+              << " requires dimensions " << srcLinkDims.toString()
+              << ". Additional information on "
+              << "region dimensions: "
+              << (srcRegion.getDimensionInfo() == ""
+                      ? "(none)"
+                      : srcRegion.getDimensionInfo());
+        }
+      }
+    }
+  }
+
+  /* ------ look at the destination side of the link ------- */
+  Dimensions destLinkDims = link->getDestDimensions();
+  Dimensions destRegionDims = destRegion.getDimensions();
+
+  // The logic here is similar to the logic for the source side
+  // except for the case where the destination region dims are specified and
+  // the link dims are unspecified -- see comment below.
+
+  /* dest region dimensions are unspecified */
+  if (destRegionDims.isUnspecified()) {
+    if (destLinkDims.isUnspecified()) {
+      // 1. link cares about dest dimensions but they aren't set
+      //    link is incomplete;  Nothing we can do.
+    } else if (destLinkDims.isDontcare()) {
+      // 2. Link doesn't care. We don't need to do anything.
+    } else {
+      // 3. Link specifies dest dimensions but region dimensions
+      // have not yet been set -- induce dimensions on the region.
+
+      // If dest region is initialized, this is a logic error
+      NTA_CHECK(!destRegion.isInitialized());
+
+      if (!(link->getDest().isRegionLevel())) {
+        // 3.1 Only set the dimensions if the link destination is not region
+        // level
 
-          (*l)->setSrcDimensions(srcRegionDims);
-          srcLinkDims = srcRegionDims;
+        // Set the dimensions and record that we set them
+        destRegion.setDimensions(destLinkDims);
+        destRegionDims = destRegion.getDimensions();
+        destRegion.setDimensionInfo(
+            "Specified by destination dimensions on link " + link->toString());
+      } else {
+        // 3.2 Link is incomplete
+      }
+    }
+  } else {
+    /* dest region dimensions are specified but src region dims are not */
+    if (destLinkDims.isDontcare()) {
+      // 4. Link doesn't care. We don't need to do anything.
+    } else if (destLinkDims.isUnspecified()) {
+      // 5. Region has dimensions -- set them on the link.
+
+      if (link->getDest().isRegionLevel()) {
+        // 5.1 link source is region level, so use dimensions of [1]
+
+        Dimensions d;
+        for (size_t i = 0; i < destRegionDims.size(); i++) {
+          d.push_back(1);
         }
+
+        link->setDestDimensions(d);
+        destLinkDims = d;
       } else {
-        // 6. Both region dims and link dims are specified.
-        // Verify that srcRegion dims are the same as
-        // link dims
-        if (srcRegionDims != srcLinkDims) {
-          Dimensions oneD(1);
-
-          bool inconsistentDimensions = false;
-
-          if ((*l)->getSrc().isRegionLevel()) {
-            Dimensions d;
-            for (size_t i = 0; i < srcRegionDims.size(); i++) {
-              d.push_back(1);
-            }
-
-            if (srcLinkDims != d) {
-              NTA_THROW << "Internal error while processing Region "
-                        << srcRegion.getName() << ".  The link "
-                        << (*l)->toString()
-                        << " has a region level source "
-                           "output, but the link dimensions are "
-                        << srcLinkDims.toString() << " instead of [1]";
-            }
-          } else if (srcRegionDims == oneD) {
-            Dimensions d;
-            for (size_t i = 0; i < srcLinkDims.size(); i++) {
-              d.push_back(1);
-            }
-
-            if (srcLinkDims != d) {
-              inconsistentDimensions = true;
-            }
-          } else {
-            inconsistentDimensions = true;
+        // 5.2 apply region dimensions to link
+
+        link->setDestDimensions(destRegionDims);
+        destLinkDims = destRegionDims;
+
+        // Setting the link dest dimensions may set the src
+        // dimensions. Since we have already evaluated the source
+        // side of the link, we need to re-evaluate here
+        if (srcRegionDims.isUnspecified()) {
+          srcLinkDims = link->getSrcDimensions();
+          if (!srcLinkDims.isUnspecified() && !srcLinkDims.isDontcare()) {
+            // Induce. TODO: code is the same as on source side -- refactor?
+            // If source region is initialized, this is a logic error
+            NTA_CHECK(!srcRegion.isInitialized());
+
+            // Set the dimensions and record that we set them
+            srcRegion.setDimensions(srcLinkDims);
+            srcRegionDims = srcRegion.getDimensions();
+
+            srcRegion.setDimensionInfo(
+                "Specified by source dimensions on link " + link->toString());
           }
 
-          if (inconsistentDimensions) {
+        } else {
+          // src region dims were already specified. Make sure they
+          // are compatible with the link dims.
+          if (srcLinkDims != srcRegionDims) {
             NTA_THROW
                 << "Inconsistent dimension specification encountered. Region "
                 << srcRegion.getName() << " has dimensions "
-                << srcRegionDims.toString() << " but link " << (*l)->toString()
-                << " requires dimensions " << srcLinkDims.toString()
-                << ". Additional information on "
+                << srcRegionDims.toString() << " but link "
+                << link->toString() << " requires dimensions "
+                << srcLinkDims.toString() << ". Additional information on "
                 << "region dimensions: "
                 << (srcRegion.getDimensionInfo() == ""
                         ? "(none)"
@@ -270,179 +374,74 @@ size_t Input::evaluateLinks() {
           }
         }
       }
-    }
 
-    /* ------ look at the destination side of the link ------- */
-    Dimensions destLinkDims = (*l)->getDestDimensions();
-    Dimensions destRegionDims = destRegion.getDimensions();
-
-    // The logic here is similar to the logic for the source side
-    // except for the case where the destination region dims are specified and
-    // the link dims are unspecified -- see comment below.
-
-    /* dest region dimensions are unspecified */
-    if (destRegionDims.isUnspecified()) {
-      if (destLinkDims.isUnspecified()) {
-        // 1. link cares about dest dimensions but they aren't set
-        //    link is incomplete;  Nothing we can do.
-      } else if (destLinkDims.isDontcare()) {
-        // 2. Link doesn't care. We don't need to do anything.
-      } else {
-        // 3. Link specifies dest dimensions but region dimensions
-        // have not yet been set -- induce dimensions on the region.
-
-        // If dest region is initialized, this is a logic error
-        NTA_CHECK(!destRegion.isInitialized());
-
-        if (!((*l)->getDest().isRegionLevel())) {
-          // 3.1 Only set the dimensions if the link destination is not region
-          // level
-
-          // Set the dimensions and record that we set them
-          destRegion.setDimensions(destLinkDims);
-          destRegionDims = destRegion.getDimensions();
-          std::stringstream ss;
-          ss << "Specified by destination dimensions on link "
-             << (*l)->toString();
-          destRegion.setDimensionInfo(ss.str());
-        } else {
-          // 3.2 Link is incomplete
-        }
-      }
     } else {
-      /* dest region dimensions are specified but src region dims are not */
-      if (destLinkDims.isDontcare()) {
-        // 4. Link doesn't care. We don't need to do anything.
-      } else if (destLinkDims.isUnspecified()) {
-        // 5. Region has dimensions -- set them on the link.
-
-        if ((*l)->getDest().isRegionLevel()) {
-          // 5.1 link source is region level, so use dimensions of [1]
-
+      // 6. link dims and region dims are specified.
+      // verify that destRegion dims are the same as
+      // link dims.
+      //
+
+      bool inconsistentDimensions = false;
+
+      if (destRegionDims != destLinkDims) {
+        Dimensions oneD;
+        oneD.push_back(1);
+
+        if (link->getDest().isRegionLevel()) {
+          if (!destLinkDims.isOnes())
+            NTA_THROW << "Internal error while processing Region "
+                      << destRegion.getName() << ".  The link "
+                      << link->toString()
+                      << " has a region level destination "
+                      << "input, but the link dimensions are "
+                      << destLinkDims.toString() << " instead of [1]";
+        } else if (destRegionDims == oneD) {
           Dimensions d;
-          for (size_t i = 0; i < destRegionDims.size(); i++) {
+          for (size_t i = 0; i < destLinkDims.size(); i++) {
             d.push_back(1);
           }
 
-          (*l)->setDestDimensions(d);
-          destLinkDims = d;
-        } else {
-          // 5.2 apply region dimensions to link
-
-          (*l)->setDestDimensions(destRegionDims);
-          destLinkDims = destRegionDims;
-
-          // Setting the link dest dimensions may set the src
-          // dimensions. Since we have already evaluated the source
-          // side of the link, we need to re-evaluate here
-          if (srcRegionDims.isUnspecified()) {
-            srcLinkDims = (*l)->getSrcDimensions();
-            if (!srcLinkDims.isUnspecified() && !srcLinkDims.isDontcare()) {
-              // Induce. TODO: code is the same as on source side -- refactor?
-              // If source region is initialized, this is a logic error
-              NTA_CHECK(!srcRegion.isInitialized());
-
-              // Set the dimensions and record that we set them
-              srcRegion.setDimensions(srcLinkDims);
-              srcRegionDims = srcRegion.getDimensions();
-
-              std::stringstream ss;
-              ss << "Specified by source dimensions on link "
-                 << (*l)->toString();
-              srcRegion.setDimensionInfo(ss.str());
-            }
-
-          } else {
-            // src region dims were already specified. Make sure they
-            // are compatible with the link dims.
-            if (srcLinkDims != srcRegionDims) {
-              NTA_THROW
-                  << "Inconsistent dimension specification encountered. Region "
-                  << srcRegion.getName() << " has dimensions "
-                  << srcRegionDims.toString() << " but link "
-                  << (*l)->toString() << " requires dimensions "
-                  << srcLinkDims.toString() << ". Additional information on "
-                  << "region dimensions: "
-                  << (srcRegion.getDimensionInfo() == ""
-                          ? "(none)"
-                          : srcRegion.getDimensionInfo());
-            }
-          }
-        }
-
-      } else {
-        // 6. link dims and region dims are specified.
-        // verify that destRegion dims are the same as
-        // link dims.
-        //
-
-        bool inconsistentDimensions = false;
-
-        if (destRegionDims != destLinkDims) {
-          Dimensions oneD;
-          oneD.push_back(1);
-
-          if ((*l)->getDest().isRegionLevel()) {
-            if (!destLinkDims.isOnes())
-              NTA_THROW << "Internal error while processing Region "
-                        << destRegion.getName() << ".  The link "
-                        << (*l)->toString()
-                        << " has a region level destination "
-                        << "input, but the link dimensions are "
-                        << destLinkDims.toString() << " instead of [1]";
-          } else if (destRegionDims == oneD) {
-            Dimensions d;
-            for (size_t i = 0; i < destLinkDims.size(); i++) {
-              d.push_back(1);
-            }
-
-            if (destLinkDims != d) {
-              inconsistentDimensions = true;
-            }
-          } else {
+          if (destLinkDims != d) {
             inconsistentDimensions = true;
           }
+        } else {
+          inconsistentDimensions = true;
+        }
 
-          if (inconsistentDimensions) {
-            NTA_THROW
-                << "Inconsistent dimension specification encountered. Region "
-                << destRegion.getName() << " has dimensions "
-                << destRegionDims.toString() << " but link " << (*l)->toString()
-                << " requires dimensions " << destLinkDims.toString()
-                << ". Additional information on "
-                << "region dimensions: "
-                << (destRegion.getDimensionInfo() == ""
-                        ? "(none)"
-                        : destRegion.getDimensionInfo());
-          }
+        if (inconsistentDimensions) {
+          NTA_THROW
+              << "Inconsistent dimension specification encountered. Region "
+              << destRegion.getName() << " has dimensions "
+              << destRegionDims.toString() << " but link " << link->toString()
+              << " requires dimensions " << destLinkDims.toString()
+              << ". Additional information on "
+              << "region dimensions: "
+              << (destRegion.getDimensionInfo() == ""
+                      ? "(none)"
+                      : destRegion.getDimensionInfo());
         }
       }
     }
+  }
 
-    bool linkIsIncomplete = true;
-    if (srcRegionDims.isSpecified() && destRegionDims.isSpecified()) {
-      linkIsIncomplete = false;
-      // link dims may be specified or dontcare (!isUnspecified)
-      NTA_CHECK(srcLinkDims.isSpecified() || srcLinkDims.isDontcare())
-          << "link: " << (*l)->toString()
-          << " src: " << srcRegionDims.toString()
-          << " dest: " << destRegionDims.toString()
-          << " srclinkdims: " << srcLinkDims.toString();
-
-      NTA_CHECK(destLinkDims.isSpecified() || destLinkDims.isDontcare())
-          << "link: " << (*l)->toString()
-          << " src: " << srcRegionDims.toString()
-          << " dest: " << destRegionDims.toString()
-          << " destlinkdims: " << destLinkDims.toString();
-    }
-
-    if (linkIsIncomplete) {
-      nIncompleteLinks++;
-    }
-
-  } // loop over all links connected to this Input
+  bool linkIsIncomplete = true;
+  if (srcRegionDims.isSpecified() && destRegionDims.isSpecified()) {
+    linkIsIncomplete = false;
+    // link dims may be specified or dontcare (!isUnspecified)
+    NTA_CHECK(srcLinkDims.isSpecified() || srcLinkDims.isDontcare())
+        << "link: " << link->toString()
+        << " src: " << srcRegionDims.toString()
+        << " dest: " << destRegionDims.toString()
+        << " srclinkdims: " << srcLinkDims.toString();
+
+    NTA_CHECK(destLinkDims.isSpecified() || destLinkDims.isDontcare())
+        << "link: " << link->toString()
+        << " src: " << srcRegionDims.toString()
+        << " dest: " << destRegionDims.toString()
+        << " destlinkdims: " << destLinkDims.toString();
+  }
 
-  return nIncompleteLinks;
+  return !linkIsIncomplete;
 }
 
 // Called after all links have been evaluated, and
@@ -477,12 +476,36 @@ void Input::initialize() {
     count += (*l)->getSrc().getData().getCount();
   }
 
-  // Later we may optimize with the zeroCopyEnabled_ flag but
-  // for now we always allocate our own buffer.
-  data_.allocateBuffer(count);
+  // With a single link without delay from another region's output of the
+  // same kind, a read-only input reads the output's buffer instead of
+  // keeping a copy. Any other input may be written to by its region, which
+  // would overwrite the output for all of its consumers. A region linked to
+  // itself keeps a copy too, since it would see its output change while it
+  // computes.
+  zeroCopy_ = false;
+  if (links_.size() == 1 && isReadOnly_) {
+    Link *link = links_[0];
+    Output &src = link->getSrc();
+    const Array &srcData = src.getData();
+    zeroCopy_ = link->getPropagationDelay() == 0 &&
+                &src.getRegion() != &region_ &&
+                src.isSparse() == isSparse_ &&
+                srcData.getType() == data_.getType();
+  }
+
+  if (zeroCopy_) {
+    // Array hides setBuffer since it usually owns its buffer. Here the
+    // output owns it, and outlives this input's initialization.
+    const Array &srcData = links_[0]->getSrc().getData();
+    static_cast<ArrayBase &>(data_).setBuffer(srcData.getBuffer(),
+                                              srcData.getMaxElementsCount());
+    data_.setCount(srcData.getCount());
+  } else {
+    data_.allocateBuffer(count);
+  }
 
   // Zero the inputs (required for inspectors)
-  if (count != 0) {
+  if (count != 0 && !zeroCopy_) {
     void *buffer = data_.getBuffer();
     ::memset(buffer, 0, data_.getBufferSize());
     if (isSparse_) {
@@ -490,21 +513,10 @@ void Input::initialize() {
     }
   }
 
+  // The splitter map is built by getSplitterMap(), only for the regions
+  // that use it.
   NTA_CHECK(splitterMap_.size() == 0);
 
-  // create the splitter map by getting the contributions
-  // from each link.
-  if (isRegionLevel_) {
-    splitterMap_.resize(1);
-  } else {
-    splitterMap_.resize(region_.getDimensions().getCount());
-  }
-
-  for (std::vector<Link *>::const_iterator link = links_.begin();
-       link != links_.end(); link++) {
-    (*link)->buildSplitterMap(splitterMap_);
-  }
-
   initialized_ = true;
 }
 
@@ -515,6 +527,7 @@ void Input::uninitialize() {
   NTA_CHECK(!region_.isInitialized());
 
   initialized_ = false;
+  zeroCopy_ = false;
   data_.releaseBuffer();
   splitterMap_.clear();
 }
@@ -527,10 +540,25 @@ const std::string &Input::getName() const { return name_; }
 
 const std::vector<std::vector<size_t>> &Input::getSplitterMap() const {
   NTA_CHECK(initialized_);
-  // Originally the splitter map was created on demand in this method.
-  // For now we have moved splitter map creation to initialize() because
-  // we have dual heap/libstdc++ allocation/deallocation problems if
-  // this method is called from a node DLL/.so (including pynode).
+
+  // Built on first use: for a hierarchy with large fan-in, the splitter maps
+  // of all the inputs can take longer to build than the rest of the
+  // initialization, and most regions never ask for them. The map is
+  // allocated by this library whoever calls this, so it is released by
+  // uninitialize() with the same allocator.
+  if (splitterMap_.empty()) {
+    // create the splitter map by getting the contributions
+    // from each link.
+    if (isRegionLevel_) {
+      splitterMap_.resize(1);
+    } else {
+      splitterMap_.resize(region_.getDimensions().getCount());
+    }
+
+    for (auto link : links_) {
+      link->buildSplitterMap(splitterMap_);
+    }
+  }
 
   return splitterMap_;
 }
@@ -64,9 +64,12 @@ public:
    *        Whether the input is region level, i.e. TODO
    * @param isSparse
    *        Whether the input is sparse. Default false
+   * @param isReadOnly
+   *        Whether the region never writes to the input's data. Default
+   *        false
    */
   Input(Region &region, NTA_BasicType type, bool isRegionLevel,
-        bool isSparse = false);
+        bool isSparse = false, bool isReadOnly = false);
 
   /**
    *
@@ -192,8 +195,16 @@ public:
   bool isRegionLevel();
 
   /**
-   * Called by Region.evaluateLinks() as part
-   * of network initialization.
+   * Evaluates all the links of the input, see evaluateLink().
+   *
+   * @returns
+   *         Number of links that could not be fully evaluated, i.e. incomplete
+   */
+  size_t evaluateLinks();
+
+  /**
+   * Called by Network::initialize() for each link of the input
+   * as part of network initialization.
    *
    * 1. Tries to make sure that dimensions at both ends
    *    of a link are specified by calling setSourceDimensions()
@@ -203,16 +214,26 @@ public:
    *    where links "induce" dimensions) or by raising an exception
    *    if they are inconsistent.
    *
+   * Network::initialize() evaluates a link again whenever the evaluation
+   * of another link has induced dimensions on one of its regions.
+   *
+   * @param link
+   *        One of the links of the input
+   *
    * @returns
-   *         Number of links that could not be fully evaluated, i.e. incomplete
+   *         Whether the link could be fully evaluated
    */
-  size_t evaluateLinks();
+  bool evaluateLink(Link *link);
 
   /**
    * Initialize the Input .
    *
    * After the input has all the information it needs, it is initialized by
    * this method. Volatile data structures (e.g. the input buffer) are set up。
+   *
+   * A read-only input with a single link, without propagation delay, from
+   * an output of another region with the same type and sparsity, reads that
+   * output's buffer directly instead of a copy of it.
    */
   void initialize();
 
@@ -235,7 +256,8 @@ public:
 
   /**
    *
-   * Get splitter map from an initialized input
+   * Get splitter map from an initialized input. The map is built on the
+   * first call.
    *
    * @returns
    *         The splitter map
@@ -254,10 +276,19 @@ public:
    */
   bool isSparse();
 
+  /*
+   * Tells whether the input reads its output's buffer instead of a copy.
+   * Only valid once initialized.
+   *
+   * @returns
+   *     Whether the input's data is the output's data
+   */
+  bool isZeroCopy() const;
+
 private:
   Region &region_;
   // buffer is concatenation of input buffers (after prepare), or,
-  // if zeroCopyEnabled it points to the connected output
+  // if zeroCopy_ it points to the connected output
   bool isRegionLevel_;
 
   // Use a vector of links because order is important.
@@ -288,6 +319,10 @@ private:
   // Whether or not to use sparse data
   bool isSparse_;
 
+  // Whether the region never writes to data_, which allows zero copy
+  bool isReadOnly_;
+  bool zeroCopy_;
+
   // Internal methods
 
   /*
@@ -23,6 +23,7 @@
 /** @file
  * Implementation of the Link class
  */
+#include <algorithm>
 #include <cstring> // memcpy,memset
 #include <nupic/engine/Input.hpp>
 #include <nupic/engine/Link.hpp>
@@ -30,33 +31,165 @@
 #include <nupic/engine/LinkPolicyFactory.hpp>
 #include <nupic/engine/Output.hpp>
 #include <nupic/engine/Region.hpp>
+#include <nupic/math/VectorKernels.hpp>
 #include <nupic/ntypes/Array.hpp>
 #include <nupic/types/BasicType.hpp>
 #include <nupic/utils/ArrayProtoUtils.hpp>
 #include <nupic/utils/Log.hpp>
 
+#ifdef NTA_AVX_DISPATCH
+#include <immintrin.h>
+#endif
+
 // Set this to true when debugging to enable handy debug-level logging of data
 // moving through the links, including the delayed link transitions.
 #define _LINK_DEBUG false
 
 namespace nupic {
 
-// Represents 'zero' scalar value used to compare Input/Output buffer contents
-// for non-zero values
-const static NTA_Real64 ZERO_VALUE = 0;
+// Dense to sparse conversion. An element is non-zero when any of its bytes
+// is, so the kernels only depend on the size of the element type, which
+// covers every scalar type a dense output can have. Each kernel writes the
+// indices of the non-zero elements among the first n of src to indices, and
+// returns their number. Bounds are checked once per block of elements.
+
+static inline void checkSparseCapacity_(size_t needed, size_t capacity) {
+  NTA_CHECK(needed <= capacity) << "Link destination is too small. "
+                                << "It should be at least " << needed;
+}
+
+// Bits of a mask with one bit per byte, keeping the lowest bit of each
+// element of ElementSize bytes, set when any byte of that element is set.
+template <size_t ElementSize>
+static inline NTA_UInt64 foldByteMask_(NTA_UInt64 m);
+
+template <> inline NTA_UInt64 foldByteMask_<1>(NTA_UInt64 m) { return m; }
+
+template <> inline NTA_UInt64 foldByteMask_<2>(NTA_UInt64 m) {
+  return (m | (m >> 1)) & 0x5555555555555555ULL;
+}
+
+template <> inline NTA_UInt64 foldByteMask_<4>(NTA_UInt64 m) {
+  m |= m >> 1;
+  m |= m >> 2;
+  return m & 0x1111111111111111ULL;
+}
+
+template <> inline NTA_UInt64 foldByteMask_<8>(NTA_UInt64 m) {
+  m |= m >> 1;
+  m |= m >> 2;
+  m |= m >> 4;
+  return m & 0x0101010101010101ULL;
+}
+
+static inline UInt lowestBit_(NTA_UInt64 m) {
+#if defined(NTA_COMPILER_GNU) || defined(NTA_COMPILER_CLANG)
+  return (UInt)__builtin_ctzll(m);
+#else
+  UInt b = 0;
+  while (!(m & 1)) {
+    m >>= 1;
+    ++b;
+  }
+  return b;
+#endif
+}
+
+// Appends first + b / ElementSize for every bit b of an element mask
+template <size_t ElementSize>
+static inline size_t emitIndices_(NTA_UInt64 m, size_t first,
+                                  NTA_UInt32 *indices, size_t count) {
+  for (; m; m &= m - 1) {
+    indices[count++] = (NTA_UInt32)(first + lowestBit_(m) / ElementSize);
+  }
+  return count;
+}
+
+template <typename Element>
+static size_t denseToSparseTail_(const Element *src, size_t begin, size_t n,
+                                 NTA_UInt32 *indices, size_t count,
+                                 size_t capacity) {
+  for (size_t i = begin; i < n; ++i) {
+    if (src[i]) {
+      checkSparseCapacity_(count + 1, capacity);
+      indices[count++] = (NTA_UInt32)i;
+    }
+  }
+  return count;
+}
+
+// Elements are read as unsigned integers of their size, so that e.g. -0.0
+// is non-zero, the same as a byte-wise comparison.
+template <typename Element>
+static size_t denseToSparseWords_(const Element *src, size_t n,
+                                  NTA_UInt32 *indices, size_t capacity) {
+  const size_t perWord = sizeof(NTA_UInt64) / sizeof(Element);
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + perWord <= n; i += perWord) {
+    NTA_UInt64 word;
+    ::memcpy(&word, src + i, sizeof(word));
+    if (!word) {
+      continue;
+    }
+    for (size_t j = i; j < i + perWord; ++j) {
+      if (src[j]) {
+        checkSparseCapacity_(count + 1, capacity);
+        indices[count++] = (NTA_UInt32)j;
+      }
+    }
+  }
+  return denseToSparseTail_(src, i, n, indices, count, capacity);
+}
+
+#ifdef NTA_AVX_DISPATCH
+template <typename Element>
+__attribute__((target("avx2"))) static size_t
+denseToSparseAvx2_(const Element *src, size_t n, NTA_UInt32 *indices,
+                   size_t capacity) {
+  const size_t perBlock = 32 / sizeof(Element);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + perBlock <= n; i += perBlock) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+    const NTA_UInt32 zeroBytes =
+        (NTA_UInt32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero));
+    if (zeroBytes == 0xFFFFFFFFU) {
+      continue;
+    }
+    const NTA_UInt64 m =
+        foldByteMask_<sizeof(Element)>((NTA_UInt64)(~zeroBytes));
+    checkSparseCapacity_(count + __builtin_popcountll(m), capacity);
+    count = emitIndices_<sizeof(Element)>(m, i, indices, count);
+  }
+  return denseToSparseTail_(src, i, n, indices, count, capacity);
+}
+#endif
+
+template <typename Element>
+static inline size_t denseToSparse_(const void *src, size_t n,
+                                    NTA_UInt32 *indices, size_t capacity) {
+#ifdef NTA_AVX_DISPATCH
+  if (math::kernels::cpuHasAvx2()) {
+    return denseToSparseAvx2_((const Element *)src, n, indices, capacity);
+  }
+#endif
+  return denseToSparseWords_((const Element *)src, n, indices, capacity);
+}
 
 Link::Link(const std::string &linkType, const std::string &linkParams,
            const std::string &srcRegionName, const std::string &destRegionName,
            const std::string &srcOutputName, const std::string &destInputName,
            const size_t propagationDelay)
-    : srcBuffer_(0) {
+    : srcBuffer_(0), srcBufferHead_(0) {
   commonConstructorInit_(linkType, linkParams, srcRegionName, destRegionName,
                          srcOutputName, destInputName, propagationDelay);
 }
 
 Link::Link(const std::string &linkType, const std::string &linkParams,
            Output *srcOutput, Input *destInput, const size_t propagationDelay)
-    : srcBuffer_(0) {
+    : srcBuffer_(0), srcBufferHead_(0) {
   commonConstructorInit_(linkType, linkParams, srcOutput->getRegion().getName(),
                          destInput->getRegion().getName(), srcOutput->getName(),
                          destInput->getName(), propagationDelay);
@@ -66,7 +199,7 @@ Link::Link(const std::string &linkType, const std::string &linkParams,
   // initialization time
 }
 
-Link::Link() : srcBuffer_(0) {}
+Link::Link() : srcBuffer_(0), srcBufferHead_(0) {}
 
 void Link::commonConstructorInit_(const std::string &linkType,
                                   const std::string &linkParams,
@@ -104,6 +237,7 @@ void Link::initPropagationDelayBuffer_(size_t propagationDelay,
 
   // Establish capacity for the requested delay data elements
   srcBuffer_.set_capacity(propagationDelay);
+  srcBufferHead_ = 0;
 
   // Initialize delay data elements
   size_t dataBufferSize = original.getBufferSize();
@@ -249,6 +383,8 @@ const std::string &Link::getDestRegionName() const { return destRegionName_; }
 
 const std::string &Link::getDestInputName() const { return destInputName_; }
 
+size_t Link::getPropagationDelay() const { return propagationDelay_; }
+
 std::string Link::getMoniker() const {
   std::stringstream ss;
   ss << getSrcRegionName() << "." << getSrcOutputName() << "-->"
@@ -329,10 +465,20 @@ void Link::compute() {
 
   // Copy data from source to destination. For delayed links, will copy from
   // head of circular queue; otherwise directly from source.
-  const Array &src = propagationDelay_ ? srcBuffer_[0] : src_->getData();
+  const Array &src =
+      propagationDelay_ ? srcBuffer_[srcBufferHead_] : src_->getData();
 
   const Array &dest = dest_->getData();
 
+  if (dest_->isZeroCopy()) {
+    // The input reads the output's buffer, only the count may change.
+    if (dest_->isSparse()) {
+      // Remove 'const' to update the variable length array
+      const_cast<Array &>(dest).setCount(src.getCount());
+    }
+    return;
+  }
+
   size_t srcSize = src.getBufferSize();
   size_t typeSize = BasicType::getSize(src.getType());
   size_t destByteOffset = destOffset_ * typeSize;
@@ -360,16 +506,29 @@ void Link::compute() {
 
     // Dense source can be any scalar type. The scalar values will be lost
     // and only the indexes of the non-zero values will be stored.
-    char *srcBuf = (char *)src.getBuffer();
-    size_t destLen = dest.getBufferSize();
-    size_t destIdx = 0;
-    for (size_t i = 0; i < srcSize; i++) {
-      // Check for any non-zero scalar value
-      if (::memcmp(srcBuf + i * typeSize, &ZERO_VALUE, typeSize)) {
-        NTA_CHECK(destIdx < destLen) << "Link destination is too small. "
-                                     << "It should be at least " << destIdx + 1;
-        destBuf[destIdx++] = i;
-      }
+    size_t srcLen = srcSize / typeSize;
+    size_t destLen = dest.getMaxElementsCount() - destOffset_;
+    size_t destIdx;
+    switch (typeSize) {
+    case 1:
+      destIdx = denseToSparse_<NTA_Byte>(src.getBuffer(), srcLen, destBuf,
+                                         destLen);
+      break;
+    case 2:
+      destIdx = denseToSparse_<NTA_UInt16>(src.getBuffer(), srcLen, destBuf,
+                                           destLen);
+      break;
+    case 4:
+      destIdx = denseToSparse_<NTA_UInt32>(src.getBuffer(), srcLen, destBuf,
+                                           destLen);
+      break;
+    case 8:
+      destIdx = denseToSparse_<NTA_UInt64>(src.getBuffer(), srcLen, destBuf,
+                                           destLen);
+      break;
+    default:
+      NTA_THROW << "Link::compute: unsupported element size " << typeSize
+                << " for a dense to sparse link";
     }
     // Remove 'const' to update the variable length array
     const_cast<Array &>(dest).setCount(destIdx);
@@ -383,14 +542,21 @@ void Link::compute() {
     bool *destBuf = (bool *)((char *)dest.getBuffer() + destByteOffset);
 
     size_t srcLen = src.getCount();
-    size_t destLen = dest.getBufferSize();
+    size_t destLen = dest.getBufferSize() - destByteOffset;
+
+    // Validate all the indices before writing any of them, which keeps the
+    // scatter loop below free of branches.
+    NTA_UInt32 maxIdx = 0;
+    for (size_t i = 0; i < srcLen; i++) {
+      maxIdx = std::max(maxIdx, srcBuf[i]);
+    }
+    NTA_CHECK(srcLen == 0 || maxIdx < destLen)
+        << "Link destination is too small. "
+        << "It should be at least " << maxIdx + 1;
+
     ::memset(destBuf, 0, destLen);
-    size_t destIdx;
     for (size_t i = 0; i < srcLen; i++) {
-      destIdx = srcBuf[i];
-      NTA_CHECK(destIdx < destLen) << "Link destination is too small. "
-                                   << "It should be at least " << destIdx + 1;
-      destBuf[destIdx] = true;
+      destBuf[srcBuf[i]] = true;
     }
   }
 }
@@ -401,23 +567,20 @@ void Link::shiftBufferedData() {
     return;
   }
 
-  // A delayed link's circular buffer should always be at capacity, because
-  // it starts out full in link initialization and we always append the new
-  // source value after shifting out the head.
+  // A delayed link's circular buffer is filled at link initialization and
+  // its arrays are reused from then on, the head index rotating over them.
   NTA_CHECK(srcBuffer_.full());
 
-  // Pop head of circular queue
+  // The head was consumed by compute() in this iteration. Overwrite it with
+  // the current src value, which makes it the tail once the head moves on.
+  Array &slot = srcBuffer_[srcBufferHead_];
 
   if (_LINK_DEBUG) {
     NTA_DEBUG << "Link::shiftBufferedData: " << getMoniker()
-              << "; popping head; " << srcBuffer_[0].getCount()
-              << " elements=" << srcBuffer_[0];
+              << "; replacing head; " << slot.getCount()
+              << " elements=" << slot;
   }
 
-  srcBuffer_.pop_front();
-
-  // Append the current src value to circular queue
-
   const Array &srcArray = src_->getData();
   size_t elementCount = srcArray.getCount();
   auto elementType = srcArray.getType();
@@ -430,23 +593,27 @@ void Link::shiftBufferedData() {
               << " elements=" << srcArray;
 
     NTA_DEBUG << "Link::shiftBufferedData: " << getMoniker()
-              << "; num arrays in circular buffer before append; "
-              << srcBuffer_.size() << "; capacity=" << srcBuffer_.capacity();
+              << "; head index before append; " << srcBufferHead_
+              << "; capacity=" << srcBuffer_.capacity();
   }
 
-  Array array(elementType);
-  srcBuffer_.push_back(array);
-
-  auto &lastElement = srcBuffer_.back();
-  lastElement.allocateBuffer(maxElementCount);
-  ::memcpy(lastElement.getBuffer(), srcArray.getBuffer(),
+  if (slot.getMaxElementsCount() < maxElementCount) {
+    // Deserialized arrays are only as large as their contents. Give them
+    // the size of the source once.
+    slot.releaseBuffer();
+    slot.allocateBuffer(maxElementCount);
+  }
+  ::memcpy(slot.getBuffer(), srcArray.getBuffer(),
            elementCount * BasicType::getSize(elementType));
-  lastElement.setCount(elementCount);
+  slot.setCount(elementCount);
+
+  srcBufferHead_ = (srcBufferHead_ + 1) % propagationDelay_;
 
   if (_LINK_DEBUG) {
     NTA_DEBUG << "Link::shiftBufferedData: " << getMoniker()
               << "; circular buffer head after append is: "
-              << srcBuffer_[0].getCount() << " elements=" << srcBuffer_[0];
+              << srcBuffer_[srcBufferHead_].getCount()
+              << " elements=" << srcBuffer_[srcBufferHead_];
   }
 }
 
@@ -461,8 +628,9 @@ void Link::write(LinkProto::Builder &proto) const {
   // Save delayed outputs
   auto delayedOutputsBuilder = proto.initDelayedOutputs(propagationDelay_);
   for (size_t i = 0; i < propagationDelay_; ++i) {
-    ArrayProtoUtils::copyArrayToArrayProto(srcBuffer_[i],
-                                           delayedOutputsBuilder[i]);
+    ArrayProtoUtils::copyArrayToArrayProto(
+        srcBuffer_[(srcBufferHead_ + i) % propagationDelay_],
+        delayedOutputsBuilder[i]);
   }
 }
 
@@ -267,6 +267,15 @@ public:
    */
   const std::string &getDestInputName() const;
 
+  /**
+   * Get the propagation delay of the link.
+   *
+   * @returns
+   *         The number of iterations by which the data is delayed, 0 if the
+   *         destination gets the data in the same iteration
+   */
+  size_t getPropagationDelay() const;
+
   /**
    * @}
    *
@@ -454,8 +463,11 @@ private:
   size_t srcOffset_;
   size_t srcSize_;
 
-  // Circular buffer for delayed source data buffering
+  // Circular buffer for delayed source data buffering. It is filled once,
+  // and srcBufferHead_ is the index of the oldest element, the one the
+  // destination gets in the current iteration.
   boost::circular_buffer<Array> srcBuffer_;
+  size_t srcBufferHead_;
   // Number of delay slots
   size_t propagationDelay_;
 
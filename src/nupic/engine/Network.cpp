@@ -24,14 +24,24 @@
 Implementation of the Network class
 */
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 #include <nupic/engine/Input.hpp>
 #include <nupic/engine/Link.hpp>
 #include <nupic/engine/Network.hpp>
+#include <nupic/engine/NetworkCheckpoint.hpp>
+#include <nupic/engine/NetworkInputSource.hpp>
+#include <nupic/engine/NetworkOutputSink.hpp>
 #include <nupic/engine/NuPIC.hpp> // for register/unregister
 #include <nupic/engine/Output.hpp>
 #include <nupic/engine/Region.hpp>
@@ -39,6 +49,7 @@ Implementation of the Network class
 #include <nupic/ntypes/BundleIO.hpp>
 #include <nupic/os/Directory.hpp>
 #include <nupic/os/FStream.hpp>
+#include <nupic/os/CycleClock.hpp>
 #include <nupic/os/Path.hpp>
 #include <nupic/proto/NetworkProto.capnp.h>
 #include <nupic/proto/RegionProto.capnp.h>
@@ -51,6 +62,111 @@ namespace nupic {
 
 class GenericRegisteredRegionImpl;
 
+/**
+ * Computes the regions of a phase on a pool of threads, in an order allowed
+ * by the phase's schedule.
+ *
+ * Regions become ready when all their dependencies have been computed, and
+ * ready regions are picked up by whichever thread is free, including the one
+ * that called run(). If a region throws, the regions that haven't started
+ * yet are skipped and run() rethrows the first exception.
+ */
+class RegionScheduler {
+public:
+  RegionScheduler(Network &network, UInt32 numThreads)
+      : network_(network), phase_(nullptr), stop_(false) {
+    for (UInt32 i = 1; i < numThreads; i++)
+      workers_.emplace_back(&RegionScheduler::work_, this);
+  }
+
+  ~RegionScheduler() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    changed_.notify_all();
+    for (auto &worker : workers_)
+      worker.join();
+  }
+
+  void run(const Network::PhaseSchedule &phase) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    phase_ = &phase;
+    remaining_ = phase.numDependencies;
+    pending_ = phase.regions.size();
+    error_ = nullptr;
+    for (UInt32 i = 0; i < phase.regions.size(); i++) {
+      if (remaining_[i] == 0)
+        ready_.push_back(i);
+    }
+    changed_.notify_all();
+
+    while (pending_ > 0) {
+      if (ready_.empty())
+        changed_.wait(lock);
+      else
+        runOne_(lock);
+    }
+    phase_ = nullptr;
+
+    if (error_)
+      std::rethrow_exception(error_);
+  }
+
+private:
+  // Computes one ready region. Called with the lock held, which is released
+  // while the region computes.
+  void runOne_(std::unique_lock<std::mutex> &lock) {
+    const UInt32 i = ready_.back();
+    ready_.pop_back();
+    Region *r = phase_->regions[i];
+    const bool skip = error_ != nullptr;
+
+    lock.unlock();
+    std::exception_ptr error;
+    if (!skip) {
+      try {
+        network_.computeRegion_(r);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    lock.lock();
+
+    if (error && !error_)
+      error_ = error;
+    for (UInt32 j : phase_->dependents[i]) {
+      if (--remaining_[j] == 0)
+        ready_.push_back(j);
+    }
+    pending_--;
+    changed_.notify_all();
+  }
+
+  void work_() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      changed_.wait(lock, [this] { return stop_ || !ready_.empty(); });
+      if (stop_)
+        return;
+      runOne_(lock);
+    }
+  }
+
+  Network &network_;
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+
+  // State of the phase being run, guarded by mutex_
+  const Network::PhaseSchedule *phase_;
+  std::vector<UInt32> remaining_;
+  std::vector<UInt32> ready_;
+  size_t pending_;
+  std::exception_ptr error_;
+  bool stop_;
+};
+
 Network::Network() {
   commonInit();
   NuPIC::registerNetwork(this);
@@ -67,6 +183,9 @@ void Network::commonInit() {
   iteration_ = 0;
   minEnabledPhase_ = 0;
   maxEnabledPhase_ = 0;
+  runThreads_ = 1;
+  scheduler_ = nullptr;
+  profiling_ = false;
   // automatic initialization of NuPIC, so users don't
   // have to call NuPIC::initialize
   NuPIC::init();
@@ -74,6 +193,7 @@ void Network::commonInit() {
 
 Network::~Network() {
   NuPIC::unregisterNetwork(this);
+  delete scheduler_;
   /**
    * Teardown choreography:
    * - unitialize all regions because otherwise we won't be able to disconnect
@@ -96,9 +216,7 @@ Network::~Network() {
 
   // 3. delete the regions
   for (size_t i = 0; i < regions_.getCount(); i++) {
-    std::pair<std::string, Region *> &item = regions_.getByIndex(i);
-    delete item.second;
-    item.second = nullptr;
+    delete regions_.getByIndex(i).second;
   }
 }
 
@@ -185,26 +303,22 @@ void Network::setPhases_(Region *r, std::set<UInt32> &phases) {
 
     phaseInfo_.resize(maxNewPhase + 1);
   }
-  for (UInt i = 0; i < phaseInfo_.size(); i++) {
-    bool insertPhase = false;
-    if (phases.find(i) != phases.end())
-      insertPhase = true;
-
-    // remove previous settings for this region
-    std::set<Region *>::iterator item;
-    item = phaseInfo_[i].find(r);
-    if (item != phaseInfo_[i].end() && !insertPhase) {
-      phaseInfo_[i].erase(item);
-    } else if (insertPhase) {
-      phaseInfo_[i].insert(r);
-    }
+  // remove previous settings for this region. The region keeps track of
+  // its phases, so only those need to be visited, not every phase of the
+  // network.
+  for (UInt32 phase : r->getPhases()) {
+    if (phase < phaseInfo_.size() && phases.find(phase) == phases.end())
+      phaseInfo_[phase].erase(r);
   }
+  for (UInt32 phase : phases)
+    phaseInfo_[phase].insert(r);
 
   // keep track (redundantly) of phases inside the Region also, for
   // serialization
   r->setPhases(phases);
 
   resetEnabledPhases_();
+  schedule_.clear();
 }
 
 void Network::resetEnabledPhases_() {
@@ -271,8 +385,17 @@ void Network::removeRegion(const std::string &name) {
   }
   resetEnabledPhases_();
 
+  prepareProfiles_.erase(r);
+  computeProfiles_.erase(r);
+  for (const auto &inputTuple : r->getInputs()) {
+    for (const auto pLink : inputTuple.second->getLinks())
+      linkProfiles_.erase(pLink);
+  }
+
   // Region destructor cleans up all incoming links
   delete r;
+  collectDelayedLinks_();
+  schedule_.clear();
 
   return;
 }
@@ -341,6 +464,9 @@ void Network::link(const std::string &srcRegionName,
   auto link =
       new Link(linkType, linkParams, srcOutput, destInput, propagationDelay);
   destInput->addLink(link, srcOutput);
+  if (propagationDelay != 0)
+    delayedLinks_.push_back(link);
+  schedule_.clear();
 }
 
 void Network::removeLink(const std::string &srcRegionName,
@@ -384,7 +510,10 @@ void Network::removeLink(const std::string &srcRegionName,
               << destRegionName << " input " << destInput->getName();
 
   // Finally, remove the link
+  linkProfiles_.erase(link);
   destInput->removeLink(link);
+  collectDelayedLinks_();
+  schedule_.clear();
 }
 
 void Network::run(int n) {
@@ -395,43 +524,217 @@ void Network::run(int n) {
   if (phaseInfo_.empty())
     return;
 
+  prepareRun_();
+
+  for (int iter = 0; iter < n; iter++) {
+    runIteration_();
+  }
+
+  return;
+}
+
+void Network::runBatch(UInt64 n, NetworkInputSource *source,
+                       NetworkOutputSink *sink) {
+  if (!initialized_) {
+    initialize();
+  }
+
+  if (source)
+    source->start(*this, n);
+  if (sink)
+    sink->start(*this, n);
+
+  if (phaseInfo_.empty())
+    return;
+
+  prepareRun_();
+
+  for (UInt64 iter = 0; iter < n; iter++) {
+    if (source)
+      source->apply(iter);
+    runIteration_();
+    if (sink)
+      sink->capture(iter);
+  }
+}
+
+void Network::prepareRun_() {
   NTA_CHECK(maxEnabledPhase_ < phaseInfo_.size())
       << "maxphase: " << maxEnabledPhase_ << " size: " << phaseInfo_.size();
 
-  for (int iter = 0; iter < n; iter++) {
-    iteration_++;
+  if (scheduler_ && schedule_.empty())
+    buildSchedule_();
 
-    // compute on all enabled regions in phase order
-    for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
-      for (auto r : phaseInfo_[phase]) {
-        r->prepareInputs();
-        r->compute();
-      }
+  if (profiling_)
+    addProfiles_();
+}
+
+void Network::runIteration_() {
+  iteration_++;
+
+  // Callbacks may turn profiling on or off, so both ends of a
+  // measurement check the value it started with.
+  const bool profiling = profiling_;
+  const UInt64 iterationStart = profiling ? CycleClock::now() : 0;
+
+  // compute on all enabled regions in phase order
+  for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+    const UInt64 phaseStart = profiling ? CycleClock::now() : 0;
+
+    if (scheduler_) {
+      scheduler_->run(schedule_[phase]);
+    } else {
+      for (auto r : phaseInfo_[phase])
+        computeRegion_(r);
     }
 
-    // invoke callbacks
-    for (UInt32 i = 0; i < callbacks_.getCount(); i++) {
-      std::pair<std::string, callbackItem> &callback = callbacks_.getByIndex(i);
-      callback.second.first(this, iteration_, callback.second.second);
+    if (profiling && phase < phaseProfiles_.size())
+      phaseProfiles_[phase].record(CycleClock::now() - phaseStart);
+  }
+
+  // invoke callbacks
+  for (UInt32 i = 0; i < callbacks_.getCount(); i++) {
+    const std::pair<std::string, callbackItem> &callback =
+        callbacks_.getByIndex(i);
+    const UInt64 callbackStart = profiling ? CycleClock::now() : 0;
+    callback.second.first(this, iteration_, callback.second.second);
+    if (profiling) {
+      callbackProfiles_[callback.first].record(CycleClock::now() -
+                                               callbackStart);
     }
+  }
 
-    // Refresh all links in the network at the end of every timestamp so that
-    // data in delayed links appears to change atomically between iterations
-    for (size_t i = 0; i < regions_.getCount(); i++) {
-      const Region *r = regions_.getByIndex(i).second;
+  // Refresh all delayed links in the network at the end of every timestamp
+  // so that their data appears to change atomically between iterations
+  const UInt64 shiftStart = profiling ? CycleClock::now() : 0;
+  for (const auto pLink : delayedLinks_) {
+    pLink->shiftBufferedData();
+  }
+
+  if (profiling) {
+    const UInt64 end = CycleClock::now();
+    shiftProfile_.record(end - shiftStart);
+    iterationProfile_.record(end - iterationStart);
+  }
+}
+
+void Network::computeRegion_(Region *r) {
+  if (!profiling_) {
+    r->prepareInputs();
+    r->compute();
+    return;
+  }
+
+  // Same as Region::prepareInputs(), one link at a time
+  const UInt64 prepareStart = CycleClock::now();
+  for (const auto &inputTuple : r->getInputs()) {
+    for (const auto pLink : inputTuple.second->getLinks()) {
+      const UInt64 linkStart = CycleClock::now();
+      pLink->compute();
+      auto profile = linkProfiles_.find(pLink);
+      if (profile != linkProfiles_.end())
+        profile->second.record(CycleClock::now() - linkStart);
+    }
+  }
+
+  const UInt64 computeStart = CycleClock::now();
+  r->compute();
+  const UInt64 end = CycleClock::now();
+
+  auto prepareProfile = prepareProfiles_.find(r);
+  if (prepareProfile != prepareProfiles_.end())
+    prepareProfile->second.record(computeStart - prepareStart);
+  auto computeProfile = computeProfiles_.find(r);
+  if (computeProfile != computeProfiles_.end())
+    computeProfile->second.record(end - computeStart);
+}
 
-      for (const auto &inputTuple : r->getInputs()) {
+void Network::addProfiles_() {
+  if (phaseProfiles_.size() < phaseInfo_.size())
+    phaseProfiles_.resize(phaseInfo_.size());
+
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    const Region *r = regions_.getByIndex(i).second;
+    prepareProfiles_[r];
+    computeProfiles_[r];
+
+    for (const auto &inputTuple : r->getInputs()) {
+      for (const auto pLink : inputTuple.second->getLinks())
+        linkProfiles_[pLink];
+    }
+  }
+}
+
+void Network::collectDelayedLinks_() {
+  delayedLinks_.clear();
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    const Region *r = regions_.getByIndex(i).second;
+
+    for (const auto &inputTuple : r->getInputs()) {
+      for (const auto pLink : inputTuple.second->getLinks()) {
+        if (pLink->getPropagationDelay() != 0)
+          delayedLinks_.push_back(pLink);
+      }
+    }
+  }
+}
+
+void Network::buildSchedule_() {
+  schedule_.assign(phaseInfo_.size(), PhaseSchedule());
+
+  for (size_t phase = 0; phase < phaseInfo_.size(); phase++) {
+    PhaseSchedule &schedule = schedule_[phase];
+    schedule.regions.assign(phaseInfo_[phase].begin(), phaseInfo_[phase].end());
+    schedule.numDependencies.assign(schedule.regions.size(), 0);
+    schedule.dependents.resize(schedule.regions.size());
+
+    std::map<const Region *, UInt32> order;
+    for (UInt32 i = 0; i < schedule.regions.size(); i++)
+      order[schedule.regions[i]] = i;
+
+    // A link without delay makes the destination read what the source
+    // computes in the same iteration, or in the previous one if the
+    // destination comes first. Either way both have to keep their order.
+    // Delayed links only move data at the end of the iteration.
+    for (UInt32 dest = 0; dest < schedule.regions.size(); dest++) {
+      for (const auto &inputTuple : schedule.regions[dest]->getInputs()) {
         for (const auto pLink : inputTuple.second->getLinks()) {
-          pLink->shiftBufferedData();
+          if (pLink->getPropagationDelay() != 0)
+            continue;
+
+          auto src = order.find(&pLink->getSrc().getRegion());
+          if (src == order.end() || src->second == dest)
+            continue;
+
+          const UInt32 first = std::min(src->second, dest);
+          const UInt32 second = std::max(src->second, dest);
+          auto &dependents = schedule.dependents[first];
+          if (std::find(dependents.begin(), dependents.end(), second) ==
+              dependents.end()) {
+            dependents.push_back(second);
+            schedule.numDependencies[second]++;
+          }
         }
       }
     }
+  }
+}
 
-  } // End of outer run-loop
+void Network::setRunThreads(UInt32 numThreads) {
+  NTA_CHECK(numThreads >= 1) << "setRunThreads -- need at least one thread";
 
-  return;
+  if (numThreads == runThreads_)
+    return;
+
+  delete scheduler_;
+  scheduler_ = nullptr;
+  runThreads_ = numThreads;
+  if (runThreads_ > 1)
+    scheduler_ = new RegionScheduler(*this, runThreads_);
 }
 
+UInt32 Network::getRunThreads() const { return runThreads_; }
+
 void Network::initialize() {
 
   /*
@@ -446,30 +749,82 @@ void Network::initialize() {
 
   /*
    * 1. Calculate all region dimensions by
-   * iteratively evaluating links to induce
-   * region dimensions.
+   * propagating them over the links.
+   *
+   * Evaluating a link may induce dimensions on one of its
+   * regions, which may in turn let the other links of that
+   * region complete. Every link is evaluated once, and then
+   * again when one of its regions or of its own ends receives
+   * dimensions, so each link is evaluated a bounded number of
+   * times. If the network is incompletely specified, some
+   * links never complete.
    */
 
-  // Iterate until all regions have finished
-  // evaluating their links. If network is
-  // incompletely specified, we'll never finish,
-  // so make sure we make progress each time
-  // through the network.
-
-  size_t nLinksRemainingPrev = std::numeric_limits<size_t>::max();
-  size_t nLinksRemaining = nLinksRemainingPrev - 1;
+  struct PendingLink {
+    Input *input;
+    Link *link;
+    bool queued;
+  };
+  std::vector<PendingLink> links;
+  std::map<const Region *, std::vector<size_t>> regionLinks;
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    Region *r = regions_.getByIndex(i).second;
+    for (const auto &inputTuple : r->getInputs()) {
+      for (const auto pLink : inputTuple.second->getLinks()) {
+        const Region *src = &pLink->getSrc().getRegion();
+        regionLinks[src].push_back(links.size());
+        if (src != r)
+          regionLinks[r].push_back(links.size());
+        links.push_back({inputTuple.second, pLink, true});
+      }
+    }
+  }
 
-  std::vector<Region *>::iterator r;
-  while (nLinksRemaining > 0 && nLinksRemainingPrev > nLinksRemaining) {
-    nLinksRemainingPrev = nLinksRemaining;
-    nLinksRemaining = 0;
+  std::deque<size_t> worklist;
+  for (size_t i = 0; i < links.size(); i++)
+    worklist.push_back(i);
+
+  size_t nLinksRemaining = links.size();
+  while (!worklist.empty()) {
+    const size_t i = worklist.front();
+    PendingLink &pending = links[i];
+    worklist.pop_front();
+    pending.queued = false;
+
+    Link *l = pending.link;
+    Region &srcRegion = l->getSrc().getRegion();
+    Region &destRegion = l->getDest().getRegion();
+    const bool srcWasUnspecified = srcRegion.getDimensions().isUnspecified();
+    const bool destWasUnspecified = destRegion.getDimensions().isUnspecified();
+    const bool linkWasUnspecified = l->getSrcDimensions().isUnspecified() ||
+                                    l->getDestDimensions().isUnspecified();
+
+    if (pending.input->evaluateLink(l)) {
+      nLinksRemaining--;
+      // Complete links stay out of the worklist
+      pending.queued = true;
+    } else if (linkWasUnspecified && !l->getSrcDimensions().isUnspecified() &&
+               !l->getDestDimensions().isUnspecified()) {
+      pending.queued = true;
+      worklist.push_back(i);
+    }
 
-    for (size_t i = 0; i < regions_.getCount(); i++) {
-      // evaluateLinks returns the number
-      // of links which still need to be
-      // evaluated.
-      Region *r = regions_.getByIndex(i).second;
-      nLinksRemaining += r->evaluateLinks();
+    const Region *induced[] = {
+        srcWasUnspecified && !srcRegion.getDimensions().isUnspecified()
+            ? &srcRegion
+            : nullptr,
+        destWasUnspecified && !destRegion.getDimensions().isUnspecified()
+            ? &destRegion
+            : nullptr};
+    for (const Region *r : induced) {
+      if (r == nullptr)
+        continue;
+      for (size_t j : regionLinks[r]) {
+        if (!links[j].queued) {
+          links[j].queued = true;
+          worklist.push_back(j);
+        }
+      }
     }
   }
 
@@ -536,6 +891,14 @@ void Network::initialize() {
    */
   resetEnabledPhases_();
 
+  /*
+   * 6. Find the links whose data has to be shifted after each iteration,
+   * and the order of the regions when running on several threads
+   */
+  collectDelayedLinks_();
+  if (scheduler_)
+    buildSchedule_();
+
   /*
    * Mark network as initialized.
    */
@@ -617,6 +980,23 @@ void Network::save(const std::string &name) {
   }
 }
 
+std::shared_ptr<NetworkCheckpoint>
+Network::checkpoint(const std::string &path) {
+  if (checkpoint_)
+    checkpoint_->wait();
+
+  const std::string fullPath = Path::normalize(Path::makeAbsolute(path));
+  const UInt64 start = CycleClock::now();
+  std::unique_ptr<capnp::MallocMessageBuilder> message(
+      new capnp::MallocMessageBuilder);
+  NetworkProto::Builder proto = message->initRoot<NetworkProto>();
+  write(proto);
+
+  checkpoint_.reset(new NetworkCheckpoint(fullPath, std::move(message),
+                                          CycleClock::now() - start));
+  return checkpoint_;
+}
+
 // A Region "name" is the name specified by the user in addRegion
 // This name may not be usable as part of a filesystem path, so
 // bundle files associated with a region use the region "label"
@@ -653,7 +1033,8 @@ void Network::saveToBundle(const std::string &name) {
     out << YAML::Key << "Regions" << YAML::Value << YAML::BeginSeq;
     for (size_t regionIndex = 0; regionIndex < regions_.getCount();
          regionIndex++) {
-      std::pair<std::string, Region *> &info = regions_.getByIndex(regionIndex);
+      const std::pair<std::string, Region *> &info =
+          regions_.getByIndex(regionIndex);
       Region *r = info.second;
       // Network serializes the region directly because it is actually easier
       // to do here than inside the region, and we don't have the RegionImpl
@@ -716,7 +1097,8 @@ void Network::saveToBundle(const std::string &name) {
   // Now save RegionImpl data
   for (size_t regionIndex = 0; regionIndex < regions_.getCount();
        regionIndex++) {
-    std::pair<std::string, Region *> &info = regions_.getByIndex(regionIndex);
+    const std::pair<std::string, Region *> &info =
+        regions_.getByIndex(regionIndex);
     Region *r = info.second;
     std::string label = getLabel(regionIndex);
     BundleIO bundle(fullPath, label, info.first, /* isInput: */ false);
@@ -1031,16 +1413,151 @@ void Network::read(NetworkProto::Reader &proto) {
 void Network::enableProfiling() {
   for (size_t i = 0; i < regions_.getCount(); i++)
     regions_.getByIndex(i).second->enableProfiling();
+  addProfiles_();
+  profiling_ = true;
 }
 
 void Network::disableProfiling() {
   for (size_t i = 0; i < regions_.getCount(); i++)
     regions_.getByIndex(i).second->disableProfiling();
+  profiling_ = false;
 }
 
 void Network::resetProfiling() {
   for (size_t i = 0; i < regions_.getCount(); i++)
     regions_.getByIndex(i).second->resetProfiling();
+
+  for (auto &profile : prepareProfiles_)
+    profile.second.reset();
+  for (auto &profile : computeProfiles_)
+    profile.second.reset();
+  for (auto &profile : linkProfiles_)
+    profile.second.reset();
+  for (auto &profile : phaseProfiles_)
+    profile.reset();
+  for (auto &profile : callbackProfiles_)
+    profile.second.reset();
+  shiftProfile_.reset();
+  iterationProfile_.reset();
+}
+
+static std::string quoteCsv_(const std::string &s) {
+  if (s.find_first_of(",\"\n") == std::string::npos)
+    return s;
+
+  std::string quoted = "\"";
+  for (char c : s) {
+    if (c == '"')
+      quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+static std::string quoteJson_(const std::string &s) {
+  std::string quoted = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if ((UInt8)c < 0x20) {
+      char escaped[8];
+      ::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+std::string Network::getProfilingReport(const std::string &format) const {
+  NTA_CHECK(format == "json" || format == "csv")
+      << "getProfilingReport: unknown format '" << format
+      << "', it must be json or csv";
+
+  struct Entry {
+    std::string stage;
+    std::string name;
+    const LatencyHistogram *histogram;
+  };
+  std::vector<Entry> entries;
+  auto add = [&entries](const std::string &stage, const std::string &name,
+                        const LatencyHistogram &histogram) {
+    if (histogram.getCount())
+      entries.push_back({stage, name, &histogram});
+  };
+
+  add("iteration", "", iterationProfile_);
+  for (size_t phase = 0; phase < phaseProfiles_.size(); phase++)
+    add("phase", std::to_string(phase), phaseProfiles_[phase]);
+
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    const std::pair<std::string, Region *> &region = regions_.getByIndex(i);
+    const Region *r = region.second;
+
+    auto prepareProfile = prepareProfiles_.find(r);
+    if (prepareProfile != prepareProfiles_.end())
+      add("prepare", region.first, prepareProfile->second);
+
+    for (const auto &inputTuple : r->getInputs()) {
+      for (const auto pLink : inputTuple.second->getLinks()) {
+        auto linkProfile = linkProfiles_.find(pLink);
+        if (linkProfile != linkProfiles_.end())
+          add("link", pLink->getMoniker(), linkProfile->second);
+      }
+    }
+
+    auto computeProfile = computeProfiles_.find(r);
+    if (computeProfile != computeProfiles_.end())
+      add("compute", region.first, computeProfile->second);
+  }
+
+  for (const auto &profile : callbackProfiles_)
+    add("callback", profile.first, profile.second);
+  add("shift", "", shiftProfile_);
+
+  const Real64 usPerTick = 1e6 / CycleClock::ticksPerSecond();
+  const char *fields[] = {"total_us", "mean_us", "min_us", "p50_us",
+                          "p90_us",   "p99_us",  "max_us"};
+  auto values = [usPerTick](const LatencyHistogram &h) {
+    return std::vector<Real64>{
+        h.getTotal() * usPerTick,         h.getMean() * usPerTick,
+        h.getMin() * usPerTick,           h.getPercentile(50) * usPerTick,
+        h.getPercentile(90) * usPerTick, h.getPercentile(99) * usPerTick,
+        h.getMax() * usPerTick};
+  };
+
+  std::stringstream ss;
+  if (format == "csv") {
+    ss << "stage,name,count";
+    for (const char *field : fields)
+      ss << "," << field;
+    ss << "\n";
+
+    for (const Entry &entry : entries) {
+      ss << entry.stage << "," << quoteCsv_(entry.name) << ","
+         << entry.histogram->getCount();
+      for (Real64 value : values(*entry.histogram))
+        ss << "," << value;
+      ss << "\n";
+    }
+    return ss.str();
+  }
+
+  ss << "{\"stages\": [";
+  for (size_t i = 0; i < entries.size(); i++) {
+    const Entry &entry = entries[i];
+    ss << (i ? ",\n  " : "\n  ") << "{\"stage\": " << quoteJson_(entry.stage)
+       << ", \"name\": " << quoteJson_(entry.name)
+       << ", \"count\": " << entry.histogram->getCount();
+    const std::vector<Real64> stageValues = values(*entry.histogram);
+    for (size_t j = 0; j < stageValues.size(); j++)
+      ss << ", \"" << fields[j] << "\": " << stageValues[j];
+    ss << "}";
+  }
+  ss << (entries.empty() ? "]}" : "\n]}");
+  return ss.str();
 }
 
 void Network::registerPyRegion(const std::string module,
@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the NetworkCheckpoint class
+ */
+
+#include <cstdio>
+#include <exception>
+#include <sstream>
+
+#if defined(NTA_OS_WINDOWS)
+#include <process.h> // _getpid
+#else
+#include <unistd.h> // getpid
+#endif
+
+#include <capnp/serialize.h>
+#include <kj/exception.h>
+#include <kj/std/iostream.h>
+
+#include <nupic/engine/NetworkCheckpoint.hpp>
+#include <nupic/os/FStream.hpp>
+#include <nupic/os/Path.hpp>
+#include <nupic/utils/Log.hpp>
+
+namespace nupic {
+
+namespace {
+
+// Counts the bytes on their way to the file, so that getBytesWritten()
+// shows the progress of a large checkpoint.
+class CountingOutputStream : public kj::OutputStream {
+public:
+  CountingOutputStream(kj::OutputStream &inner, std::atomic<UInt64> &count)
+      : inner_(inner), count_(count) {}
+
+  void write(const void *buffer, size_t size) override {
+    inner_.write(buffer, size);
+    count_ += size;
+  }
+
+private:
+  kj::OutputStream &inner_;
+  std::atomic<UInt64> &count_;
+};
+
+// Numbers the temporary files of the checkpoints of this process.
+std::atomic<UInt64> tmpCounter(0);
+
+// A temporary file next to path that no other checkpoint, from this
+// process or another one, writes to at the same time.
+std::string tmpPathFor(const std::string &path) {
+#if defined(NTA_OS_WINDOWS)
+  const int pid = _getpid();
+#else
+  const int pid = getpid();
+#endif
+  std::stringstream ss;
+  ss << path << "." << pid << "." << tmpCounter++ << ".tmp";
+  return ss.str();
+}
+
+} // end namespace
+
+NetworkCheckpoint::NetworkCheckpoint(
+    const std::string &path,
+    std::unique_ptr<capnp::MallocMessageBuilder> message, UInt64 snapshotTicks)
+    : path_(path), message_(std::move(message)), snapshotTicks_(snapshotTicks),
+      bytesTotal_(capnp::computeSerializedSizeInWords(*message_) *
+                  sizeof(capnp::word)),
+      bytesWritten_(0), status_(PENDING) {
+  thread_ = std::thread(&NetworkCheckpoint::write_, this);
+}
+
+NetworkCheckpoint::~NetworkCheckpoint() {
+  if (thread_.joinable())
+    thread_.join();
+}
+
+NetworkCheckpoint::Status NetworkCheckpoint::getStatus() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+NetworkCheckpoint::Status NetworkCheckpoint::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return status_ != PENDING; });
+  return status_;
+}
+
+std::string NetworkCheckpoint::getError() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+}
+
+void NetworkCheckpoint::write_() {
+  const std::string tmpPath = tmpPathFor(path_);
+  Status status = DONE;
+  std::string error;
+
+  try {
+    {
+      OFStream f(tmpPath.c_str(), std::ios::out | std::ios::binary);
+      if (!f.is_open())
+        NTA_THROW << "Unable to open " << tmpPath << " for writing";
+      kj::std::StdOutputStream out(f);
+      CountingOutputStream counted(out, bytesWritten_);
+      capnp::writeMessage(counted, *message_);
+      f.close();
+      if (f.fail())
+        NTA_THROW << "Error while writing " << tmpPath;
+    }
+    // The file must be on the disk before the rename makes it the
+    // checkpoint, and the rename must be on the disk before isDone().
+    Path::sync(tmpPath);
+    Path::rename(tmpPath, path_);
+    Path::sync(Path::getParent(Path::makeAbsolute(path_)));
+  } catch (std::exception &e) {
+    status = FAILED;
+    error = e.what();
+  } catch (kj::Exception &e) {
+    status = FAILED;
+    error = e.getDescription().cStr();
+  }
+  if (status == FAILED)
+    std::remove(tmpPath.c_str());
+
+  // The snapshot can be large, don't hold on to it until the destructor.
+  message_.reset();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = status;
+    error_ = error;
+  }
+  done_.notify_all();
+}
+
+} // end namespace nupic
@@ -0,0 +1,131 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of the NetworkCheckpoint class
+ */
+
+#ifndef NTA_NETWORK_CHECKPOINT_HPP
+#define NTA_NETWORK_CHECKPOINT_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <capnp/message.h>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+/**
+ * A checkpoint of a network that is being written in the background.
+ *
+ * Network::checkpoint() serializes the network into an in-memory Cap'n
+ * Proto message between two iterations, which copies the region state, and
+ * hands the message to a NetworkCheckpoint. The checkpoint writes it on its
+ * own thread to a temporary file next to the destination, syncs it to the
+ * disk, then renames it over the destination and syncs the directory. A
+ * reader of the destination therefore sees either the previous checkpoint
+ * or the new one, never a partial file, even after a crash.
+ *
+ * The file holds the same message as Network::write(std::ostream &), and is
+ * loaded with Network::read(std::istream &).
+ *
+ * The destructor waits for the write to finish.
+ */
+class NetworkCheckpoint {
+public:
+  enum Status { PENDING, DONE, FAILED };
+
+  ~NetworkCheckpoint();
+
+  /**
+   * Absolute path of the destination file.
+   */
+  const std::string &getPath() const { return path_; }
+
+  Status getStatus() const;
+
+  bool isDone() const { return getStatus() != PENDING; }
+
+  /**
+   * Block until the checkpoint is written or has failed.
+   *
+   * @returns DONE or FAILED
+   */
+  Status wait();
+
+  /**
+   * Number of bytes written so far. Once the status is DONE, this is the
+   * size of the file.
+   */
+  UInt64 getBytesWritten() const { return bytesWritten_; }
+
+  /**
+   * Size of the serialized network, known as soon as the snapshot is taken.
+   */
+  UInt64 getBytesTotal() const { return bytesTotal_; }
+
+  /**
+   * The reason a FAILED checkpoint failed.
+   */
+  std::string getError() const;
+
+  /**
+   * How long Network::checkpoint() blocked the caller to take the snapshot,
+   * in CycleClock ticks.
+   */
+  UInt64 getSnapshotTicks() const { return snapshotTicks_; }
+
+private:
+  friend class Network;
+
+  NetworkCheckpoint(const std::string &path,
+                    std::unique_ptr<capnp::MallocMessageBuilder> message,
+                    UInt64 snapshotTicks);
+
+  NetworkCheckpoint(const NetworkCheckpoint &) = delete;
+  NetworkCheckpoint &operator=(const NetworkCheckpoint &) = delete;
+
+  void write_();
+
+  const std::string path_;
+  std::unique_ptr<capnp::MallocMessageBuilder> message_;
+  const UInt64 snapshotTicks_;
+  UInt64 bytesTotal_;
+  std::atomic<UInt64> bytesWritten_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable done_;
+  Status status_;
+  std::string error_;
+
+  std::thread thread_;
+};
+
+} // end namespace nupic
+
+#endif // NTA_NETWORK_CHECKPOINT_HPP
@@ -0,0 +1,168 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the NetworkInputSource classes
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <nupic/engine/Network.hpp>
+#include <nupic/engine/NetworkInputSource.hpp>
+#include <nupic/engine/Region.hpp>
+#include <nupic/utils/Log.hpp>
+
+namespace nupic {
+
+BlockInputSource::BlockInputSource(const Real64 *data, size_t numRows,
+                                   size_t numColumns)
+    : data_(data), numRows_(numRows), numColumns_(numColumns) {
+  NTA_CHECK(data != nullptr || numRows == 0);
+}
+
+BlockInputSource::BlockInputSource(std::vector<Real64> data,
+                                   size_t numColumns)
+    : ownData_(std::move(data)), numColumns_(numColumns) {
+  NTA_CHECK(numColumns > 0) << "BlockInputSource: no columns";
+  NTA_CHECK(ownData_.size() % numColumns == 0)
+      << "BlockInputSource: " << ownData_.size()
+      << " values is not a whole number of rows of " << numColumns;
+  data_ = ownData_.data();
+  numRows_ = ownData_.size() / numColumns;
+}
+
+BlockInputSource::BlockInputSource(const BlockInputSource &other)
+    : ownData_(other.ownData_),
+      data_(other.data_ == other.ownData_.data() ? ownData_.data()
+                                                 : other.data_),
+      numRows_(other.numRows_), numColumns_(other.numColumns_),
+      targets_(other.targets_) {}
+
+BlockInputSource &BlockInputSource::operator=(const BlockInputSource &other) {
+  if (this != &other) {
+    ownData_ = other.ownData_;
+    data_ = other.data_ == other.ownData_.data() ? ownData_.data()
+                                                 : other.data_;
+    numRows_ = other.numRows_;
+    numColumns_ = other.numColumns_;
+    targets_ = other.targets_;
+  }
+  return *this;
+}
+
+BlockInputSource BlockInputSource::fromFile(const std::string &path) {
+  std::ifstream in(path.c_str());
+  NTA_CHECK(in.good()) << "BlockInputSource: unable to open " << path;
+
+  std::vector<Real64> data;
+  size_t numColumns = 0;
+  std::string line;
+  for (size_t lineNumber = 1; std::getline(in, line); lineNumber++) {
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream values(line);
+    size_t count = 0;
+    Real64 value;
+    while (values >> value) {
+      data.push_back(value);
+      count++;
+    }
+    NTA_CHECK(values.eof())
+        << "BlockInputSource: invalid value at " << path << ":" << lineNumber;
+    if (count == 0)
+      continue;
+
+    if (numColumns == 0)
+      numColumns = count;
+    NTA_CHECK(count == numColumns)
+        << "BlockInputSource: " << path << ":" << lineNumber << " has "
+        << count << " values instead of " << numColumns;
+  }
+  NTA_CHECK(numColumns > 0) << "BlockInputSource: " << path << " is empty";
+
+  return BlockInputSource(std::move(data), numColumns);
+}
+
+void BlockInputSource::addParameter(const std::string &regionName,
+                                    const std::string &parameterName,
+                                    size_t column) {
+  NTA_CHECK(column < numColumns_)
+      << "BlockInputSource: no column " << column << " in a block of "
+      << numColumns_;
+  targets_.push_back({regionName, parameterName, column, 0, nullptr});
+}
+
+void BlockInputSource::addArrayParameter(const std::string &regionName,
+                                         const std::string &parameterName,
+                                         size_t firstColumn, size_t count) {
+  NTA_CHECK(count > 0 && firstColumn + count <= numColumns_)
+      << "BlockInputSource: columns " << firstColumn << " to "
+      << firstColumn + count << " are not in a block of " << numColumns_;
+  targets_.push_back(
+      {regionName, parameterName, firstColumn, count, nullptr});
+}
+
+void BlockInputSource::start(Network &network, UInt64 numIterations) {
+  NTA_CHECK(numIterations <= numRows_)
+      << "BlockInputSource: " << numIterations << " iterations but only "
+      << numRows_ << " rows";
+
+  for (Target &target : targets_) {
+    NTA_CHECK(network.getRegions().contains(target.regionName))
+        << "BlockInputSource: no region named '" << target.regionName << "'";
+    target.region = network.getRegions().getByName(target.regionName);
+  }
+}
+
+void BlockInputSource::apply(UInt64 iteration) {
+  NTA_ASSERT(iteration < numRows_);
+  const Real64 *row = data_ + iteration * numColumns_;
+
+  for (const Target &target : targets_) {
+    if (target.count == 0) {
+      target.region->setParameterReal64(target.parameterName,
+                                        row[target.firstColumn]);
+    } else {
+      // The array only points into the block, setParameterArray() copies it
+      const Array array(NTA_BasicType_Real64,
+                        const_cast<Real64 *>(row + target.firstColumn),
+                        target.count);
+      target.region->setParameterArray(target.parameterName, array);
+    }
+  }
+}
+
+CallbackInputSource::CallbackInputSource(Callback callback)
+    : callback_(std::move(callback)), network_(nullptr) {
+  NTA_CHECK(callback_) << "CallbackInputSource: no callback";
+}
+
+void CallbackInputSource::start(Network &network, UInt64 numIterations) {
+  network_ = &network;
+}
+
+void CallbackInputSource::apply(UInt64 iteration) {
+  callback_(*network_, iteration);
+}
+
+} // namespace nupic
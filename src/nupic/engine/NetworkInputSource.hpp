@@ -0,0 +1,156 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the NetworkInputSource classes
+ */
+
+#ifndef NTA_NETWORK_INPUT_SOURCE_HPP
+#define NTA_NETWORK_INPUT_SOURCE_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <nupic/ntypes/Array.hpp>
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+class Network;
+class Region;
+
+/**
+ * Supplies the inputs of a network for each iteration of
+ * Network::runBatch(), in place of a driver that sets them and calls
+ * Network::run(1) for every record.
+ */
+class NetworkInputSource {
+public:
+  virtual ~NetworkInputSource() {}
+
+  /**
+   * Called once by runBatch() before the first iteration. This is where
+   * region and parameter names should be resolved.
+   *
+   * @param network The network being run
+   * @param numIterations Number of iterations of the batch
+   */
+  virtual void start(Network &network, UInt64 numIterations) = 0;
+
+  /**
+   * Set the inputs of the network for an iteration of the batch.
+   *
+   * @param iteration Index of the iteration in the batch, from 0
+   */
+  virtual void apply(UInt64 iteration) = 0;
+};
+
+/**
+ * Reads the inputs from a row major block of Real64, one row per iteration,
+ * e.g. the buffer of a 2D numpy array. Each parameter that is fed takes
+ * one column, or several consecutive columns for an array parameter.
+ */
+class BlockInputSource : public NetworkInputSource {
+public:
+  /**
+   * Use a block owned by the caller, which must outlive the batch.
+   */
+  BlockInputSource(const Real64 *data, size_t numRows, size_t numColumns);
+
+  /**
+   * Use a block owned by the source.
+   */
+  BlockInputSource(std::vector<Real64> data, size_t numColumns);
+
+  // A copy of a source that owns its block points into its own copy of
+  // the block. Moving the block keeps its buffer, so the moves are default.
+  BlockInputSource(const BlockInputSource &other);
+  BlockInputSource &operator=(const BlockInputSource &other);
+  BlockInputSource(BlockInputSource &&other) = default;
+  BlockInputSource &operator=(BlockInputSource &&other) = default;
+
+  /**
+   * Read a block from a text file with one row per line, and values
+   * separated by white space or commas. All rows must have the same number
+   * of values.
+   */
+  static BlockInputSource fromFile(const std::string &path);
+
+  size_t getNumRows() const { return numRows_; }
+  size_t getNumColumns() const { return numColumns_; }
+
+  /**
+   * Feed a column to a Real64 parameter of a region.
+   */
+  void addParameter(const std::string &regionName,
+                    const std::string &parameterName, size_t column);
+
+  /**
+   * Feed count columns starting at firstColumn to an array parameter of a
+   * region, as an array of Real64.
+   */
+  void addArrayParameter(const std::string &regionName,
+                         const std::string &parameterName, size_t firstColumn,
+                         size_t count);
+
+  void start(Network &network, UInt64 numIterations) override;
+  void apply(UInt64 iteration) override;
+
+private:
+  struct Target {
+    std::string regionName;
+    std::string parameterName;
+    size_t firstColumn;
+    size_t count; // 0 for a scalar parameter
+    Region *region;
+  };
+
+  std::vector<Real64> ownData_;
+  const Real64 *data_;
+  size_t numRows_;
+  size_t numColumns_;
+  std::vector<Target> targets_;
+};
+
+/**
+ * Calls a function once per iteration to set the inputs, which lets a
+ * driver fill them from any source without going through run() for every
+ * record.
+ */
+class CallbackInputSource : public NetworkInputSource {
+public:
+  typedef std::function<void(Network &network, UInt64 iteration)> Callback;
+
+  CallbackInputSource(Callback callback);
+
+  void start(Network &network, UInt64 numIterations) override;
+  void apply(UInt64 iteration) override;
+
+private:
+  Callback callback_;
+  Network *network_;
+};
+
+} // namespace nupic
+
+#endif // NTA_NETWORK_INPUT_SOURCE_HPP
@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the NetworkOutputSink class
+ */
+
+#include <cstring> // memcpy
+
+#include <nupic/engine/Network.hpp>
+#include <nupic/engine/NetworkOutputSink.hpp>
+#include <nupic/engine/Output.hpp>
+#include <nupic/engine/Region.hpp>
+#include <nupic/ntypes/Array.hpp>
+#include <nupic/types/BasicType.hpp>
+#include <nupic/utils/Log.hpp>
+
+namespace nupic {
+
+NetworkOutputSink::NetworkOutputSink() : numIterations_(0) {}
+
+size_t NetworkOutputSink::addOutput(const std::string &regionName,
+                                    const std::string &outputName) {
+  Capture capture;
+  capture.regionName = regionName;
+  capture.outputName = outputName;
+  capture.output = nullptr;
+  capture.type = NTA_BasicType_Byte;
+  capture.width = 0;
+  capture.elementSize = 0;
+  captures_.push_back(std::move(capture));
+  return captures_.size() - 1;
+}
+
+const NetworkOutputSink::Capture &
+NetworkOutputSink::getCapture_(size_t output) const {
+  NTA_CHECK(output < captures_.size())
+      << "NetworkOutputSink: no output " << output << ", there are "
+      << captures_.size();
+  return captures_[output];
+}
+
+NTA_BasicType NetworkOutputSink::getType(size_t output) const {
+  return getCapture_(output).type;
+}
+
+size_t NetworkOutputSink::getWidth(size_t output) const {
+  return getCapture_(output).width;
+}
+
+size_t NetworkOutputSink::getCount(size_t output, UInt64 iteration) const {
+  const Capture &capture = getCapture_(output);
+  NTA_CHECK(iteration < numIterations_)
+      << "NetworkOutputSink: no iteration " << iteration << ", there are "
+      << numIterations_;
+  return capture.counts[iteration];
+}
+
+const void *NetworkOutputSink::getBuffer(size_t output) const {
+  return getCapture_(output).data.data();
+}
+
+void NetworkOutputSink::start(Network &network, UInt64 numIterations) {
+  numIterations_ = numIterations;
+
+  for (Capture &capture : captures_) {
+    NTA_CHECK(network.getRegions().contains(capture.regionName))
+        << "NetworkOutputSink: no region named '" << capture.regionName
+        << "'";
+    const Region *region = network.getRegions().getByName(capture.regionName);
+    capture.output = region->getOutput(capture.outputName);
+    NTA_CHECK(capture.output != nullptr)
+        << "NetworkOutputSink: region '" << capture.regionName
+        << "' has no output named '" << capture.outputName << "'";
+
+    const Array &data = capture.output->getData();
+    capture.type = data.getType();
+    capture.elementSize = BasicType::getSize(capture.type);
+    capture.width = data.getMaxElementsCount();
+    capture.data.assign(numIterations * capture.width * capture.elementSize,
+                        0);
+    capture.counts.assign(numIterations, 0);
+  }
+}
+
+void NetworkOutputSink::capture(UInt64 iteration) {
+  NTA_ASSERT(iteration < numIterations_);
+
+  for (Capture &capture : captures_) {
+    const Array &data = capture.output->getData();
+    const size_t count = data.getCount();
+    NTA_CHECK(count <= capture.width)
+        << "NetworkOutputSink: output '" << capture.regionName << "."
+        << capture.outputName << "' grew from " << capture.width << " to "
+        << count << " elements during the batch";
+
+    // Rows were zeroed by start() and are only written once
+    char *row =
+        capture.data.data() + iteration * capture.width * capture.elementSize;
+    ::memcpy(row, data.getBuffer(), count * capture.elementSize);
+    capture.counts[iteration] = (UInt32)count;
+  }
+}
+
+} // namespace nupic
@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of the NetworkOutputSink class
+ */
+
+#ifndef NTA_NETWORK_OUTPUT_SINK_HPP
+#define NTA_NETWORK_OUTPUT_SINK_HPP
+
+#include <string>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+class Network;
+class Output;
+
+/**
+ * Captures region outputs at every iteration of Network::runBatch().
+ *
+ * Each captured output gets one columnar buffer of numIterations rows of
+ * getWidth() elements of its type, allocated once when the batch starts.
+ * Row i holds the output after iteration i. Sparse outputs fill their rows
+ * up to getCount(), the rest of the row is 0.
+ */
+class NetworkOutputSink {
+public:
+  NetworkOutputSink();
+
+  /**
+   * Capture an output of a region.
+   *
+   * @returns The index of the output in the sink
+   */
+  size_t addOutput(const std::string &regionName,
+                   const std::string &outputName);
+
+  size_t getNumOutputs() const { return captures_.size(); }
+
+  /**
+   * Number of iterations captured by the last batch.
+   */
+  UInt64 getNumIterations() const { return numIterations_; }
+
+  NTA_BasicType getType(size_t output) const;
+
+  /**
+   * Number of elements in a row of an output's buffer.
+   */
+  size_t getWidth(size_t output) const;
+
+  /**
+   * Number of valid elements in a row, which is only less than getWidth()
+   * for sparse outputs.
+   */
+  size_t getCount(size_t output, UInt64 iteration) const;
+
+  /**
+   * Buffer of getNumIterations() rows of getWidth() elements of the type
+   * of an output.
+   */
+  const void *getBuffer(size_t output) const;
+
+  /**
+   * Called by runBatch() before the first iteration. Resolves the outputs
+   * and allocates their buffers.
+   */
+  void start(Network &network, UInt64 numIterations);
+
+  /**
+   * Called by runBatch() at the end of each iteration.
+   */
+  void capture(UInt64 iteration);
+
+private:
+  struct Capture {
+    std::string regionName;
+    std::string outputName;
+    const Output *output;
+    NTA_BasicType type;
+    size_t width;
+    size_t elementSize;
+    std::vector<char> data;
+    std::vector<UInt32> counts;
+  };
+
+  const Capture &getCapture_(size_t output) const;
+
+  std::vector<Capture> captures_;
+  UInt64 numIterations_;
+};
+
+} // namespace nupic
+
+#endif // NTA_NETWORK_OUTPUT_SINK_HPP
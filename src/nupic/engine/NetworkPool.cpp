@@ -0,0 +1,259 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the NetworkPool class
+ */
+
+#include <algorithm>
+#include <exception>
+
+#include <nupic/engine/Network.hpp>
+#include <nupic/engine/NetworkPool.hpp>
+#include <nupic/os/CycleClock.hpp>
+#include <nupic/utils/Log.hpp>
+
+namespace nupic {
+
+NetworkPool::RecordQueue::RecordQueue() : head_(&stub_), tail_(&stub_) {
+  stub_.next.store(nullptr, std::memory_order_relaxed);
+}
+
+NetworkPool::RecordQueue::~RecordQueue() {
+  while (Node *node = pop())
+    delete node;
+}
+
+void NetworkPool::RecordQueue::push(Node *node) {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+}
+
+NetworkPool::Node *NetworkPool::RecordQueue::pop() {
+  Node *tail = tail_;
+  Node *next = tail->next.load(std::memory_order_acquire);
+
+  if (tail == &stub_) {
+    if (next == nullptr)
+      return nullptr;
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+
+  if (tail != head_.load(std::memory_order_acquire))
+    return nullptr; // A push() is halfway through
+
+  // tail is the last node. Put the stub behind it so it can be taken.
+  push(&stub_);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+  return nullptr;
+}
+
+NetworkPool::NetworkPool(UInt32 numThreads)
+    : nextWorker_(0), numReady_(0), stop_(false), outstanding_(0) {
+  if (numThreads == 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (UInt32 i = 0; i < numThreads; i++)
+    workerQueues_.emplace_back(new Worker);
+  for (UInt32 i = 0; i < numThreads; i++)
+    workers_.emplace_back(&NetworkPool::work_, this, i);
+}
+
+NetworkPool::~NetworkPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto &worker : workers_)
+    worker.join();
+}
+
+NetworkPool::ModelId NetworkPool::addModel(Network *network) {
+  NTA_CHECK(network != nullptr) << "NetworkPool::addModel: no network";
+
+  std::unique_ptr<Model> model(new Model);
+  model->id = models_.size();
+  model->network.reset(network);
+  model->pending.store(0);
+  model->stats.records = 0;
+  model->stats.errors = 0;
+  models_.push_back(std::move(model));
+  return models_.size() - 1;
+}
+
+Network &NetworkPool::getNetwork(ModelId model) {
+  NTA_CHECK(model < models_.size())
+      << "NetworkPool: no model " << model << ", there are "
+      << models_.size();
+  return *models_[model]->network;
+}
+
+void NetworkPool::setResultCallback(ResultCallback callback) {
+  resultCallback_ = std::move(callback);
+}
+
+void NetworkPool::submit(ModelId id, Record record) {
+  NTA_CHECK(id < models_.size())
+      << "NetworkPool: no model " << id << ", there are " << models_.size();
+  Model *model = models_[id].get();
+
+  Node *node = new Node;
+  node->record = std::move(record);
+  node->submitted = CycleClock::now();
+
+  outstanding_.fetch_add(1);
+  model->queue.push(node);
+  if (model->pending.fetch_add(1) == 0)
+    schedule_(model, nextWorker_.fetch_add(1) % workerQueues_.size());
+}
+
+void NetworkPool::wait() {
+  std::unique_lock<std::mutex> lock(doneMutex_);
+  done_.wait(lock, [this] { return outstanding_.load() == 0; });
+}
+
+NetworkPool::ModelStats NetworkPool::getModelStats(ModelId model) const {
+  NTA_CHECK(model < models_.size())
+      << "NetworkPool: no model " << model << ", there are "
+      << models_.size();
+  std::lock_guard<std::mutex> lock(models_[model]->statsMutex);
+  return models_[model]->stats;
+}
+
+void NetworkPool::schedule_(Model *model, size_t worker) {
+  // Count the model before it can be taken, so that numReady_ never goes
+  // below 0. A worker that wakes up in between just looks again.
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    numReady_++;
+  }
+  {
+    std::lock_guard<std::mutex> lock(workerQueues_[worker]->mutex);
+    workerQueues_[worker]->ready.push_back(model);
+  }
+  wake_.notify_one();
+}
+
+NetworkPool::Model *NetworkPool::next_(size_t worker) {
+  // Oldest model of the worker's own deque first, otherwise steal the
+  // newest one of another worker
+  for (size_t i = 0; i < workerQueues_.size(); i++) {
+    Worker &queue = *workerQueues_[(worker + i) % workerQueues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ready.empty())
+      continue;
+
+    Model *model;
+    if (i == 0) {
+      model = queue.ready.front();
+      queue.ready.pop_front();
+    } else {
+      model = queue.ready.back();
+      queue.ready.pop_back();
+    }
+    numReady_--;
+    return model;
+  }
+  return nullptr;
+}
+
+void NetworkPool::process_(Model *model, size_t worker) {
+  for (UInt32 n = 1;; n++) {
+    // pending says there is a record, it may just not be linked yet
+    Node *node;
+    while ((node = model->queue.pop()) == nullptr)
+      std::this_thread::yield();
+
+    const UInt64 start = CycleClock::now();
+    std::string error;
+    try {
+      if (node->record)
+        node->record(*model->network);
+      model->network->run(1);
+      if (resultCallback_)
+        resultCallback_(model->id, *model->network);
+    } catch (const std::exception &e) {
+      error = e.what();
+      if (error.empty())
+        error = "unknown error";
+    } catch (...) {
+      error = "unknown error";
+    }
+    const UInt64 end = CycleClock::now();
+
+    {
+      std::lock_guard<std::mutex> lock(model->statsMutex);
+      model->stats.records++;
+      model->stats.queueLatency.record(start - node->submitted);
+      model->stats.runLatency.record(end - start);
+      if (!error.empty()) {
+        model->stats.errors++;
+        model->stats.lastError = error;
+      }
+    }
+    delete node;
+
+    const bool more = model->pending.fetch_sub(1) != 1;
+    if (outstanding_.fetch_sub(1) == 1) {
+      { std::lock_guard<std::mutex> lock(doneMutex_); }
+      done_.notify_all();
+    }
+
+    if (!more)
+      return;
+    if (n == RECORDS_PER_TURN) {
+      schedule_(model, worker);
+      return;
+    }
+  }
+}
+
+void NetworkPool::work_(size_t worker) {
+  while (true) {
+    Model *model = next_(worker);
+    if (model != nullptr) {
+      process_(model, worker);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    wake_.wait(lock, [this] { return stop_ || numReady_.load() > 0; });
+    if (stop_ && numReady_.load() == 0)
+      return;
+  }
+}
+
+} // namespace nupic
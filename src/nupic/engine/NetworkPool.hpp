@@ -0,0 +1,205 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of the NetworkPool class
+ */
+
+#ifndef NTA_NETWORK_POOL_HPP
+#define NTA_NETWORK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/LatencyHistogram.hpp>
+
+namespace nupic {
+
+class Network;
+
+/**
+ * Runs many independent networks, e.g. one small model per metric, on a
+ * shared pool of threads.
+ *
+ * Each model has its own queue of input records. A record is a function
+ * that sets the inputs of the model's network, after which the pool runs
+ * the network for one iteration and calls the result callback. The records
+ * of a model are processed one at a time, in the order they were
+ * submitted, while different models run in parallel. Networks share no
+ * state, so this scales with the number of threads.
+ *
+ * submit() can be called from any number of threads, and only takes a lock
+ * to wake a sleeping worker. addModel(), setResultCallback() and
+ * getNetwork() must not run concurrently with anything else, and
+ * getNetwork() only while the pool is idle, e.g. after wait().
+ */
+class NetworkPool {
+public:
+  typedef size_t ModelId;
+
+  /**
+   * Sets the inputs of a network before one iteration.
+   */
+  typedef std::function<void(Network &network)> Record;
+
+  /**
+   * Called on the worker thread after each iteration of a model, e.g. to
+   * read its outputs.
+   */
+  typedef std::function<void(ModelId model, Network &network)> ResultCallback;
+
+  /**
+   * Counters and latency distributions of a model, in CycleClock ticks.
+   * queueLatency is the time from submit() to the start of the record,
+   * runLatency the time to apply it, run the network and call the result
+   * callback.
+   */
+  struct ModelStats {
+    UInt64 records;
+    UInt64 errors;
+    std::string lastError;
+    LatencyHistogram queueLatency;
+    LatencyHistogram runLatency;
+  };
+
+  /**
+   * @param numThreads Number of worker threads, the number of cores by
+   *        default
+   */
+  explicit NetworkPool(UInt32 numThreads = 0);
+
+  /**
+   * Waits for all the submitted records, then stops the threads and
+   * deletes the networks.
+   */
+  ~NetworkPool();
+
+  /**
+   * Add a model. The pool takes ownership of the network.
+   *
+   * @returns The id to submit records for the model with
+   */
+  ModelId addModel(Network *network);
+
+  size_t getNumModels() const { return models_.size(); }
+  UInt32 getNumThreads() const { return (UInt32)workers_.size(); }
+
+  Network &getNetwork(ModelId model);
+
+  void setResultCallback(ResultCallback callback);
+
+  /**
+   * Queue a record for a model.
+   */
+  void submit(ModelId model, Record record);
+
+  /**
+   * Block until all the records submitted so far have been processed.
+   */
+  void wait();
+
+  /**
+   * Copy of the statistics of a model. Can be called at any time.
+   */
+  ModelStats getModelStats(ModelId model) const;
+
+private:
+  // Multiple producer, single consumer queue of records, after Dmitry
+  // Vyukov's intrusive queue. push() is wait-free. pop() may return nullptr
+  // for a short moment after a push() has started, see process_().
+  struct Node {
+    std::atomic<Node *> next;
+    Record record;
+    UInt64 submitted;
+  };
+
+  class RecordQueue {
+  public:
+    RecordQueue();
+    ~RecordQueue();
+    void push(Node *node);
+    // The returned node must be deleted by the caller
+    Node *pop();
+
+  private:
+    std::atomic<Node *> head_;
+    Node *tail_;
+    Node stub_;
+  };
+
+  struct Model {
+    ModelId id;
+    std::unique_ptr<Network> network;
+    RecordQueue queue;
+    // Number of records submitted and not processed yet. The thread that
+    // moves it away from 0 schedules the model, the one that brings it back
+    // to 0 gives it up, so at most one worker owns a model at any time.
+    std::atomic<UInt64> pending;
+    mutable std::mutex statsMutex;
+    ModelStats stats;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Model *> ready;
+  };
+
+  // Maximum number of records a worker processes for a model before
+  // putting it back in line, so that busy models don't starve the others
+  static const UInt32 RECORDS_PER_TURN = 16;
+
+  void schedule_(Model *model, size_t worker);
+  Model *next_(size_t worker);
+  void process_(Model *model, size_t worker);
+  void work_(size_t worker);
+
+  std::vector<std::unique_ptr<Model>> models_;
+  ResultCallback resultCallback_;
+
+  std::vector<std::unique_ptr<Worker>> workerQueues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> nextWorker_;
+
+  // Models waiting in the workers' deques, guarded by sleepMutex_ for
+  // the workers' condition variable
+  std::atomic<size_t> numReady_;
+  std::mutex sleepMutex_;
+  std::condition_variable wake_;
+  bool stop_;
+
+  // Records submitted and not processed yet, for wait()
+  std::atomic<UInt64> outstanding_;
+  std::mutex doneMutex_;
+  std::condition_variable done_;
+};
+
+} // namespace nupic
+
+#endif // NTA_NETWORK_POOL_HPP
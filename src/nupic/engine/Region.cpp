@@ -124,7 +124,8 @@ void Region::createInputsAndOutputs_() {
     std::string inputName = p.first;
     const InputSpec &is = p.second;
 
-    auto input = new Input(*this, is.dataType, is.regionLevel, is.sparse);
+    auto input = new Input(*this, is.dataType, is.regionLevel, is.sparse,
+                           is.readOnly);
     inputs_[inputName] = input;
     // keep track of name in the input also -- see note in Region.hpp
     input->setName(inputName);
@@ -249,14 +250,6 @@ void Region::compute() {
  * part of initialization.
  */
 
-size_t Region::evaluateLinks() {
-  int nIncompleteLinks = 0;
-  for (auto &elem : inputs_) {
-    nIncompleteLinks += (elem.second)->evaluateLinks();
-  }
-  return nIncompleteLinks;
-}
-
 std::string Region::getLinkErrors() const {
 
   std::stringstream ss;
@@ -37,6 +37,7 @@
 
 // We need the full definitions because these
 // objects are returned by value.
+#include <nupic/engine/RegionHandles.hpp>
 #include <nupic/ntypes/Dimensions.hpp>
 #include <nupic/os/Timer.hpp>
 #include <nupic/proto/RegionProto.capnp.h>
@@ -501,6 +502,18 @@ public:
    */
   virtual ArrayRef getOutputData(const std::string &outputName) const;
 
+  /**
+   * Resolve an output once, to read its data repeatedly without looking up
+   * its name again.
+   *
+   * @param outputName
+   *        The name of the target output
+   *
+   * @returns
+   *        A handle to the output
+   */
+  OutputHandle resolveOutput(const std::string &outputName) const;
+
   /**
    * Get the count of input data.
    *
@@ -652,9 +665,6 @@ public:
 
   // The following methods are called by Network in initialization
 
-  // Returns number of links that could not be fully evaluated
-  size_t evaluateLinks();
-
   std::string getLinkErrors() const;
 
   size_t getNodeOutputElementCount(const std::string &name);
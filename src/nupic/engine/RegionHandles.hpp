@@ -0,0 +1,67 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the OutputHandle class
+ */
+
+#ifndef NTA_REGION_HANDLES_HPP
+#define NTA_REGION_HANDLES_HPP
+
+namespace nupic {
+
+class Array;
+class ArrayRef;
+class Output;
+
+/**
+ * An output of a region, resolved once with Region::resolveOutput() and
+ * then read without looking up its name again.
+ *
+ * A handle stays valid as long as its region exists.
+ */
+class OutputHandle {
+public:
+  OutputHandle() : output_(nullptr) {}
+
+  bool isValid() const { return output_ != nullptr; }
+
+  /**
+   * The output's data, which is updated in place at every compute.
+   */
+  const Array &getData() const;
+
+  /**
+   * Same as Region::getOutputData().
+   */
+  ArrayRef getDataRef() const;
+
+private:
+  friend class Region;
+  explicit OutputHandle(const Output *output) : output_(output) {}
+
+  const Output *output_;
+};
+
+} // namespace nupic
+
+#endif // NTA_REGION_HANDLES_HPP
@@ -38,7 +38,9 @@
 #include <nupic/os/Env.hpp>
 #include <nupic/os/OS.hpp>
 #include <nupic/os/Path.hpp>
+#ifdef NTA_PYTHON_SUPPORT
 #include <nupic/regions/PyRegion.hpp>
+#endif
 #include <nupic/regions/VectorFileEffector.hpp>
 #include <nupic/regions/VectorFileSensor.hpp>
 #include <nupic/utils/Log.hpp>
@@ -130,6 +132,9 @@ public:
   DynamicPythonLibrary()
       : initPython_(nullptr), finalizePython_(nullptr), createSpec_(nullptr),
         destroySpec_(nullptr), createPyNode_(nullptr) {
+#ifndef NTA_PYTHON_SUPPORT
+    NTA_THROW << "Python regions are not supported by this build";
+#else
     initPython_ = (initPythonFunc)PyRegion::NTA_initPython;
     finalizePython_ = (finalizePythonFunc)PyRegion::NTA_finalizePython;
     createPyNode_ = (createPyNodeFunc)PyRegion::NTA_createPyNode;
@@ -140,6 +145,7 @@ public:
     destroySpec_ = (destroySpecFunc)PyRegion::NTA_destroySpec;
 
     (*initPython_)();
+#endif
   }
 
   ~DynamicPythonLibrary() {
@@ -88,6 +88,27 @@ ArrayRef Region::getOutputData(const std::string &outputName) const {
   return a;
 }
 
+OutputHandle Region::resolveOutput(const std::string &outputName) const {
+  auto oi = outputs_.find(outputName);
+  if (oi == outputs_.end())
+    NTA_THROW << "resolveOutput -- unknown output '" << outputName
+              << "' on region " << getName();
+
+  return OutputHandle(oi->second);
+}
+
+const Array &OutputHandle::getData() const {
+  NTA_CHECK(output_ != nullptr) << "OutputHandle::getData -- invalid handle";
+  return output_->getData();
+}
+
+ArrayRef OutputHandle::getDataRef() const {
+  const Array &data = getData();
+  ArrayRef a(data.getType());
+  a.setBuffer(data.getBuffer(), data.getCount());
+  return a;
+}
+
 ArrayRef Region::getInputData(const std::string &inputName) const {
   auto ii = inputs_.find(inputName);
   if (ii == inputs_.end())
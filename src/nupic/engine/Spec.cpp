@@ -89,15 +89,17 @@ std::string Spec::getDefaultOutputName() const {
 
 InputSpec::InputSpec(std::string description, NTA_BasicType dataType,
                      UInt32 count, bool required, bool regionLevel,
-                     bool isDefaultInput, bool requireSplitterMap, bool sparse)
+                     bool isDefaultInput, bool requireSplitterMap, bool sparse,
+                     bool readOnly)
     : description(std::move(description)), dataType(dataType), count(count),
       required(required), regionLevel(regionLevel),
       isDefaultInput(isDefaultInput), requireSplitterMap(requireSplitterMap),
-      sparse(sparse) {}
+      sparse(sparse), readOnly(readOnly) {}
 bool InputSpec::operator==(const InputSpec &o) const {
   return required == o.required && regionLevel == o.regionLevel &&
          isDefaultInput == o.isDefaultInput && sparse == o.sparse &&
-         requireSplitterMap == o.requireSplitterMap && dataType == o.dataType &&
+         requireSplitterMap == o.requireSplitterMap &&
+         readOnly == o.readOnly && dataType == o.dataType &&
          count == o.count && description == o.description;
 }
 OutputSpec::OutputSpec(std::string description, NTA_BasicType dataType,
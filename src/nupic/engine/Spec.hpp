@@ -38,7 +38,8 @@ public:
   InputSpec() {}
   InputSpec(std::string description, NTA_BasicType dataType, UInt32 count,
             bool required, bool regionLevel, bool isDefaultInput,
-            bool requireSplitterMap = true, bool sparse = false);
+            bool requireSplitterMap = true, bool sparse = false,
+            bool readOnly = false);
   bool operator==(const InputSpec &other) const;
   inline bool operator!=(const InputSpec &other) const {
     return !operator==(other);
@@ -54,6 +55,10 @@ public:
   bool isDefaultInput;
   bool requireSplitterMap;
   bool sparse;
+  // Whether the region never writes to the input's data. Only such an
+  // input, fed by a single output, may read the output's buffer instead of
+  // a copy.
+  bool readOnly;
 };
 
 class OutputSpec {
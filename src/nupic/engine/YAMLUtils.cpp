@@ -289,9 +289,10 @@ ValueMap toValueMap(const char *yamlstring,
   // Populate ValueMap with default values if they were not specified in the
   // YAML dictionary.
   for (size_t i = 0; i < parameters.getCount(); i++) {
-    std::pair<std::string, ParameterSpec> &item = parameters.getByIndex(i);
+    const std::pair<std::string, ParameterSpec> &item =
+        parameters.getByIndex(i);
     if (!vm.contains(item.first)) {
-      ParameterSpec &ps = item.second;
+      const ParameterSpec &ps = item.second;
       if (ps.defaultValue != "") {
         // TODO: This check should be uncommented after dropping NuPIC 1.x nodes
         // (which don't comply) if (ps.accessMode !=
@@ -0,0 +1,142 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition and implementation for GrowableMatrix
+ */
+
+#ifndef NTA_GROWABLE_MATRIX_HPP
+#define NTA_GROWABLE_MATRIX_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/Log.hpp>
+
+namespace nupic {
+
+/**
+ * A dense, row major matrix that can grow in both dimensions in amortized
+ * constant time per element.
+ *
+ * Rows are stored with a stride of colCapacity() elements, and the storage
+ * holds rowCapacity() rows. When resize() needs more than the current
+ * capacity in a dimension, that capacity is at least doubled, so a matrix
+ * that keeps growing one row or one column at a time is only reallocated
+ * a logarithmic number of times. Elements that become visible when the
+ * matrix grows are 0.
+ */
+template <typename T> class GrowableMatrix {
+public:
+  inline GrowableMatrix()
+      : nRows_(0), nCols_(0), rowCapacity_(0), colCapacity_(0), data_() {}
+
+  inline GrowableMatrix(UInt nrows, UInt ncols)
+      : nRows_(nrows), nCols_(ncols), rowCapacity_(nrows),
+        colCapacity_(ncols), data_((size_t)nrows * ncols, 0) {}
+
+  inline UInt nRows() const { return nRows_; }
+  inline UInt nCols() const { return nCols_; }
+  inline UInt rowCapacity() const { return rowCapacity_; }
+  inline UInt colCapacity() const { return colCapacity_; }
+
+  /**
+   * Makes sure there is room for at least nrows x ncols elements without
+   * changing the size of the matrix.
+   */
+  void reserve(UInt nrows, UInt ncols) {
+    if (nrows <= rowCapacity_ && ncols <= colCapacity_) {
+      return;
+    }
+
+    nrows = std::max(nrows, rowCapacity_);
+    ncols = std::max(ncols, colCapacity_);
+    std::vector<T> data((size_t)nrows * ncols, 0);
+    for (UInt i = 0; i < nRows_; ++i) {
+      std::copy(row(i), row(i) + nCols_, &data[(size_t)i * ncols]);
+    }
+    data_.swap(data);
+    rowCapacity_ = nrows;
+    colCapacity_ = ncols;
+  }
+
+  /**
+   * Changes the size of the matrix, keeping the existing elements. New
+   * elements are 0.
+   */
+  void resize(UInt nrows, UInt ncols) {
+    if (nrows > rowCapacity_ || ncols > colCapacity_) {
+      reserve(nrows > rowCapacity_ ? std::max(nrows, 2 * rowCapacity_)
+                                   : rowCapacity_,
+              ncols > colCapacity_ ? std::max(ncols, 2 * colCapacity_)
+                                   : colCapacity_);
+    }
+
+    // Clear what was left behind by an earlier shrink.
+    for (UInt i = 0; i < std::min(nRows_, nrows); ++i) {
+      if (ncols > nCols_) {
+        std::fill(row(i) + nCols_, row(i) + ncols, (T)0);
+      }
+    }
+    for (UInt i = nRows_; i < nrows; ++i) {
+      std::fill(row(i), row(i) + ncols, (T)0);
+    }
+
+    nRows_ = nrows;
+    nCols_ = ncols;
+  }
+
+  /**
+   * Pointer to the nCols() elements of row i.
+   */
+  inline T *row(UInt i) {
+    NTA_ASSERT(i < rowCapacity_);
+    return data_.data() + (size_t)i * colCapacity_;
+  }
+
+  inline const T *row(UInt i) const {
+    NTA_ASSERT(i < rowCapacity_);
+    return data_.data() + (size_t)i * colCapacity_;
+  }
+
+  inline T &at(UInt i, UInt j) {
+    NTA_ASSERT(i < nRows_ && j < nCols_);
+    return data_[(size_t)i * colCapacity_ + j];
+  }
+
+  inline const T &at(UInt i, UInt j) const {
+    NTA_ASSERT(i < nRows_ && j < nCols_);
+    return data_[(size_t)i * colCapacity_ + j];
+  }
+
+private:
+  UInt nRows_;
+  UInt nCols_;
+  UInt rowCapacity_;
+  UInt colCapacity_;
+  std::vector<T> data_;
+};
+
+} // end namespace nupic
+
+#endif // NTA_GROWABLE_MATRIX_HPP
@@ -0,0 +1,227 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition and implementation for PackedBinaryMatrix
+ */
+
+#ifndef NTA_PACKED_BINARY_MATRIX_HPP
+#define NTA_PACKED_BINARY_MATRIX_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <nupic/math/ArrayAlgo.hpp>
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/Log.hpp>
+
+#if defined(NTA_ASM) && (defined(__x86_64__) || defined(__i386__)) &&         \
+    (defined(NTA_COMPILER_GNU) || defined(NTA_COMPILER_CLANG))
+#define NTA_PACKED_BINARY_MATRIX_POPCNT
+#endif
+
+namespace nupic {
+
+/**
+ * A matrix of 0 and 1, stored as one bit per element.
+ *
+ * Each row is padded to a whole number of 64 bit words. Bit j of row i is
+ * bit (j % 64) of word (j / 64) of that row. Vectors passed to the packed
+ * methods use the same layout, see pack() and unpack().
+ *
+ * Compared to SparseBinaryMatrix, this trades memory proportional to
+ * nRows * nCols for a matrix-vector product that touches one word per 64
+ * columns instead of one index per non-zero. That is a win as soon as the
+ * rows are moderately dense, e.g. more than one non-zero per 64 columns.
+ */
+class PackedBinaryMatrix {
+public:
+  static const UInt BITS_PER_WORD = 64;
+
+  inline PackedBinaryMatrix() : nRows_(0), nCols_(0), nWords_(0), bits_() {}
+
+  inline UInt nRows() const { return nRows_; }
+  inline UInt nCols() const { return nCols_; }
+
+  /**
+   * Number of 64 bit words used to store one row, or one packed vector of
+   * nCols() elements.
+   */
+  inline UInt nWordsPerRow() const { return nWords_; }
+
+  static inline UInt nWords(UInt n) {
+    return (n + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  }
+
+  /**
+   * Resizes the matrix and clears all its elements.
+   */
+  inline void resize(UInt nrows, UInt ncols) {
+    nRows_ = nrows;
+    nCols_ = ncols;
+    nWords_ = nWords(ncols);
+    bits_.assign((size_t)nRows_ * nWords_, 0);
+  }
+
+  inline bool get(UInt row, UInt col) const {
+    NTA_ASSERT(row < nRows_ && col < nCols_);
+    return (row_(row)[col / BITS_PER_WORD] >> (col % BITS_PER_WORD)) & 1;
+  }
+
+  /**
+   * Replaces the contents of a row with the given column indices of its
+   * non-zeros.
+   */
+  template <typename InputIterator>
+  inline void replaceSparseRow(UInt row, InputIterator ind,
+                               InputIterator ind_end) {
+    NTA_ASSERT(row < nRows_);
+    UInt64 *words = row_(row);
+    std::fill(words, words + nWords_, 0);
+    for (; ind != ind_end; ++ind) {
+      NTA_ASSERT((UInt)*ind < nCols_);
+      words[*ind / BITS_PER_WORD] |= (UInt64)1 << (*ind % BITS_PER_WORD);
+    }
+  }
+
+  /**
+   * Matrix vector multiplication of this matrix by a packed binary vector:
+   * y[i] is the number of columns that are set in both row i and x.
+   *
+   * x must hold nWordsPerRow() words, and its padding bits must be 0.
+   */
+  template <typename OutputIterator>
+  inline void rightVecSumAtNZPacked(const UInt64 *x, OutputIterator y,
+                                    OutputIterator y_end) const {
+    NTA_ASSERT((UInt)(y_end - y) >= nRows_)
+        << "PackedBinaryMatrix::rightVecSumAtNZPacked: "
+        << "Invalid output vector size: " << (UInt)(y_end - y)
+        << " - Should >= number of rows: " << nRows_;
+
+#ifdef NTA_PACKED_BINARY_MATRIX_POPCNT
+    // POPCNT was introduced together with SSE 4.2.
+    if (SSE_LEVEL >= 42) {
+      for (UInt i = 0; i != nRows_; ++i, ++y)
+        *y = andCountPopcnt_(row_(i), x, nWords_);
+      return;
+    }
+#endif
+
+    for (UInt i = 0; i != nRows_; ++i, ++y)
+      *y = andCount_(row_(i), x, nWords_);
+  }
+
+  /**
+   * Same as rightVecSumAtNZPacked, for nVectors packed vectors stored one
+   * after the other in x, nWordsPerRow() words each. Each row is loaded once
+   * for all the vectors. y[v * nRows() + i] receives the count for row i and
+   * vector v.
+   */
+  template <typename OutputIterator>
+  inline void rightVecSumAtNZPacked(const UInt64 *x, UInt nVectors,
+                                    OutputIterator y) const {
+#ifdef NTA_PACKED_BINARY_MATRIX_POPCNT
+    if (SSE_LEVEL >= 42) {
+      for (UInt i = 0; i != nRows_; ++i)
+        for (UInt v = 0; v != nVectors; ++v)
+          y[(size_t)v * nRows_ + i] =
+              andCountPopcnt_(row_(i), x + (size_t)v * nWords_, nWords_);
+      return;
+    }
+#endif
+
+    for (UInt i = 0; i != nRows_; ++i)
+      for (UInt v = 0; v != nVectors; ++v)
+        y[(size_t)v * nRows_ + i] =
+            andCount_(row_(i), x + (size_t)v * nWords_, nWords_);
+  }
+
+  /**
+   * Packs a dense vector of n elements into nWords(n) words. Any non-zero
+   * element becomes a 1 bit.
+   */
+  template <typename T> static void pack(const T *dense, UInt n, UInt64 *out) {
+    const UInt nw = nWords(n);
+    for (UInt w = 0; w != nw; ++w) {
+      const UInt begin = w * BITS_PER_WORD;
+      const UInt end = std::min(begin + BITS_PER_WORD, n);
+      UInt64 word = 0;
+      for (UInt j = begin; j != end; ++j)
+        word |= (UInt64)(dense[j] != 0) << (j - begin);
+      out[w] = word;
+    }
+  }
+
+  /**
+   * Unpacks nWords(n) words into a dense vector of n 0's and 1's.
+   */
+  template <typename T>
+  static void unpack(const UInt64 *packed, UInt n, T *dense) {
+    for (UInt j = 0; j != n; ++j)
+      dense[j] = (T)((packed[j / BITS_PER_WORD] >> (j % BITS_PER_WORD)) & 1);
+  }
+
+private:
+  inline UInt64 *row_(UInt row) { return &bits_[(size_t)row * nWords_]; }
+  inline const UInt64 *row_(UInt row) const {
+    return &bits_[(size_t)row * nWords_];
+  }
+
+  static inline UInt popcount_(UInt64 x) {
+#if defined(NTA_COMPILER_GNU) || defined(NTA_COMPILER_CLANG)
+    return (UInt)__builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (UInt)((x * 0x0101010101010101ULL) >> 56);
+#endif
+  }
+
+  static inline UInt andCount_(const UInt64 *a, const UInt64 *b, UInt n) {
+    UInt count = 0;
+    for (UInt w = 0; w != n; ++w)
+      count += popcount_(a[w] & b[w]);
+    return count;
+  }
+
+#ifdef NTA_PACKED_BINARY_MATRIX_POPCNT
+  // Same as andCount_, but compiled so that __builtin_popcountll becomes a
+  // single POPCNT instruction. Only call this after checking SSE_LEVEL.
+  __attribute__((target("popcnt"))) static UInt
+  andCountPopcnt_(const UInt64 *a, const UInt64 *b, UInt n) {
+    UInt count = 0;
+    for (UInt w = 0; w != n; ++w)
+      count += (UInt)__builtin_popcountll(a[w] & b[w]);
+    return count;
+  }
+#endif
+
+  UInt nRows_;
+  UInt nCols_;
+  UInt nWords_;
+  std::vector<UInt64> bits_;
+};
+
+} // end namespace nupic
+
+#endif // NTA_PACKED_BINARY_MATRIX_HPP
@@ -24,6 +24,8 @@
  * Topology helpers
  */
 
+#include <algorithm>
+
 #include <nupic/math/Topology.hpp>
 #include <nupic/utils/Log.hpp>
 
@@ -64,6 +66,136 @@ UInt indexFromCoordinates(const vector<UInt> &coordinates,
   return index;
 }
 
+// The neighborhood of coordinate c along a dimension of size n, expressed as
+// an inclusive range [lo, hi]. With wrap-around the range may extend past
+// either edge and has to be taken modulo n. Both lo and hi are
+// non-decreasing in c, which is what lets the sliding window passes below
+// visit each element a constant number of times.
+static void windowBounds_(Int c, Int radius, Int n, bool wrapAround, Int &lo,
+                          Int &hi) {
+  if (wrapAround) {
+    lo = c - radius;
+    hi = lo + std::min(2 * radius + 1, n) - 1;
+  } else {
+    lo = std::max(0, c - radius);
+    hi = std::min(n - 1, c + radius);
+  }
+}
+
+static inline Int wrapCoordinate_(Int coordinate, Int n) {
+  coordinate %= n;
+  return coordinate < 0 ? coordinate + n : coordinate;
+}
+
+// Call f(base, n, stride) once for every line along the given dimension.
+template <typename LineFunction>
+static void forEachLine_(const vector<UInt> &dimensions, size_t dimension,
+                         LineFunction f) {
+  UInt stride = 1;
+  for (size_t i = dimension + 1; i < dimensions.size(); i++) {
+    stride *= dimensions[i];
+  }
+  UInt outer = 1;
+  for (size_t i = 0; i < dimension; i++) {
+    outer *= dimensions[i];
+  }
+
+  const UInt n = dimensions[dimension];
+  for (UInt o = 0; o < outer; o++) {
+    for (UInt i = 0; i < stride; i++) {
+      f(o * n * stride + i, n, stride);
+    }
+  }
+}
+
+void neighborhoodMeans(const vector<Real> &values, UInt radius,
+                       const vector<UInt> &dimensions, bool wrapAround,
+                       vector<Real> &means) {
+  // Accumulate in double precision: the prefix sums subtract large, nearly
+  // equal numbers.
+  vector<Real64> sums(values.begin(), values.end());
+  vector<UInt> counts(values.size(), 1);
+  vector<Real64> prefix;
+  vector<Real64> lineSums;
+
+  for (size_t d = 0; d < dimensions.size(); d++) {
+    forEachLine_(dimensions, d, [&](UInt base, UInt n, UInt stride) {
+      prefix.resize(n + 1);
+      lineSums.resize(n);
+      prefix[0] = 0;
+      for (UInt j = 0; j < n; j++) {
+        prefix[j + 1] = prefix[j] + sums[base + j * stride];
+      }
+
+      for (UInt c = 0; c < n; c++) {
+        Int lo, hi;
+        windowBounds_(c, radius, n, wrapAround, lo, hi);
+        const Int length = hi - lo + 1;
+        const Int start = wrapCoordinate_(lo, n);
+        if (start + length <= (Int)n) {
+          lineSums[c] = prefix[start + length] - prefix[start];
+        } else {
+          lineSums[c] =
+              prefix[n] - prefix[start] + prefix[start + length - n];
+        }
+        counts[base + c * stride] *= length;
+      }
+
+      for (UInt c = 0; c < n; c++) {
+        sums[base + c * stride] = lineSums[c];
+      }
+    });
+  }
+
+  means.resize(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    means[i] = (Real)(sums[i] / counts[i]);
+  }
+}
+
+void neighborhoodMaxima(const vector<Real> &values, UInt radius,
+                        const vector<UInt> &dimensions, bool wrapAround,
+                        vector<Real> &maxima) {
+  maxima.assign(values.begin(), values.end());
+  vector<Real> line;
+  vector<Int> window;
+
+  for (size_t d = 0; d < dimensions.size(); d++) {
+    forEachLine_(dimensions, d, [&](UInt base, UInt n, UInt stride) {
+      line.resize(n);
+      for (UInt j = 0; j < n; j++) {
+        line[j] = maxima[base + j * stride];
+      }
+
+      Int firstLo, firstHi, lastLo, lastHi;
+      windowBounds_(0, radius, n, wrapAround, firstLo, firstHi);
+      windowBounds_(n - 1, radius, n, wrapAround, lastLo, lastHi);
+      window.resize(lastHi - firstLo + 1);
+
+      // Monotonic queue of positions whose values are decreasing, so the
+      // front is always the maximum of the current window.
+      Int head = 0, tail = 0;
+      Int next = firstLo;
+      for (UInt c = 0; c < n; c++) {
+        Int lo, hi;
+        windowBounds_(c, radius, n, wrapAround, lo, hi);
+        for (; next <= hi; next++) {
+          const Real v = line[wrapCoordinate_(next, n)];
+          while (tail > head &&
+                 line[wrapCoordinate_(window[tail - 1], n)] <= v) {
+            tail--;
+          }
+          window[tail++] = next;
+        }
+        while (window[head] < lo) {
+          head++;
+        }
+        maxima[base + c * stride] = line[wrapCoordinate_(window[head], n)];
+      }
+    });
+  }
+}
+
 } // end namespace topology
 } // namespace math
 } // end namespace nupic
@@ -69,6 +69,63 @@ std::vector<UInt> coordinatesFromIndex(UInt index,
 UInt indexFromCoordinates(const std::vector<UInt> &coordinates,
                           const std::vector<UInt> &dimensions);
 
+/**
+ * For every point, compute the mean of the values within its neighborhood.
+ *
+ * This gives the same result as iterating a Neighborhood (or a
+ * WrappingNeighborhood) around each point and averaging, but it runs in
+ * O(numPoints * numDimensions) regardless of the radius. The neighborhood
+ * is a hypercube, so the sums are separable: each dimension is reduced in
+ * turn using 1D prefix sums along every line of that dimension.
+ *
+ * @param values
+ * One value per point, laid out according to dimensions.
+ *
+ * @param radius
+ * The radius of each point's neighborhood.
+ *
+ * @param dimensions
+ * The coordinate system.
+ *
+ * @param wrapAround
+ * Whether neighborhoods wrap around the edges (as in WrappingNeighborhood)
+ * or are truncated (as in Neighborhood).
+ *
+ * @param means
+ * Output vector. Resized to values.size().
+ */
+void neighborhoodMeans(const std::vector<Real> &values, UInt radius,
+                       const std::vector<UInt> &dimensions, bool wrapAround,
+                       std::vector<Real> &means);
+
+/**
+ * For every point, compute the maximum of the values within its
+ * neighborhood.
+ *
+ * Like neighborhoodMeans, this is computed one dimension at a time, using a
+ * sliding window maximum along every line, so its cost doesn't depend on the
+ * radius.
+ *
+ * @param values
+ * One value per point, laid out according to dimensions.
+ *
+ * @param radius
+ * The radius of each point's neighborhood.
+ *
+ * @param dimensions
+ * The coordinate system.
+ *
+ * @param wrapAround
+ * Whether neighborhoods wrap around the edges (as in WrappingNeighborhood)
+ * or are truncated (as in Neighborhood).
+ *
+ * @param maxima
+ * Output vector. Resized to values.size().
+ */
+void neighborhoodMaxima(const std::vector<Real> &values, UInt radius,
+                        const std::vector<UInt> &dimensions, bool wrapAround,
+                        std::vector<Real> &maxima);
+
 /**
  * A class that lets you iterate over all points within the neighborhood
  * of a point.
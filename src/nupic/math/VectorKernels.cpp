@@ -0,0 +1,360 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the vector kernels
+ */
+
+#include <algorithm>
+
+#include <nupic/math/VectorKernels.hpp>
+
+#ifdef NTA_AVX_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace nupic {
+namespace math {
+namespace kernels {
+
+// The CPU is checked on first use rather than during static
+// initialization, so that kernels called from other static initializers
+// see the right answer.
+bool cpuHasAvx() {
+#ifdef NTA_AVX_DISPATCH
+  static const bool hasAvx =
+      (__builtin_cpu_init(), __builtin_cpu_supports("avx") != 0);
+  return hasAvx;
+#else
+  return false;
+#endif
+}
+
+bool cpuHasAvx2() {
+#ifdef NTA_AVX_DISPATCH
+  static const bool hasAvx2 =
+      (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+  return hasAvx2;
+#else
+  return false;
+#endif
+}
+
+#ifdef NTA_AVX_DISPATCH
+__attribute__((target("avx"))) static void addToAvx_(Real32 *y,
+                                                      const Real32 *x, UInt n) {
+  UInt j = 0;
+  for (; j + 8 <= n; j += 8) {
+    _mm256_storeu_ps(y + j, _mm256_add_ps(_mm256_loadu_ps(y + j),
+                                          _mm256_loadu_ps(x + j)));
+  }
+  for (; j < n; ++j) {
+    y[j] += x[j];
+  }
+}
+
+__attribute__((target("avx"))) static void addToAvx_(Real64 *y,
+                                                      const Real64 *x, UInt n) {
+  UInt j = 0;
+  for (; j + 4 <= n; j += 4) {
+    _mm256_storeu_pd(y + j, _mm256_add_pd(_mm256_loadu_pd(y + j),
+                                          _mm256_loadu_pd(x + j)));
+  }
+  for (; j < n; ++j) {
+    y[j] += x[j];
+  }
+}
+
+__attribute__((target("avx"))) static void addToAvx_(Real64 *y,
+                                                      const Real32 *x, UInt n) {
+  UInt j = 0;
+  for (; j + 4 <= n; j += 4) {
+    const __m256d xx = _mm256_cvtps_pd(_mm_loadu_ps(x + j));
+    _mm256_storeu_pd(y + j, _mm256_add_pd(_mm256_loadu_pd(y + j), xx));
+  }
+  for (; j < n; ++j) {
+    y[j] += x[j];
+  }
+}
+
+__attribute__((target("avx"))) static void
+addScaledToAvx_(Real64 *y, Real64 a, const Real64 *x, UInt n) {
+  const __m256d aa = _mm256_set1_pd(a);
+  UInt j = 0;
+  for (; j + 4 <= n; j += 4) {
+    _mm256_storeu_pd(y + j,
+                     _mm256_add_pd(_mm256_loadu_pd(y + j),
+                                   _mm256_mul_pd(aa, _mm256_loadu_pd(x + j))));
+  }
+  for (; j < n; ++j) {
+    y[j] += a * x[j];
+  }
+}
+
+__attribute__((target("avx"))) static void
+addScaledToAvx_(Real32 *y, Real64 a, const Real64 *x, UInt n) {
+  const __m256d aa = _mm256_set1_pd(a);
+  UInt j = 0;
+  for (; j + 4 <= n; j += 4) {
+    const __m256d sum =
+        _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(y + j)),
+                      _mm256_mul_pd(aa, _mm256_loadu_pd(x + j)));
+    _mm_storeu_ps(y + j, _mm256_cvtpd_ps(sum));
+  }
+  for (; j < n; ++j) {
+    y[j] = (Real32)(y[j] + a * x[j]);
+  }
+}
+
+__attribute__((target("avx"))) static void divideByAvx_(Real64 *y, UInt n,
+                                                         Real64 d) {
+  const __m256d dd = _mm256_set1_pd(d);
+  UInt j = 0;
+  for (; j + 4 <= n; j += 4) {
+    _mm256_storeu_pd(y + j, _mm256_div_pd(_mm256_loadu_pd(y + j), dd));
+  }
+  for (; j < n; ++j) {
+    y[j] /= d;
+  }
+}
+
+__attribute__((target("avx"))) static Real32 dotAvx_(const Real32 *a,
+                                                     const Real32 *x, UInt n) {
+  __m256 sums = _mm256_setzero_ps();
+  UInt j = 0;
+  for (; j + 8 <= n; j += 8) {
+    sums = _mm256_add_ps(
+        sums, _mm256_mul_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(x + j)));
+  }
+  Real32 lanes[8];
+  _mm256_storeu_ps(lanes, sums);
+  Real32 sum = 0;
+  for (UInt k = 0; k < 8; ++k) {
+    sum += lanes[k];
+  }
+  for (; j < n; ++j) {
+    sum += a[j] * x[j];
+  }
+  return sum;
+}
+
+__attribute__((target("avx"))) static Real64 dotAvx_(const Real64 *a,
+                                                     const Real64 *x, UInt n) {
+  __m256d sums = _mm256_setzero_pd();
+  UInt j = 0;
+  for (; j + 4 <= n; j += 4) {
+    sums = _mm256_add_pd(
+        sums, _mm256_mul_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(x + j)));
+  }
+  Real64 lanes[4];
+  _mm256_storeu_pd(lanes, sums);
+  Real64 sum = 0;
+  for (UInt k = 0; k < 4; ++k) {
+    sum += lanes[k];
+  }
+  for (; j < n; ++j) {
+    sum += a[j] * x[j];
+  }
+  return sum;
+}
+
+__attribute__((target("avx"))) static Real32
+maxProdAvx_(const Real32 *a, const Real32 *x, UInt n) {
+  __m256 maxima = _mm256_setzero_ps();
+  UInt j = 0;
+  for (; j + 8 <= n; j += 8) {
+    maxima = _mm256_max_ps(
+        maxima, _mm256_mul_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(x + j)));
+  }
+  Real32 lanes[8];
+  _mm256_storeu_ps(lanes, maxima);
+  Real32 result = 0;
+  for (UInt k = 0; k < 8; ++k) {
+    result = std::max(result, lanes[k]);
+  }
+  for (; j < n; ++j) {
+    result = std::max(result, a[j] * x[j]);
+  }
+  return result;
+}
+
+__attribute__((target("avx"))) static Real64
+maxProdAvx_(const Real64 *a, const Real64 *x, UInt n) {
+  __m256d maxima = _mm256_setzero_pd();
+  UInt j = 0;
+  for (; j + 4 <= n; j += 4) {
+    maxima = _mm256_max_pd(
+        maxima, _mm256_mul_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(x + j)));
+  }
+  Real64 lanes[4];
+  _mm256_storeu_pd(lanes, maxima);
+  Real64 result = 0;
+  for (UInt k = 0; k < 4; ++k) {
+    result = std::max(result, lanes[k]);
+  }
+  for (; j < n; ++j) {
+    result = std::max(result, a[j] * x[j]);
+  }
+  return result;
+}
+#endif
+
+void addTo(Real32 *y, const Real32 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    addToAvx_(y, x, n);
+    return;
+  }
+#endif
+  for (UInt j = 0; j < n; ++j) {
+    y[j] += x[j];
+  }
+}
+
+void addTo(Real64 *y, const Real64 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    addToAvx_(y, x, n);
+    return;
+  }
+#endif
+  for (UInt j = 0; j < n; ++j) {
+    y[j] += x[j];
+  }
+}
+
+void addTo(Real64 *y, const Real32 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    addToAvx_(y, x, n);
+    return;
+  }
+#endif
+  for (UInt j = 0; j < n; ++j) {
+    y[j] += x[j];
+  }
+}
+
+void addScaledTo(Real64 *y, Real64 a, const Real64 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    addScaledToAvx_(y, a, x, n);
+    return;
+  }
+#endif
+  for (UInt j = 0; j < n; ++j) {
+    y[j] += a * x[j];
+  }
+}
+
+void addScaledTo(Real32 *y, Real64 a, const Real64 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    addScaledToAvx_(y, a, x, n);
+    return;
+  }
+#endif
+  for (UInt j = 0; j < n; ++j) {
+    y[j] = (Real32)(y[j] + a * x[j]);
+  }
+}
+
+void divideBy(Real64 *y, UInt n, Real64 d) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    divideByAvx_(y, n, d);
+    return;
+  }
+#endif
+  for (UInt j = 0; j < n; ++j) {
+    y[j] /= d;
+  }
+}
+
+// Sums the products in the order of dotAvx_: one partial sum per lane of
+// an AVX register, added up in lane order, then the tail.
+template <typename T, UInt lanes>
+static T dotInLanes_(const T *a, const T *x, UInt n) {
+  T sums[lanes] = {};
+  UInt j = 0;
+  for (; j + lanes <= n; j += lanes) {
+    for (UInt k = 0; k < lanes; ++k) {
+      sums[k] += a[j + k] * x[j + k];
+    }
+  }
+  T sum = 0;
+  for (UInt k = 0; k < lanes; ++k) {
+    sum += sums[k];
+  }
+  for (; j < n; ++j) {
+    sum += a[j] * x[j];
+  }
+  return sum;
+}
+
+Real32 dot(const Real32 *a, const Real32 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    return dotAvx_(a, x, n);
+  }
+#endif
+  return dotInLanes_<Real32, 8>(a, x, n);
+}
+
+Real64 dot(const Real64 *a, const Real64 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    return dotAvx_(a, x, n);
+  }
+#endif
+  return dotInLanes_<Real64, 4>(a, x, n);
+}
+
+Real32 maxProd(const Real32 *a, const Real32 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    return maxProdAvx_(a, x, n);
+  }
+#endif
+  Real32 result = 0;
+  for (UInt j = 0; j < n; ++j) {
+    result = std::max(result, a[j] * x[j]);
+  }
+  return result;
+}
+
+Real64 maxProd(const Real64 *a, const Real64 *x, UInt n) {
+#ifdef NTA_AVX_DISPATCH
+  if (cpuHasAvx()) {
+    return maxProdAvx_(a, x, n);
+  }
+#endif
+  Real64 result = 0;
+  for (UInt j = 0; j < n; ++j) {
+    result = std::max(result, a[j] * x[j]);
+  }
+  return result;
+}
+
+} // namespace kernels
+} // namespace math
+} // namespace nupic
@@ -0,0 +1,92 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Vector kernels with run-time AVX dispatch
+ */
+
+#ifndef NTA_VECTOR_KERNELS_HPP
+#define NTA_VECTOR_KERNELS_HPP
+
+#include <nupic/types/Types.hpp>
+
+// Defined when kernels can be compiled for AVX or AVX2 with target
+// attributes and selected at run time, with cpuHasAvx() or cpuHasAvx2().
+// Files with kernels of their own include <immintrin.h> under it.
+#if defined(NTA_ASM) && (defined(__x86_64__) || defined(__i386__)) &&         \
+    (defined(NTA_COMPILER_GNU) || defined(NTA_COMPILER_CLANG))
+#define NTA_AVX_DISPATCH
+#endif
+
+namespace nupic {
+namespace math {
+namespace kernels {
+
+/**
+ * Whether the CPU supports AVX. Always false without NTA_AVX_DISPATCH.
+ */
+bool cpuHasAvx();
+
+/**
+ * Whether the CPU supports AVX2. Always false without NTA_AVX_DISPATCH.
+ */
+bool cpuHasAvx2();
+
+/**
+ * y[j] += x[j] for j in [0, n)
+ */
+void addTo(Real32 *y, const Real32 *x, UInt n);
+void addTo(Real64 *y, const Real64 *x, UInt n);
+void addTo(Real64 *y, const Real32 *x, UInt n);
+
+/**
+ * y[j] += a * x[j] for j in [0, n). The Real32 version rounds the sums to
+ * single precision.
+ */
+void addScaledTo(Real64 *y, Real64 a, const Real64 *x, UInt n);
+void addScaledTo(Real32 *y, Real64 a, const Real64 *x, UInt n);
+
+/**
+ * y[j] /= d for j in [0, n)
+ */
+void divideBy(Real64 *y, UInt n, Real64 d);
+
+/**
+ * Sum of a[j] * x[j] for j in [0, n). The products are summed in 8 (Real32)
+ * or 4 (Real64) interleaved partial sums, with or without AVX, so the result
+ * doesn't depend on the CPU. It can differ from a sum in index order by
+ * rounding.
+ */
+Real32 dot(const Real32 *a, const Real32 *x, UInt n);
+Real64 dot(const Real64 *a, const Real64 *x, UInt n);
+
+/**
+ * Max of 0 and a[j] * x[j] for j in [0, n)
+ */
+Real32 maxProd(const Real32 *a, const Real32 *x, UInt n);
+Real64 maxProd(const Real64 *a, const Real64 *x, UInt n);
+
+} // namespace kernels
+} // namespace math
+} // namespace nupic
+
+#endif // NTA_VECTOR_KERNELS_HPP
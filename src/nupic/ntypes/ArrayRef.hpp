@@ -45,6 +45,8 @@ public:
 
   ArrayRef(const ArrayRef &other) : ArrayBase(other) {}
 
+  ArrayRef &operator=(const ArrayRef &other) = default;
+
   void invariant() {
     if (own_)
       NTA_THROW << "ArrayRef mmust not own its buffer";
@@ -20,6 +20,7 @@
  * ---------------------------------------------------------------------
  */
 
+#include <algorithm>
 #include <nupic/ntypes/Collection.hpp>
 #include <nupic/utils/Log.hpp>
 #include <string>
@@ -48,7 +49,8 @@ bool Collection<T>::operator==(const Collection<T> &o) const {
                                  std::pair<std::string, T> b) {
     return a.first == b.first && a.second == b.second;
   };
-  return std::equal(vec_.begin(), vec_.end(), o.vec_.begin(), compare);
+  return vec_.size() == o.vec_.size() &&
+         std::equal(vec_.begin(), vec_.end(), o.vec_.begin(), compare);
 }
 template <typename T> size_t Collection<T>::getCount() const {
   return vec_.size();
@@ -60,41 +62,25 @@ const std::pair<std::string, T> &Collection<T>::getByIndex(size_t index) const {
   return vec_[index];
 }
 
-template <typename T>
-std::pair<std::string, T> &Collection<T>::getByIndex(size_t index) {
-  NTA_CHECK(index < vec_.size());
-  return vec_[index];
-}
-
 template <typename T>
 bool Collection<T>::contains(const std::string &name) const {
-  typename CollectionStorage::const_iterator i;
-  for (i = vec_.begin(); i != vec_.end(); i++) {
-    if (i->first == name)
-      return true;
-  }
-  return false;
+  return index_.find(name) != index_.end();
 }
 
 template <typename T>
 T Collection<T>::getByName(const std::string &name) const {
-  typename CollectionStorage::const_iterator i;
-  for (i = vec_.begin(); i != vec_.end(); i++) {
-    if (i->first == name)
-      return i->second;
-  }
-  NTA_THROW << "No item named: " << name;
+  auto i = index_.find(name);
+  if (i == index_.end())
+    NTA_THROW << "No item named: " << name;
+  return vec_[i->second].second;
 }
 
 template <typename T>
 void Collection<T>::add(const std::string &name, const T &item) {
   // make sure we don't already have something with this name
-  typename CollectionStorage::const_iterator i;
-  for (i = vec_.begin(); i != vec_.end(); i++) {
-    if (i->first == name) {
-      NTA_THROW << "Unable to add item '" << name << "' to collection "
-                << "because it already exists";
-    }
+  if (!index_.insert(std::make_pair(name, vec_.size())).second) {
+    NTA_THROW << "Unable to add item '" << name << "' to collection "
+              << "because it already exists";
   }
 
   // Add the new item to the vector
@@ -102,15 +88,17 @@ void Collection<T>::add(const std::string &name, const T &item) {
 }
 
 template <typename T> void Collection<T>::remove(const std::string &name) {
-  typename CollectionStorage::iterator i;
-  for (i = vec_.begin(); i != vec_.end(); i++) {
-    if (i->first == name)
-      break;
-  }
-  if (i == vec_.end())
+  auto i = index_.find(name);
+  if (i == index_.end())
     NTA_THROW << "No item named '" << name << "' in collection";
 
-  vec_.erase(i);
+  const size_t removed = i->second;
+  index_.erase(i);
+  vec_.erase(vec_.begin() + removed);
+
+  // The items after the removed one moved down by one
+  for (size_t j = removed; j < vec_.size(); j++)
+    index_[vec_[j].first] = j;
 }
 
 } // namespace nupic
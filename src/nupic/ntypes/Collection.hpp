@@ -24,12 +24,14 @@
 #define NTA_COLLECTION_HPP
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace nupic {
 // A collection is a templated class that contains items of type t.
-// It supports lookup by name and by index. The items are stored in a map
-// and copies are also stored in a vector (it's Ok to use pointers).
+// It supports lookup by name and by index. The items are stored in a vector
+// in insertion order, and a hash table maps each name to its index, so both
+// lookups take constant time. Removing an item is linear.
 // You can add items using the add() method.
 //
 template <typename T> class Collection {
@@ -59,13 +61,12 @@ public:
 
   void remove(const std::string &name);
 
-#ifdef NTA_INTERNAL
-  std::pair<std::string, T> &getByIndex(size_t index);
-#endif
-
 private:
   typedef std::vector<std::pair<std::string, T>> CollectionStorage;
   CollectionStorage vec_;
+
+  // Index in vec_ of each name
+  std::unordered_map<std::string, size_t> index_;
 };
 } // namespace nupic
 
@@ -0,0 +1,62 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of CycleClock
+ */
+
+#include <chrono>
+
+#include <nupic/os/CycleClock.hpp>
+
+namespace nupic {
+
+#ifdef NTA_CYCLE_CLOCK_TSC
+// Counts the ticks over a short interval of the steady clock. Modern x86
+// processors have an invariant TSC, which runs at the same rate whatever
+// the frequency of the cores.
+static Real64 measureTicksPerSecond_() {
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+  const UInt64 startTicks = CycleClock::now();
+
+  Clock::time_point end;
+  do {
+    end = Clock::now();
+  } while (end - start < std::chrono::milliseconds(10));
+  const UInt64 endTicks = CycleClock::now();
+
+  const Real64 seconds = std::chrono::duration<Real64>(end - start).count();
+  return (Real64)(endTicks - startTicks) / seconds;
+}
+#endif
+
+Real64 CycleClock::ticksPerSecond() {
+#ifdef NTA_CYCLE_CLOCK_TSC
+  static const Real64 ticks = measureTicksPerSecond_();
+  return ticks;
+#else
+  return 1e9;
+#endif
+}
+
+} // namespace nupic
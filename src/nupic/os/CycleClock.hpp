@@ -0,0 +1,76 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of CycleClock
+ */
+
+#ifndef NTA_CYCLE_CLOCK_HPP
+#define NTA_CYCLE_CLOCK_HPP
+
+#include <nupic/types/Types.hpp>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(NTA_COMPILER_GNU) || defined(NTA_COMPILER_CLANG))
+#define NTA_CYCLE_CLOCK_TSC
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace nupic {
+
+/**
+ * A clock for timing short intervals many times over, e.g. every iteration
+ * of a network.
+ *
+ * On x86 it reads the time stamp counter, which costs a few nanoseconds
+ * instead of the system call behind Timer. Other platforms fall back to
+ * std::chrono::steady_clock. Ticks are only meaningful as differences
+ * between two calls to now(), and are converted to seconds with
+ * ticksPerSecond().
+ */
+class CycleClock {
+public:
+  /**
+   * Current value of the clock, in ticks.
+   */
+  static inline UInt64 now() {
+#ifdef NTA_CYCLE_CLOCK_TSC
+    return (UInt64)__rdtsc();
+#else
+    return (UInt64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  /**
+   * Number of ticks per second. The first call measures it against the
+   * steady clock, which takes about 10 milliseconds.
+   */
+  static Real64 ticksPerSecond();
+};
+
+} // namespace nupic
+
+#endif // NTA_CYCLE_CLOCK_HPP
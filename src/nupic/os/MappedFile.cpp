@@ -0,0 +1,126 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of MappedFile
+ */
+
+#include <nupic/os/MappedFile.hpp>
+#include <nupic/utils/Log.hpp>
+
+#if defined(NTA_OS_WINDOWS)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nupic {
+
+#if defined(NTA_OS_WINDOWS)
+
+MappedFile::MappedFile(const std::string &path)
+    : data_(nullptr), size_(0), mapping_(nullptr) {
+  HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    NTA_THROW << "MappedFile -- unable to open '" << path
+              << "', error code " << ::GetLastError();
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(file, &size)) {
+    const DWORD error = ::GetLastError();
+    ::CloseHandle(file);
+    NTA_THROW << "MappedFile -- unable to get the size of '" << path
+              << "', error code " << error;
+  }
+  size_ = (size_t)size.QuadPart;
+
+  if (size_ != 0) {
+    mapping_ = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+                                    nullptr);
+    if (mapping_ != nullptr)
+      data_ = ::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+  }
+  const DWORD error = ::GetLastError();
+  ::CloseHandle(file);
+
+  if (size_ != 0 && data_ == nullptr) {
+    if (mapping_ != nullptr)
+      ::CloseHandle(mapping_);
+    NTA_THROW << "MappedFile -- unable to map '" << path << "', error code "
+              << error;
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr)
+    ::UnmapViewOfFile(data_);
+  if (mapping_ != nullptr)
+    ::CloseHandle(mapping_);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) : data_(nullptr), size_(0) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    NTA_THROW << "MappedFile -- unable to open '" << path
+              << "': " << ::strerror(errno);
+
+  struct stat st;
+  if (::fstat(fd, &st) == -1) {
+    const int error = errno;
+    ::close(fd);
+    NTA_THROW << "MappedFile -- unable to get the size of '" << path
+              << "': " << ::strerror(error);
+  }
+  size_ = (size_t)st.st_size;
+
+  if (size_ != 0) {
+    void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      NTA_THROW << "MappedFile -- unable to map '" << path
+                << "': " << ::strerror(error);
+    }
+    data_ = data;
+  }
+
+  // The mapping keeps its own reference to the file
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr)
+    ::munmap(const_cast<void *>(data_), size_);
+}
+
+#endif
+
+} // namespace nupic
@@ -0,0 +1,72 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of MappedFile
+ */
+
+#ifndef NTA_MAPPED_FILE_HPP
+#define NTA_MAPPED_FILE_HPP
+
+#include <string>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+/**
+ * A whole file mapped read-only into memory.
+ *
+ * The operating system pages the file in as it is read, and can drop the
+ * pages again under memory pressure since they are backed by the file, so
+ * a large file can be read without a private copy of it on the heap. The
+ * mapping starts on a page boundary.
+ *
+ * An empty file maps to a null pointer and a size of 0.
+ */
+class MappedFile {
+public:
+  /**
+   * Map the file. Throws if it can't be opened or mapped.
+   */
+  explicit MappedFile(const std::string &path);
+
+  ~MappedFile();
+
+  const void *getData() const { return data_; }
+
+  size_t getSize() const { return size_; }
+
+private:
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const void *data_;
+  size_t size_;
+#if defined(NTA_OS_WINDOWS)
+  void *mapping_;
+#endif
+};
+
+} // namespace nupic
+
+#endif // NTA_MAPPED_FILE_HPP
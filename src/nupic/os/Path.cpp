@@ -41,15 +41,14 @@ extern "C" {
 }
 #include <windows.h>
 #else
+#include <fcntl.h>
 #include <fstream>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h> // fsync
 
 #if defined(NTA_OS_DARWIN)
 #include <mach-o/dyld.h> // _NSGetExecutablePath
-#else
-// linux
-#include <unistd.h> // readlink
 #endif
 #endif
 
@@ -612,7 +611,10 @@ void Path::rename(const std::string &oldPath, const std::string &newPath) {
 #if defined(NTA_OS_WINDOWS)
   std::wstring wOldPath(utf8ToUnicode(oldPath));
   std::wstring wNewPath(utf8ToUnicode(newPath));
-  BOOL res = ::MoveFileW(wOldPath.c_str(), wNewPath.c_str());
+  // Replace an existing file, like rename() does on Unix, and only return
+  // once the move is on the disk, since directories can't be synced.
+  BOOL res = ::MoveFileExW(wOldPath.c_str(), wNewPath.c_str(),
+                           MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
   if (res == FALSE)
     NTA_THROW << "Path::rename() -- unable to rename '" << oldPath << "' to '"
               << newPath << "' error message: " << OS::getErrorMessage();
@@ -624,6 +626,36 @@ void Path::rename(const std::string &oldPath, const std::string &newPath) {
 #endif
 }
 
+void Path::sync(const std::string &path) {
+  NTA_CHECK(!path.empty()) << "Can't sync an empty path";
+#if defined(NTA_OS_WINDOWS)
+  if (Path::isDirectory(path))
+    return;
+  std::wstring wPath(utf8ToUnicode(path));
+  HANDLE h = ::CreateFileW(wPath.c_str(), GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE)
+    NTA_THROW << "Path::sync() -- unable to open '" << path
+              << "' error message: " << OS::getErrorMessage();
+  BOOL res = ::FlushFileBuffers(h);
+  ::CloseHandle(h);
+  if (res == FALSE)
+    NTA_THROW << "Path::sync() -- unable to sync '" << path
+              << "' error message: " << OS::getErrorMessage();
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    NTA_THROW << "Path::sync() -- unable to open '" << path
+              << "' error message: " << OS::getErrorMessage();
+  int res = ::fsync(fd);
+  ::close(fd);
+  if (res == -1)
+    NTA_THROW << "Path::sync() -- unable to sync '" << path
+              << "' error message: " << OS::getErrorMessage();
+#endif
+}
+
 Path::operator const char *() const { return path_.c_str(); }
 
 Path &Path::operator+=(const Path &path) {
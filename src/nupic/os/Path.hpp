@@ -246,6 +246,11 @@ public:
   static void copy(const std::string &source, const std::string &destination);
   static void remove(const std::string &path);
   static void rename(const std::string &oldPath, const std::string &newPath);
+  /**
+   * Flush a file, or the entries of a directory, to the disk. Directories
+   * are left alone on Windows, where they can't be synced.
+   */
+  static void sync(const std::string &path);
   static bool isDirectory(const std::string &path);
   static bool isFile(const std::string &path);
   static bool isSymbolicLink(const std::string &path);
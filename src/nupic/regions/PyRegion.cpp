@@ -1101,6 +1101,8 @@ void PyRegion::createSpec(const char *nodeType, Spec &ns,
       sparse = py::Int(input.getItem("sparse")) != 0;
     }
 
+    // Python regions get writable numpy views of their inputs, so their
+    // inputs are never read-only and always keep their own buffer.
     ns.inputs.add(name,
                   InputSpec(description, dataType, count, required, regionLevel,
                             isDefaultInput, requireSplitterMap, sparse));
@@ -197,7 +197,10 @@ Spec *VectorFileEffector::createSpec() {
                            0,     // count
                            false, // required?
                            false, // isRegionLevel
-                           true   // isDefaultInput
+                           true,  // isDefaultInput
+                           true,  // requireSplitterMap
+                           false, // sparse
+                           true   // readOnly
                            ));
 
   ns->parameters.add("outputFile",
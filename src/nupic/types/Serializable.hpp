@@ -28,11 +28,15 @@
 #define NTA_serializable_HPP
 
 #include <iostream>
+#include <string>
 
 #include <capnp/message.h>
 #include <capnp/serialize.h>
 #include <kj/std/iostream.h>
 
+#include <nupic/os/MappedFile.hpp>
+#include <nupic/utils/Log.hpp>
+
 namespace nupic {
 
 /**
@@ -59,6 +63,29 @@ public:
     read(proto);
   }
 
+  /**
+   * Read a message written by write(std::ostream &) to a file.
+   *
+   * Unlike read(std::istream &), this doesn't copy the message onto the
+   * heap before read(proto) copies it into the object: the file is mapped
+   * into memory and the message is read in place, so loading a large
+   * model only needs memory for the model itself.
+   */
+  void readFromFile(const std::string &path) {
+    MappedFile file(path);
+    NTA_CHECK(file.getSize() != 0 && file.getSize() % sizeof(capnp::word) == 0)
+        << "readFromFile -- '" << path << "' is not a serialized message";
+
+    kj::ArrayPtr<const capnp::word> words(
+        (const capnp::word *)file.getData(),
+        file.getSize() / sizeof(capnp::word));
+    capnp::ReaderOptions options;
+    options.traversalLimitInWords = kj::maxValue; // Don't limit.
+    capnp::FlatArrayMessageReader message(words, options);
+    typename ProtoT::Reader proto = message.getRoot<ProtoT>();
+    read(proto);
+  }
+
   virtual void write(typename ProtoT::Builder &proto) const = 0;
   virtual void read(typename ProtoT::Reader &proto) = 0;
 
@@ -138,6 +138,11 @@ typedef enum NTA_BasicType {
  */
 typedef char NTA_Byte;
 
+/**
+ * Represents a 8-bit unsigned integer.
+ */
+typedef unsigned char NTA_UInt8;
+
 /**
  * Represents lengths of arrays, strings and so on.
  */
@@ -43,6 +43,11 @@ namespace nupic {
  */
 typedef NTA_Byte Byte;
 
+/**
+ * Represents a 8-bit unsigned integer.
+ */
+typedef NTA_UInt8 UInt8;
+
 /**
  * Represents a 16-bit signed integer.
  */
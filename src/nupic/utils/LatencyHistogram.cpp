@@ -0,0 +1,88 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of LatencyHistogram
+ */
+
+#include <cmath>
+#include <limits>
+
+#include <nupic/utils/LatencyHistogram.hpp>
+#include <nupic/utils/Log.hpp>
+
+namespace nupic {
+
+LatencyHistogram::LatencyHistogram() : counts_(BUCKET_COUNT, 0) { reset(); }
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (UInt b = 0; b < BUCKET_COUNT; b++) {
+    counts_[b] += other.counts_[b];
+  }
+  count_ += other.count_;
+  total_ += other.total_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  total_ = 0;
+  min_ = std::numeric_limits<UInt64>::max();
+  max_ = 0;
+}
+
+UInt64 LatencyHistogram::bucketMax_(UInt bucket) {
+  if (bucket < SUB_BUCKET_COUNT) {
+    return bucket;
+  }
+  const UInt shift = bucket / SUB_BUCKET_COUNT - 1;
+  const UInt64 sub = bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+  return ((sub + 1) << shift) - 1;
+}
+
+UInt64 LatencyHistogram::getPercentile(Real64 percentile) const {
+  NTA_CHECK(percentile >= 0 && percentile <= 100)
+      << "Invalid percentile " << percentile
+      << ", it must be between 0 and 100";
+
+  if (count_ == 0) {
+    return 0;
+  }
+  if (percentile == 0) {
+    return min_;
+  }
+
+  const UInt64 rank = std::max(
+      (UInt64)1, (UInt64)std::ceil(percentile / 100.0 * (Real64)count_));
+  UInt64 seen = 0;
+  for (UInt b = 0; b < BUCKET_COUNT; b++) {
+    seen += counts_[b];
+    if (seen >= rank) {
+      return std::max(min_, std::min(bucketMax_(b), max_));
+    }
+  }
+  return max_;
+}
+
+} // namespace nupic
@@ -0,0 +1,126 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of LatencyHistogram
+ */
+
+#ifndef NTA_LATENCY_HISTOGRAM_HPP
+#define NTA_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+/**
+ * A histogram of durations, or any other non-negative integers, with a
+ * bounded relative error.
+ *
+ * Values below 2^SUB_BUCKET_BITS each get a bucket. Above that, every power
+ * of two range is split into 2^SUB_BUCKET_BITS buckets of equal width, so a
+ * percentile is never off by more than 1 / 2^SUB_BUCKET_BITS of its value
+ * (about 3%). record() is a couple of shifts and an increment, and the
+ * memory use is fixed whatever the number or the range of the values.
+ */
+class LatencyHistogram {
+public:
+  static const UInt SUB_BUCKET_BITS = 5;
+  static const UInt SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+  static const UInt BUCKET_COUNT =
+      (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+  LatencyHistogram();
+
+  inline void record(UInt64 value) {
+    counts_[bucket_(value)]++;
+    count_++;
+    total_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  /**
+   * Adds all the values recorded by another histogram to this one.
+   */
+  void merge(const LatencyHistogram &other);
+
+  void reset();
+
+  UInt64 getCount() const { return count_; }
+  UInt64 getTotal() const { return total_; }
+
+  /**
+   * Smallest and largest values recorded. Both are 0 when the histogram is
+   * empty.
+   */
+  UInt64 getMin() const { return count_ ? min_ : 0; }
+  UInt64 getMax() const { return max_; }
+
+  Real64 getMean() const { return count_ ? (Real64)total_ / count_ : 0.0; }
+
+  /**
+   * The value that the given percentage of the recorded values are at most
+   * equal to, rounded up to the end of its bucket and clipped to the
+   * largest value recorded. The 0th percentile is the smallest value.
+   *
+   * @param percentile A percentage in [0, 100]
+   * @returns The percentile, or 0 when the histogram is empty
+   */
+  UInt64 getPercentile(Real64 percentile) const;
+
+private:
+  static inline UInt bucket_(UInt64 value) {
+    if (value < SUB_BUCKET_COUNT) {
+      return (UInt)value;
+    }
+    const UInt shift = msb_(value) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT +
+           (UInt)(value >> shift) - SUB_BUCKET_COUNT;
+  }
+
+  static inline UInt msb_(UInt64 value) {
+#if defined(NTA_COMPILER_GNU) || defined(NTA_COMPILER_CLANG)
+    return 63 - (UInt)__builtin_clzll(value);
+#else
+    UInt b = 0;
+    while (value >>= 1)
+      ++b;
+    return b;
+#endif
+  }
+
+  // Largest value that falls in a bucket
+  static UInt64 bucketMax_(UInt bucket);
+
+  std::vector<UInt64> counts_;
+  UInt64 count_;
+  UInt64 total_;
+  UInt64 min_;
+  UInt64 max_;
+};
+
+} // namespace nupic
+
+#endif // NTA_LATENCY_HISTOGRAM_HPP
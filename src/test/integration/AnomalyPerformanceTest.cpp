@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of performance tests for Anomaly
+ */
+
+#include <iostream>
+#include <set>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include <nupic/algorithms/Anomaly.hpp>
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::algorithms::anomaly;
+
+#define SEED 42
+
+namespace {
+
+vector<UInt> randomSDR(UInt n, UInt w) {
+  set<UInt> sdrSet;
+  while (sdrSet.size() < w) {
+    sdrSet.insert(rand() % n);
+  }
+  return vector<UInt>(sdrSet.begin(), sdrSet.end());
+}
+
+/**
+ * Scores numRecords records of a stream whose predictions are mostly
+ * right, and reports the cost per record.
+ */
+void runAnomalyTest(AnomalyMode mode, UInt numRecords, string label) {
+  vector<vector<UInt>> patterns;
+  for (UInt i = 0; i < 100; i++) {
+    patterns.push_back(randomSDR(2048, 40));
+  }
+
+  Anomaly anomaly(0, mode);
+  Real64 total = 0;
+  clock_t timer = clock();
+  for (UInt record = 0; record < numRecords; record++) {
+    const vector<UInt> &active = patterns[record % patterns.size()];
+    const vector<UInt> &predicted =
+        record % 97 == 0 ? patterns[(record + 1) % patterns.size()] : active;
+    total += anomaly.compute(active, predicted);
+  }
+  const float duration = (float)(clock() - timer) / CLOCKS_PER_SEC;
+  cout << duration << " in " << label << " (" << 1e9 * duration / numRecords
+       << " ns/record, mean score " << total / numRecords << ")" << endl;
+}
+
+/**
+ * Scores numStreams streams per tick with one call, and reports the cost
+ * per stream.
+ */
+void runBatchTest(UInt numStreams, UInt numTicks) {
+  vector<UInt> active, activeOffsets = {0};
+  vector<UInt> predicted, predictedOffsets = {0};
+  for (UInt i = 0; i < numStreams; i++) {
+    const vector<UInt> columns = randomSDR(2048, 40);
+    active.insert(active.end(), columns.begin(), columns.end());
+    activeOffsets.push_back(active.size());
+    const vector<UInt> prediction = i % 97 == 0 ? randomSDR(2048, 40) : columns;
+    predicted.insert(predicted.end(), prediction.begin(), prediction.end());
+    predictedOffsets.push_back(predicted.size());
+  }
+
+  vector<Real32> scores;
+  Real64 total = 0;
+  clock_t timer = clock();
+  for (UInt tick = 0; tick < numTicks; tick++) {
+    computeRawAnomalyScores(active, activeOffsets, predicted, predictedOffsets,
+                            scores);
+    total += scores[tick % numStreams];
+  }
+  const float duration = (float)(clock() - timer) / CLOCKS_PER_SEC;
+  cout << duration << " in batch of " << numStreams << " streams ("
+       << 1e9 * duration / ((Real64)numStreams * numTicks)
+       << " ns/stream, checksum " << total << ")" << endl;
+}
+
+} // end namespace
+
+int main(int argc, char *argv[]) {
+  srand(SEED);
+
+  runAnomalyTest(AnomalyMode::PURE, 1000000, "PURE");
+  runAnomalyTest(AnomalyMode::LIKELIHOOD, 1000000, "LIKELIHOOD");
+  runAnomalyTest(AnomalyMode::WEIGHTED, 1000000, "WEIGHTED");
+  runBatchTest(10000, 100);
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of performance tests for Network::initialize
+ */
+
+#include <iostream>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include <nupic/engine/Network.hpp>
+#include <nupic/engine/NuPIC.hpp>
+#include <nupic/engine/Region.hpp>
+#include <nupic/ntypes/Dimensions.hpp>
+#include <nupic/utils/StringUtils.hpp>
+
+using namespace std;
+using namespace nupic;
+
+namespace {
+
+void checkpoint(clock_t timer, UInt numRegions, string text) {
+  float duration = (float)(clock() - timer) / CLOCKS_PER_SEC;
+  cout << duration << " in " << text << " (" << numRegions / duration
+       << " regions/s)" << endl;
+}
+
+/**
+ * Builds a hierarchy of numRegions regions in which every region but the
+ * root receives the output of fanIn regions of the level below, then
+ * initializes it. Only the bottom level has dimensions, the others get
+ * theirs from the links. The regions are added top down, the way generated
+ * networks tend to be, so the dimensions have to travel against the order
+ * of the regions. A fanIn of 1 gives a single chain of regions.
+ */
+void runInitializeTest(UInt numRegions, UInt fanIn, string label) {
+  Network net;
+  Dimensions dims;
+  dims.push_back(4);
+  dims.push_back(4);
+
+  clock_t timer = clock();
+  vector<Region *> regions;
+  for (UInt i = 0; i < numRegions; i++) {
+    regions.push_back(
+        net.addRegion("R" + StringUtils::fromInt(i), "TestNode", ""));
+  }
+  for (UInt i = 1; i < numRegions; i++) {
+    const UInt parent = (i - 1) / fanIn;
+    net.link(regions[i]->getName(), regions[parent]->getName(), "UniformLink",
+             "{mapping: in, rfSize: [1]}");
+  }
+  for (UInt i = 0; i < numRegions; i++) {
+    if (i * fanIn + 1 >= numRegions)
+      regions[i]->setDimensions(dims);
+  }
+  checkpoint(timer, numRegions, label + ": build");
+
+  timer = clock();
+  net.initialize();
+  checkpoint(timer, numRegions, label + ": initialize");
+}
+
+} // end namespace
+
+int main(int argc, char *argv[]) {
+  NuPIC::init();
+
+  runInitializeTest(1000, 4, "1k regions, fan-in 4");
+  runInitializeTest(10000, 4, "10k regions, fan-in 4");
+  runInitializeTest(1000, 1, "1k regions, chain");
+  runInitializeTest(10000, 1, "10k regions, chain");
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of performance tests for SDRClassifier
+ */
+
+#include <iostream>
+#include <set>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include <nupic/algorithms/ClassifierResult.hpp>
+#include <nupic/algorithms/SDRClassifier.hpp>
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::algorithms::cla_classifier;
+using namespace nupic::algorithms::sdr_classifier;
+
+#define SEED 42
+
+namespace {
+
+void checkpoint(clock_t timer, UInt numRecords, string text) {
+  float duration = (float)(clock() - timer) / CLOCKS_PER_SEC;
+  cout << duration << " in " << text << " (" << numRecords / duration
+       << " records/s)" << endl;
+}
+
+vector<UInt> randomSDR(UInt n, UInt w) {
+  set<UInt> sdrSet;
+  while (sdrSet.size() < w) {
+    sdrSet.insert(rand() % n);
+  }
+  return vector<UInt>(sdrSet.begin(), sdrSet.end());
+}
+
+/**
+ * Feeds the classifier a stream whose bucket count grows by one every
+ * recordsPerBucket records, the way a scalar encoder's buckets show up
+ * over time on a drifting signal.
+ */
+void runGrowingBucketsTest(UInt numInputs, UInt w, vector<UInt> steps,
+                           UInt numRecords, UInt recordsPerBucket,
+                           string label) {
+  SDRClassifier classifier(steps, 0.1, 0.1, 0);
+  vector<vector<UInt>> patterns;
+  for (UInt i = 0; i < 100; i++) {
+    patterns.push_back(randomSDR(numInputs, w));
+  }
+
+  clock_t timer = clock();
+  for (UInt record = 0; record < numRecords; record++) {
+    const UInt bucket = record / recordsPerBucket + rand() % 3;
+    ClassifierResult result;
+    classifier.compute(record, patterns[record % patterns.size()], {bucket},
+                       {(Real64)bucket}, false, true, true, &result);
+  }
+  checkpoint(timer, numRecords, label + ": learn + infer");
+}
+
+/**
+ * Compares the full likelihoods to the top-K predictions, with Real64 and
+ * Real32 weights, on a classifier that has already seen numBuckets buckets.
+ */
+void runManyBucketsTest(UInt numBuckets, UInt numRecords,
+                        SDRClassifier::WeightPrecision precision,
+                        string label) {
+  SDRClassifier classifier({1}, 0.1, 0.1, 0, precision);
+  vector<UInt> pattern = randomSDR(2048, 40);
+  classifier.compute(0, pattern, {numBuckets - 1},
+                     {(Real64)(numBuckets - 1)}, false, true, false, nullptr);
+
+  clock_t timer = clock();
+  for (UInt record = 1; record <= numRecords; record++) {
+    ClassifierResult result;
+    classifier.compute(record, randomSDR(2048, 40), {}, {0.0}, false, false,
+                       true, &result);
+  }
+  checkpoint(timer, numRecords, label + ": full likelihoods");
+
+  vector<vector<SDRClassifier::BucketPrediction>> predictions;
+  timer = clock();
+  for (UInt record = numRecords + 1; record <= 2 * numRecords; record++) {
+    classifier.compute(record, randomSDR(2048, 40), {}, {0.0}, false, false,
+                       5, predictions);
+  }
+  checkpoint(timer, numRecords, label + ": top 5");
+}
+
+} // end namespace
+
+int main(int argc, char *argv[]) {
+  srand(SEED);
+
+  runGrowingBucketsTest(2048, 40, {1}, 5000, 10, "1 step, growing buckets");
+  runGrowingBucketsTest(2048, 40, {1, 5}, 5000, 10,
+                        "2 steps, growing buckets");
+  runGrowingBucketsTest(2048, 40, {1, 2, 3, 4, 5}, 5000, 10,
+                        "5 steps, growing buckets");
+  runGrowingBucketsTest(16384, 328, {1}, 2000, 2,
+                        "1 step, large input, fast growing buckets");
+  runManyBucketsTest(5000, 5000, SDRClassifier::WeightPrecision::REAL64,
+                     "5000 buckets, Real64");
+  runManyBucketsTest(5000, 5000, SDRClassifier::WeightPrecision::REAL32,
+                     "5000 buckets, Real32");
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for AnomalyLikelihood
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "nupic/algorithms/AnomalyLikelihood.hpp"
+#include "nupic/types/Types.hpp"
+#include "nupic/utils/Random.hpp"
+
+using namespace nupic::algorithms::anomaly;
+using namespace nupic;
+
+namespace {
+
+TEST(AnomalyLikelihood, TailProbability) {
+  ASSERT_DOUBLE_EQ(0.5, AnomalyLikelihood::tailProbability(0.5, 0.5, 0.1));
+  ASSERT_NEAR(0.158655, AnomalyLikelihood::tailProbability(0.6, 0.5, 0.1),
+              1e-6);
+  // The tails are symmetric.
+  ASSERT_DOUBLE_EQ(AnomalyLikelihood::tailProbability(0.6, 0.5, 0.1),
+                   AnomalyLikelihood::tailProbability(0.4, 0.5, 0.1));
+}
+
+TEST(AnomalyLikelihood, Probation) {
+  AnomalyLikelihood likelihood(10, 20);
+  for (UInt i = 0; i < 30; i++) {
+    ASSERT_EQ(0.5, likelihood.anomalyProbability(0.1));
+  }
+  ASSERT_NE(0.5, likelihood.anomalyProbability(1.0));
+  ASSERT_EQ(31, likelihood.getIteration());
+}
+
+TEST(AnomalyLikelihood, MatchesBatchEstimate) {
+  // The incremental estimate matches the mean and variance of the historic
+  // window computed from scratch, with the window sliding, and the
+  // likelihoods are filtered like in the Python version. The tolerance
+  // covers the single precision running total of MovingAverage.
+  const UInt learningPeriod = 10, estimationSamples = 20, windowSize = 50,
+             reestimationPeriod = 5, averagingWindow = 3;
+  AnomalyLikelihood likelihood(learningPeriod, estimationSamples, windowSize,
+                               reestimationPeriod, averagingWindow);
+
+  Random rng(42);
+  std::vector<Real32> scores;
+  std::vector<Real64> averages;
+  Real64 mean = 0, stdev = 0, previousTail = 1;
+  UInt filtered = 0;
+  for (UInt i = 0; i < 500; i++) {
+    const Real32 score = (Real32)(rng.getReal64() * (i % 100 < 50 ? 0.2 : 1));
+    scores.push_back(score);
+    Real32 total = 0;
+    const UInt n = std::min((UInt)scores.size(), averagingWindow);
+    for (UInt j = scores.size() - n; j < scores.size(); j++) {
+      total += scores[j];
+    }
+    const Real64 average = total / n;
+    if (i >= learningPeriod) {
+      averages.push_back(average);
+    }
+
+    const Real64 probability = likelihood.anomalyProbability(score);
+    if (i < learningPeriod + estimationSamples) {
+      ASSERT_EQ(0.5, probability);
+      continue;
+    }
+
+    if (i == learningPeriod + estimationSamples ||
+        i % reestimationPeriod == 0) {
+      const UInt count = std::min((UInt)averages.size(), windowSize);
+      Real64 sum = 0, sumSquares = 0;
+      for (UInt j = averages.size() - count; j < averages.size(); j++) {
+        sum += averages[j];
+      }
+      mean = sum / count;
+      for (UInt j = averages.size() - count; j < averages.size(); j++) {
+        sumSquares += (averages[j] - mean) * (averages[j] - mean);
+      }
+      mean = std::max(mean, 0.03);
+      stdev = std::sqrt(std::max(sumSquares / count, 0.0003));
+      ASSERT_NEAR(mean, likelihood.getMean(), 1e-6);
+      ASSERT_NEAR(stdev * stdev, likelihood.getVariance(), 1e-6);
+      previousTail = AnomalyLikelihood::tailProbability(
+          averages[averages.size() - 2], mean, stdev);
+    }
+    const Real64 tail =
+        AnomalyLikelihood::tailProbability(average, mean, stdev);
+    if (tail <= 1e-5 && previousTail <= 1e-5) {
+      ASSERT_NEAR(0.999, probability, 1e-9);
+      filtered++;
+    } else {
+      ASSERT_NEAR(1.0 - tail, probability, 1e-4);
+    }
+    previousTail = tail;
+  }
+  // The jumps between the two ranges of scores are filtered
+  ASSERT_GT(filtered, 0u);
+}
+
+TEST(AnomalyLikelihood, FlatMetric) {
+  AnomalyLikelihood flat(10, 20), varying(10, 20);
+  Real64 flatProbability = 0, varyingProbability = 0;
+  for (UInt i = 0; i < 100; i++) {
+    const Real64 score = i < 99 ? 0.0 : 1.0;
+    flatProbability = flat.anomalyProbability(42.0, score);
+    varyingProbability = varying.anomalyProbability((Real64)i, score);
+  }
+  // The null distribution of a flat metric makes nothing unlikely.
+  ASSERT_NEAR(0.5, flatProbability, 1e-3);
+  ASSERT_GT(varyingProbability, 0.999);
+}
+
+} // end namespace
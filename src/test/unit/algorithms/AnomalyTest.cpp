@@ -61,6 +61,43 @@ TEST(ComputeRawAnomalyScore, PartialMatch) {
   ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, predicted), 2.0 / 3.0);
 };
 
+TEST(ComputeRawAnomalyScore, Unsorted) {
+  std::vector<UInt> active = {6, 2, 3};
+  std::vector<UInt> predicted = {7, 3, 5, 3};
+  ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, predicted), 2.0 / 3.0);
+};
+
+TEST(ComputeRawAnomalyScores, Batch) {
+  std::vector<std::vector<UInt>> actives = {
+      {}, {3, 5, 7}, {2, 4, 6}, {2, 3, 6}, {6, 2, 3}};
+  std::vector<std::vector<UInt>> predicteds = {
+      {3, 5}, {3, 5, 7}, {3, 5, 7}, {3, 5, 7}, {}};
+
+  std::vector<UInt> active, activeOffsets = {0};
+  std::vector<UInt> predicted, predictedOffsets = {0};
+  for (size_t i = 0; i < actives.size(); i++) {
+    active.insert(active.end(), actives[i].begin(), actives[i].end());
+    activeOffsets.push_back(active.size());
+    predicted.insert(predicted.end(), predicteds[i].begin(),
+                     predicteds[i].end());
+    predictedOffsets.push_back(predicted.size());
+  }
+
+  std::vector<Real32> scores;
+  computeRawAnomalyScores(active, activeOffsets, predicted, predictedOffsets,
+                          scores);
+  ASSERT_EQ(actives.size(), scores.size());
+  for (size_t i = 0; i < actives.size(); i++) {
+    ASSERT_FLOAT_EQ(computeRawAnomalyScore(actives[i], predicteds[i]),
+                    scores[i]);
+  }
+
+  std::swap(activeOffsets[1], activeOffsets[2]);
+  EXPECT_THROW(computeRawAnomalyScores(active, activeOffsets, predicted,
+                                       predictedOffsets, scores),
+               std::exception);
+};
+
 TEST(Anomaly, ComputeScoreNoActiveOrPredicted) {
   std::vector<UInt> active;
   std::vector<UInt> predicted;
@@ -120,3 +157,51 @@ TEST(Anomaly, SelectModePure) {
   std::vector<UInt> predicted = {3, 5, 7};
   ASSERT_FLOAT_EQ(a.compute(active, predicted), 2.0 / 3.0);
 };
+
+TEST(Anomaly, SelectModeLikelihood) {
+  Anomaly a{0, AnomalyMode::LIKELIHOOD, 0};
+  std::vector<UInt> predicted = {3, 5, 7};
+  std::vector<UInt> expected = {3, 5, 7};
+  std::vector<UInt> unexpected = {2, 4, 6};
+
+  // No likelihood until the end of the probationary period.
+  ASSERT_FLOAT_EQ(a.compute(expected, predicted), 0.5);
+  for (int i = 0; i < 500; i++) {
+    a.compute(i % 50 == 0 ? unexpected : expected, predicted);
+  }
+
+  // A burst of surprises is much less likely than the predictable stream.
+  const Real32 expectedScore = a.compute(expected, predicted);
+  Real32 score = 0;
+  for (int i = 0; i < 5; i++) {
+    score = a.compute(unexpected, predicted);
+  }
+  ASSERT_GT(expectedScore, 0.1);
+  ASSERT_LT(score, 0.001);
+}
+
+TEST(Anomaly, SelectModeLikelihoodFlatMetric) {
+  Anomaly a{0, AnomalyMode::LIKELIHOOD, 0};
+  std::vector<UInt> predicted = {3, 5, 7};
+  std::vector<UInt> expected = {3, 5, 7};
+  std::vector<UInt> unexpected = {2, 4, 6};
+  const Real64 value = 42.0;
+
+  for (int i = 0; i < 500; i++) {
+    a.compute(i % 50 == 0 ? unexpected : expected, predicted, value);
+  }
+
+  // The metric never changes, so the same burst is not reported.
+  Real32 score = 0;
+  for (int i = 0; i < 5; i++) {
+    score = a.compute(unexpected, predicted, value);
+  }
+  ASSERT_GT(score, 0.1);
+}
+
+TEST(Anomaly, SelectModeWeighted) {
+  Anomaly a{0, AnomalyMode::WEIGHTED, 0};
+  std::vector<UInt> active = {2, 3, 6};
+  std::vector<UInt> predicted = {3, 5, 7};
+  ASSERT_FLOAT_EQ(a.compute(active, predicted), 2.0 / 3.0 * 0.5);
+};
@@ -0,0 +1,163 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for BitHistory
+ */
+
+#include <sstream>
+#include <vector>
+
+#include <capnp/message.h>
+#include <gtest/gtest.h>
+
+#include <nupic/algorithms/BitHistory.hpp>
+#include <nupic/proto/BitHistory.capnp.h>
+#include <nupic/utils/Random.hpp>
+
+using namespace nupic;
+using namespace nupic::algorithms::cla_classifier;
+
+namespace {
+
+const UInt NUM_BITS = 20;
+const UInt NUM_BUCKETS = 12;
+const int NUM_STEPS = 1;
+
+/**
+ * Feeds the same stream to a BitHistoryTable and to one BitHistory per bit.
+ * Bits are stored to at irregular intervals, with gaps long enough for the
+ * duty cycles to be renormalized.
+ */
+void feed(BitHistoryTable &table, vector<BitHistory> &histories,
+          Real64 alpha) {
+  Random rng(42);
+  for (UInt bit = 0; bit < NUM_BITS; bit++) {
+    histories.emplace_back(bit, NUM_STEPS, alpha, 0);
+  }
+
+  int iteration = 0;
+  for (UInt record = 0; record < 500; record++) {
+    iteration += 1 + rng.getUInt32(5) * rng.getUInt32(15);
+    const int bucketIdx = rng.getUInt32(NUM_BUCKETS);
+
+    vector<UInt> bits;
+    for (UInt bit = 0; bit < NUM_BITS; bit++) {
+      if (rng.getUInt32(4) == 0) {
+        bits.push_back(bit);
+        histories[bit].store(iteration, bucketIdx);
+      }
+    }
+    table.store(iteration, bits, bucketIdx);
+  }
+}
+
+void checkInference(const BitHistoryTable &table,
+                    vector<BitHistory> &histories, const vector<UInt> &bits) {
+  vector<Real64> expected(NUM_BUCKETS, 0.0);
+  for (UInt bit : bits) {
+    vector<Real64> votes(NUM_BUCKETS, 0.0);
+    histories[bit].infer(0, &votes);
+    for (UInt i = 0; i < NUM_BUCKETS; i++) {
+      expected[i] += votes[i];
+    }
+  }
+
+  vector<Real64> votes;
+  table.infer(bits, votes);
+  ASSERT_EQ(NUM_BUCKETS, votes.size());
+  for (UInt i = 0; i < NUM_BUCKETS; i++) {
+    ASSERT_NEAR(expected[i], votes[i], 1e-9) << "bucket " << i;
+  }
+}
+
+TEST(BitHistoryTest, TableMatchesBitHistory) {
+  for (Real64 alpha : {0.001, 0.1, 0.5}) {
+    BitHistoryTable table(NUM_STEPS, alpha);
+    vector<BitHistory> histories;
+    feed(table, histories, alpha);
+
+    ASSERT_EQ(NUM_BITS, table.numBits());
+    ASSERT_EQ(NUM_BUCKETS, table.numBuckets());
+
+    ASSERT_NO_FATAL_FAILURE(checkInference(table, histories, {3}));
+    ASSERT_NO_FATAL_FAILURE(checkInference(table, histories, {0, 5, 7, 19}));
+
+    vector<UInt> allBits;
+    for (UInt bit = 0; bit < NUM_BITS; bit++) {
+      allBits.push_back(bit);
+    }
+    ASSERT_NO_FATAL_FAILURE(checkInference(table, histories, allBits));
+  }
+}
+
+TEST(BitHistoryTest, TableWithoutHistory) {
+  BitHistoryTable table(NUM_STEPS, 0.1);
+  table.store(5, 2, 3);
+
+  // Bits that never stored anything don't vote.
+  vector<Real64> votes;
+  table.infer({0, 1, 2, 10}, votes);
+  ASSERT_EQ(vector<Real64>({0.0, 0.0, 0.0, 1.0}), votes);
+}
+
+TEST(BitHistoryTest, TableSerialization) {
+  const Real64 alpha = 0.1;
+  BitHistoryTable table(NUM_STEPS, alpha);
+  vector<BitHistory> histories;
+  feed(table, histories, alpha);
+
+  BitHistoryTable restored(NUM_STEPS, alpha);
+  for (UInt bit = 0; bit < NUM_BITS; bit++) {
+    // A row of the table reads back as a BitHistory
+    capnp::MallocMessageBuilder message1;
+    BitHistoryProto::Builder builder1 = message1.initRoot<BitHistoryProto>();
+    table.write(bit, builder1);
+    BitHistoryProto::Reader reader1 = builder1.asReader();
+    BitHistory history;
+    history.read(reader1);
+    ASSERT_TRUE(history == histories[bit]) << "bit " << bit;
+
+    // and a BitHistory reads back as a row.
+    capnp::MallocMessageBuilder message2;
+    BitHistoryProto::Builder builder2 = message2.initRoot<BitHistoryProto>();
+    histories[bit].write(builder2);
+    BitHistoryProto::Reader reader2 = builder2.asReader();
+    restored.read(bit, reader2);
+  }
+
+  vector<UInt> allBits;
+  for (UInt bit = 0; bit < NUM_BITS; bit++) {
+    allBits.push_back(bit);
+  }
+  ASSERT_NO_FATAL_FAILURE(checkInference(restored, histories, allBits));
+
+  // Both keep learning the same way.
+  table.store(100000, allBits, 4);
+  restored.store(100000, allBits, 4);
+  vector<Real64> votes1, votes2;
+  table.infer(allBits, votes1);
+  restored.infer(allBits, votes2);
+  ASSERT_EQ(votes1, votes2);
+}
+
+} // end namespace
@@ -24,7 +24,9 @@
  * Notes
  */
 
+#include <cmath>
 #include <fstream>
+#include <limits>
 #include <nupic/algorithms/CondProbTable.hpp>
 #include <nupic/math/StlIo.hpp>
 // clang-format off
@@ -304,5 +306,128 @@ TEST(CondProbTableTest, Basic) {
   }
 }
 
+// Checks every inference type but Viterbi against a direct computation on
+// the expected table contents.
+void testInference(CondProbTable &table, const vector<vector<Real>> &rows,
+                   const vector<Real> &distribution) {
+  vector<Real> rowSums(rows.size(), 0), colSums(distribution.size(), 0);
+  for (Size r = 0; r < rows.size(); r++) {
+    for (Size c = 0; c < distribution.size(); c++) {
+      rowSums[r] += rows[r][c];
+      colSums[c] += rows[r][c];
+    }
+  }
+
+  vector<Real> marginal(rows.size()), evidence(rows.size()),
+      maxProd(rows.size());
+  table.inferRow(distribution, marginal, CondProbTable::inferMarginal);
+  table.inferRow(distribution, evidence, CondProbTable::inferRowEvidence);
+  table.inferRow(distribution, maxProd, CondProbTable::inferMaxProd);
+
+  // The rounding that inferRow allows between sums in different orders
+  const Real tolerance =
+      2 * (distribution.size() + 1) * numeric_limits<Real>::epsilon();
+
+  for (Size r = 0; r < rows.size(); r++) {
+    Real expMarginal = 0, expEvidence = 0, expMaxProd = 0;
+    Real absMarginal = 0, absEvidence = 0;
+    for (Size c = 0; c < distribution.size(); c++) {
+      if (rows[r][c] != 0) {
+        expMarginal += rows[r][c] * distribution[c] / colSums[c];
+        expEvidence += rows[r][c] * distribution[c];
+        expMaxProd = max(expMaxProd, rows[r][c] * distribution[c]);
+        absMarginal += fabs(rows[r][c] * distribution[c] / colSums[c]);
+        absEvidence += fabs(rows[r][c] * distribution[c]);
+      }
+    }
+    expEvidence /= rowSums[r];
+
+    ASSERT_NEAR(expMarginal, marginal[r], 1e-4);
+    ASSERT_NEAR(expEvidence, evidence[r], 1e-4);
+    ASSERT_NEAR(expMarginal, marginal[r], tolerance * absMarginal);
+    ASSERT_NEAR(expEvidence, evidence[r],
+                tolerance * absEvidence / rowSums[r]);
+    ASSERT_FLOAT_EQ(expMaxProd, maxProd[r]);
+  }
+}
+
+//----------------------------------------------------------------------
+TEST(CondProbTableTest, DenseBackend) {
+  const UInt nrows = 20, ncols = 50;
+  vector<vector<Real>> rows(nrows, vector<Real>(ncols, 0));
+  CondProbTable table(ncols);
+
+  // Two non-zeros per row keeps the table sparse.
+  for (UInt r = 0; r < nrows; r++) {
+    vector<Real> distribution(ncols, 0);
+    distribution[r] = (Real)0.5;
+    distribution[(7 * r + 3) % ncols] += (Real)0.25;
+    table.updateRow(r, distribution);
+    for (UInt c = 0; c < ncols; c++)
+      rows[r][c] += distribution[c];
+  }
+  ASSERT_FALSE(table.isDense());
+
+  vector<Real> distribution(ncols);
+  for (UInt c = 0; c < ncols; c++)
+    distribution[c] = (Real)((c * 13) % 7) / 7;
+  ASSERT_NO_FATAL_FAILURE(testInference(table, rows, distribution));
+
+  stringstream sparseState;
+  table.saveState(sparseState);
+
+  // Fill every other row in one batch, which crosses the threshold.
+  vector<UInt> batchRows;
+  vector<Real> batch;
+  for (UInt r = 0; r < nrows; r += 2) {
+    batchRows.push_back(r);
+    for (UInt c = 0; c < ncols; c++) {
+      const Real value = (Real)((r + c) % 5) / 10;
+      batch.push_back(value);
+      rows[r][c] += value;
+    }
+  }
+  table.updateRows(batchRows, batch);
+  ASSERT_TRUE(table.isDense());
+  ASSERT_NO_FATAL_FAILURE(testInference(table, rows, distribution));
+
+  // Updates and growth after the switch
+  vector<Real> wider(ncols + 3, (Real)0.125);
+  table.updateRow(nrows, wider);
+  rows.push_back(wider);
+  for (auto &row : rows)
+    row.resize(ncols + 3, 0);
+  distribution.resize(ncols + 3, (Real)0.5);
+  ASSERT_EQ(nrows + 1, table.numRows());
+  ASSERT_EQ(ncols + 3, table.numColumns());
+  ASSERT_NO_FATAL_FAILURE(testInference(table, rows, distribution));
+
+  // The sparse table is rebuilt from the dense one.
+  const SparseMatrix<UInt, Real> *sparse = table.getTable();
+  ASSERT_EQ(nrows + 1, sparse->nRows());
+  ASSERT_EQ(ncols + 3, sparse->nCols());
+  for (UInt r = 0; r <= nrows; r++) {
+    vector<Real> row;
+    table.getRow(r, row);
+    ASSERT_EQ(rows[r], row);
+    for (UInt c = 0; c < ncols + 3; c++)
+      ASSERT_EQ(rows[r][c], sparse->get(r, c));
+  }
+
+  // A dense table saves the same format and reloads dense.
+  stringstream denseState;
+  table.saveState(denseState);
+  CondProbTable restored;
+  restored.readState(denseState);
+  ASSERT_TRUE(restored.isDense());
+  ASSERT_NO_FATAL_FAILURE(testInference(restored, rows, distribution));
+
+  // And a state saved while sparse still reloads sparse.
+  CondProbTable restoredSparse;
+  restoredSparse.readState(sparseState);
+  ASSERT_FALSE(restoredSparse.isDense());
+  ASSERT_EQ(nrows, restoredSparse.numRows());
+}
+
 //----------------------------------------------------------------------
 } // end namespace
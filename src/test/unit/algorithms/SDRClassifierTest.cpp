@@ -38,6 +38,7 @@
 #include <nupic/algorithms/ClassifierResult.hpp>
 #include <nupic/algorithms/SDRClassifier.hpp>
 #include <nupic/utils/Log.hpp>
+#include <nupic/utils/Random.hpp>
 
 namespace nupic {
 namespace algorithms {
@@ -50,6 +51,24 @@ protected:
   void softmax_(SDRClassifier *self, Iterator begin, Iterator end) {
     self->softmax_(begin, end);
   };
+
+  // Checks the activations that are kept for the history against the ones
+  // computed from the weights.
+  void checkHistoryActivations_(const SDRClassifier &c,
+                                Real64 tolerance = 1e-9) {
+    ASSERT_EQ(c.maxSteps_, c.history_.size());
+    for (UInt i = 0; i < c.historySize_; i++) {
+      const SDRClassifier::HistoryEntry &entry = c.historyEntry_(i);
+      Matrix expected;
+      c.computeActivations_(entry.patternNZ, expected);
+      for (UInt stepIdx = 0; stepIdx < c.steps_.size(); stepIdx++) {
+        for (UInt j = 0; j <= c.maxBucketIdx_; j++) {
+          ASSERT_NEAR(expected.at(stepIdx, j),
+                      entry.activations.at(stepIdx, j), tolerance);
+        }
+      }
+    }
+  }
 };
 } // namespace sdr_classifier
 } // namespace algorithms
@@ -438,4 +457,282 @@ TEST_F(SDRClassifierTest, testSoftmaxOverflow) {
   ASSERT_FALSE(std::isnan(result));
 }
 
+TEST_F(SDRClassifierTest, GrowingBuckets) {
+  SDRClassifier c = SDRClassifier({0}, 0.5, 0.1, 0);
+
+  // Learn two patterns for buckets 0 and 1, then keep adding buckets and
+  // input bits one by one with other patterns.
+  const vector<UInt> pattern = {1, 5, 9};
+  UInt recordNum = 0;
+  for (UInt i = 0; i < 20; i++) {
+    ClassifierResult result;
+    if (i % 2 == 0) {
+      c.compute(recordNum++, pattern, {0}, {0.0}, false, true, false, &result);
+    } else {
+      c.compute(recordNum++, {2, 6}, {1}, {1.0}, false, true, false, &result);
+    }
+  }
+  for (UInt bucket = 1; bucket < 40; bucket++) {
+    ClassifierResult result;
+    c.compute(recordNum++, {20 + bucket, 60 + bucket}, {bucket},
+              {(Real64)bucket}, false, true, false, &result);
+  }
+
+  ClassifierResult result;
+  c.compute(recordNum++, pattern, {0}, {0.0}, false, false, true, &result);
+  for (auto it = result.begin(); it != result.end(); ++it) {
+    ASSERT_EQ(40, it->second->size());
+    if (it->first == 0) {
+      Real64 sum = 0;
+      for (Real64 likelihood : *it->second) {
+        sum += likelihood;
+      }
+      ASSERT_NEAR(1.0, sum, 0.000001);
+      // The weights learned before the matrices grew are still there.
+      ASSERT_EQ(0, max_element(it->second->begin(), it->second->end()) -
+                       it->second->begin());
+    }
+  }
+
+  SDRClassifier c2;
+  stringstream ss;
+  c.write(ss);
+  c2.read(ss);
+  ASSERT_TRUE(c == c2);
+}
+
+TEST_F(SDRClassifierTest, MultiStepMatchesSingleSteps) {
+  // A classifier predicting several steps gives the same likelihoods as
+  // one classifier per step.
+  const vector<UInt> steps = {0, 1, 3};
+  SDRClassifier multi = SDRClassifier(steps, 0.1, 0.1, 0);
+  vector<SDRClassifier> singles;
+  for (UInt step : steps) {
+    singles.push_back(SDRClassifier({step}, 0.1, 0.1, 0));
+  }
+
+  Random rng(42);
+  for (UInt recordNum = 0; recordNum < 200; recordNum++) {
+    vector<UInt> pattern;
+    for (UInt bit = 0; bit < 100; bit++) {
+      if (rng.getReal64() < 0.1) {
+        pattern.push_back(bit);
+      }
+    }
+    // Buckets keep appearing, and their count isn't a multiple of 4.
+    const UInt bucket = rng.getUInt32(recordNum / 10 + 3);
+
+    ClassifierResult multiResult;
+    multi.compute(recordNum, pattern, {bucket}, {(Real64)bucket}, false, true,
+                  true, &multiResult);
+    for (UInt i = 0; i < steps.size(); i++) {
+      ClassifierResult singleResult;
+      singles[i].compute(recordNum, pattern, {bucket}, {(Real64)bucket},
+                         false, true, true, &singleResult);
+      vector<Real64> *multiLikelihoods = nullptr, *singleLikelihoods = nullptr;
+      for (auto it = multiResult.begin(); it != multiResult.end(); ++it) {
+        if (it->first == (Int)steps[i]) {
+          multiLikelihoods = it->second;
+        }
+      }
+      for (auto it = singleResult.begin(); it != singleResult.end(); ++it) {
+        if (it->first == (Int)steps[i]) {
+          singleLikelihoods = it->second;
+        }
+      }
+      ASSERT_NE(nullptr, multiLikelihoods);
+      ASSERT_NE(nullptr, singleLikelihoods);
+      ASSERT_EQ(*singleLikelihoods, *multiLikelihoods);
+    }
+  }
+}
+
+TEST_F(SDRClassifierTest, HistoryActivations) {
+  // The activations kept for learning follow the weights, including when
+  // the history wraps around, the buckets grow and a record is repeated.
+  SDRClassifier c = SDRClassifier({0, 2, 3}, 0.1, 0.1, 0);
+
+  Random rng(42);
+  for (UInt recordNum = 0; recordNum < 50; recordNum++) {
+    for (UInt repeat = 0; repeat < (recordNum % 7 == 0 ? 2 : 1); repeat++) {
+      vector<UInt> pattern;
+      for (UInt bit = 0; bit < 30; bit++) {
+        if (rng.getReal64() < 0.3) {
+          pattern.push_back(bit);
+        }
+      }
+      const UInt bucket = rng.getUInt32(recordNum / 5 + 2);
+      ClassifierResult result;
+      // Repeated records skip inference
+      c.compute(recordNum, pattern, {bucket}, {(Real64)bucket}, false,
+                recordNum % 5 != 4, repeat == 0, &result);
+      checkHistoryActivations_(c);
+    }
+  }
+
+  SDRClassifier c2;
+  stringstream ss;
+  c.write(ss);
+  c2.read(ss);
+  ASSERT_TRUE(c == c2);
+  checkHistoryActivations_(c2);
+
+  // A classifier made for deserialization has no history to compute with
+  SDRClassifier empty;
+  ClassifierResult result;
+  EXPECT_THROW(empty.compute(0, {1}, {0}, {0.0}, false, true, true, &result),
+               std::exception);
+}
+
+vector<Real64> *stepLikelihoods(ClassifierResult &result, Int step) {
+  for (auto it = result.begin(); it != result.end(); ++it) {
+    if (it->first == step) {
+      return it->second;
+    }
+  }
+  return nullptr;
+}
+
+TEST_F(SDRClassifierTest, TopK) {
+  // The top-K predictions are the most likely buckets of compute's result,
+  // with the same likelihoods and actual values.
+  const vector<UInt> steps = {0, 2};
+  SDRClassifier c1 = SDRClassifier(steps, 0.1, 0.1, 0);
+  SDRClassifier c2 = SDRClassifier(steps, 0.1, 0.1, 0);
+  vector<vector<SDRClassifier::BucketPrediction>> predictions;
+
+  Random rng(42);
+  for (UInt recordNum = 0; recordNum < 100; recordNum++) {
+    vector<UInt> pattern;
+    for (UInt bit = 0; bit < 100; bit++) {
+      if (rng.getReal64() < 0.1) {
+        pattern.push_back(bit);
+      }
+    }
+    const UInt bucket = rng.getUInt32(recordNum / 4 + 2);
+
+    ClassifierResult result;
+    c1.compute(recordNum, pattern, {bucket}, {(Real64)bucket}, false, true,
+               true, &result);
+    c2.compute(recordNum, pattern, {bucket}, {(Real64)bucket}, false, true, 3,
+               predictions);
+
+    ASSERT_EQ(steps.size(), predictions.size());
+    vector<Real64> *actualValues = stepLikelihoods(result, -1);
+    for (UInt i = 0; i < steps.size(); i++) {
+      vector<Real64> *likelihoods = stepLikelihoods(result, steps[i]);
+      vector<UInt> buckets(likelihoods->size());
+      for (UInt j = 0; j < buckets.size(); j++) {
+        buckets[j] = j;
+      }
+      stable_sort(buckets.begin(), buckets.end(), [&](UInt a, UInt b) {
+        return (*likelihoods)[a] > (*likelihoods)[b];
+      });
+
+      ASSERT_EQ(min((size_t)3, buckets.size()), predictions[i].size());
+      for (UInt k = 0; k < predictions[i].size(); k++) {
+        const auto &prediction = predictions[i][k];
+        ASSERT_EQ(buckets[k], prediction.bucketIdx);
+        ASSERT_EQ((*likelihoods)[buckets[k]], prediction.likelihood);
+        ASSERT_EQ((*actualValues)[buckets[k]], prediction.actualValue);
+      }
+    }
+  }
+  ASSERT_TRUE(c1 == c2);
+}
+
+TEST_F(SDRClassifierTest, Real32Weights) {
+  // Real32 weights predict nearly the same likelihoods as Real64 weights,
+  // and keep their precision through serialization.
+  SDRClassifier c64 = SDRClassifier({1}, 0.1, 0.1, 0);
+  SDRClassifier c32 = SDRClassifier({1}, 0.1, 0.1, 0,
+                                    SDRClassifier::WeightPrecision::REAL32);
+  ASSERT_EQ(SDRClassifier::WeightPrecision::REAL32,
+            c32.getWeightPrecision());
+
+  Random rng(42);
+  for (UInt recordNum = 0; recordNum < 200; recordNum++) {
+    vector<UInt> pattern;
+    for (UInt bit = 0; bit < 100; bit++) {
+      if (rng.getReal64() < 0.1) {
+        pattern.push_back(bit);
+      }
+    }
+    const UInt bucket = rng.getUInt32(recordNum / 20 + 2);
+
+    ClassifierResult result64, result32;
+    c64.compute(recordNum, pattern, {bucket}, {(Real64)bucket}, false, true,
+                true, &result64);
+    c32.compute(recordNum, pattern, {bucket}, {(Real64)bucket}, false, true,
+                true, &result32);
+    vector<Real64> *likelihoods64 = stepLikelihoods(result64, 1);
+    vector<Real64> *likelihoods32 = stepLikelihoods(result32, 1);
+    ASSERT_EQ(likelihoods64->size(), likelihoods32->size());
+    for (UInt j = 0; j < likelihoods64->size(); j++) {
+      ASSERT_NEAR((*likelihoods64)[j], (*likelihoods32)[j], 1e-4);
+    }
+  }
+
+  SDRClassifier c2;
+  stringstream ss;
+  c32.write(ss);
+  c2.read(ss);
+  ASSERT_EQ(SDRClassifier::WeightPrecision::REAL32, c2.getWeightPrecision());
+  ASSERT_TRUE(c32 == c2);
+}
+
+TEST_F(SDRClassifierTest, LiveMatchesReloaded) {
+  // The activations that a live classifier patches as it learns predict the
+  // same likelihoods as the ones a reloaded classifier sums from the
+  // weights, after many learning steps. A tiny alpha keeps the weights near
+  // zero, where updates zero them. Real32 weights are rounded as they learn,
+  // and the activations drift from their sum by about the Real32 precision.
+  for (auto precision : {SDRClassifier::WeightPrecision::REAL64,
+                         SDRClassifier::WeightPrecision::REAL32}) {
+    const Real64 tolerance =
+        precision == SDRClassifier::WeightPrecision::REAL32 ? 1e-6 : 1e-9;
+    for (Real64 alpha : {0.1, 1e-5}) {
+      SDRClassifier live =
+          SDRClassifier({0, 1, 3}, alpha, 0.1, 0, precision);
+      SDRClassifier reloaded;
+
+      Random rng(42);
+      for (UInt recordNum = 0; recordNum < 2000; recordNum++) {
+        vector<UInt> pattern;
+        for (UInt bit = 0; bit < 40; bit++) {
+          if (rng.getReal64() < 0.2) {
+            pattern.push_back(bit);
+          }
+        }
+        const UInt bucket = rng.getUInt32(4);
+
+        if (recordNum == 1000) {
+          stringstream ss;
+          live.write(ss);
+          reloaded.read(ss);
+        }
+        ClassifierResult liveResult, reloadedResult;
+        live.compute(recordNum, pattern, {bucket}, {(Real64)bucket}, false,
+                     true, true, &liveResult);
+        if (recordNum < 1000) {
+          continue;
+        }
+        reloaded.compute(recordNum, pattern, {bucket}, {(Real64)bucket},
+                         false, true, true, &reloadedResult);
+        for (Int step : {0, 1, 3}) {
+          vector<Real64> *liveLikelihoods = stepLikelihoods(liveResult, step);
+          vector<Real64> *reloadedLikelihoods =
+              stepLikelihoods(reloadedResult, step);
+          ASSERT_EQ(liveLikelihoods->size(), reloadedLikelihoods->size());
+          for (UInt j = 0; j < liveLikelihoods->size(); j++) {
+            ASSERT_NEAR((*liveLikelihoods)[j], (*reloadedLikelihoods)[j],
+                        tolerance);
+          }
+        }
+      }
+      checkHistoryActivations_(live, tolerance);
+    }
+  }
+}
+
 } // end namespace
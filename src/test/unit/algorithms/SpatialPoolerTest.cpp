@@ -31,12 +31,14 @@
 #include "gtest/gtest.h"
 #include <nupic/algorithms/SpatialPooler.hpp>
 #include <nupic/math/StlIo.hpp>
+#include <nupic/math/Topology.hpp>
 #include <nupic/types/Types.hpp>
 #include <nupic/utils/Log.hpp>
 
 using namespace std;
 using namespace nupic;
 using namespace nupic::algorithms::spatial_pooler;
+using namespace nupic::math::topology;
 
 namespace {
 UInt countNonzero(const vector<UInt> &vec) {
@@ -2113,6 +2115,25 @@ TEST(SpatialPoolerTest, testWriteRead) {
   ASSERT_TRUE(ret == 0) << "Failed to delete " << filename;
 }
 
+TEST(SpatialPoolerTest, testReadFromFile) {
+  const char *filename = "SpatialPoolerSerialization.tmp";
+  SpatialPooler sp1, sp2;
+  UInt numInputs = 6;
+  UInt numColumns = 12;
+  setup(sp1, numInputs, numColumns);
+
+  ofstream os(filename, ios::binary);
+  sp1.write(os);
+  os.close();
+
+  sp2.readFromFile(filename);
+
+  ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sp1, sp2));
+
+  int ret = ::remove(filename);
+  ASSERT_TRUE(ret == 0) << "Failed to delete " << filename;
+}
+
 TEST(SpatialPoolerTest, testConstructorVsInitialize) {
   // Initialize SP using the constructor
   SpatialPooler sp1(
@@ -2159,4 +2180,300 @@ TEST(SpatialPoolerTest, testConstructorVsInitialize) {
   check_spatial_eq(sp1, sp2);
 }
 
+
+TEST(SpatialPoolerTest, testConnectedBackendsAgree) {
+  const UInt numInputs = 200;
+  const UInt numColumns = 256;
+  const UInt numRecords = 50;
+
+  // The default stays sparse
+  SpatialPooler defaultSp({numInputs}, {numColumns}, 100, 0.5, true, -1.0, 10);
+  EXPECT_EQ(ConnectedBackend::SPARSE, defaultSp.getConnectedBackend());
+
+  // Half of the inputs are potential and half of those connected, so AUTO
+  // must choose the packed backend here.
+  SpatialPooler autoSp = defaultSp;
+  autoSp.setConnectedBackend(ConnectedBackend::AUTO);
+  EXPECT_EQ(ConnectedBackend::PACKED, autoSp.getConnectedBackend());
+
+  SpatialPooler sparseSp, packedSp, packedInputSp;
+  for (SpatialPooler *sp : {&sparseSp, &packedSp, &packedInputSp}) {
+    sp->initialize(
+        /*inputDimensions*/ {numInputs},
+        /*columnDimensions*/ {numColumns},
+        /*potentialRadius*/ 100,
+        /*potentialPct*/ 0.5,
+        /*globalInhibition*/ true,
+        /*localAreaDensity*/ -1.0,
+        /*numActiveColumnsPerInhArea*/ 10,
+        /*stimulusThreshold*/ 0,
+        /*synPermInactiveDec*/ 0.008,
+        /*synPermActiveInc*/ 0.05,
+        /*synPermConnected*/ 0.1,
+        /*minPctOverlapDutyCycles*/ 0.001,
+        /*dutyCyclePeriod*/ 1000,
+        /*boostStrength*/ 1.0,
+        /*seed*/ 42,
+        /*spVerbosity*/ 0,
+        /*wrapAround*/ true,
+        sp == &sparseSp ? ConnectedBackend::SPARSE : ConnectedBackend::PACKED);
+  }
+  EXPECT_EQ(ConnectedBackend::SPARSE, sparseSp.getConnectedBackend());
+  EXPECT_EQ(ConnectedBackend::PACKED, packedSp.getConnectedBackend());
+
+  Random rng(7);
+  vector<UInt> input(numInputs);
+  vector<UInt64> packedInput(PackedBinaryMatrix::nWords(numInputs));
+  vector<UInt> sparseActive(numColumns), packedActive(numColumns),
+      packedInputActive(numColumns);
+  for (UInt record = 0; record < numRecords; record++) {
+    for (UInt i = 0; i < numInputs; i++) {
+      input[i] = rng.getReal64() < 0.3 ? 1 : 0;
+    }
+    PackedBinaryMatrix::pack(input.data(), numInputs, packedInput.data());
+
+    const bool learn = record % 5 != 4;
+    sparseSp.compute(input.data(), learn, sparseActive.data());
+    packedSp.compute(input.data(), learn, packedActive.data());
+    packedInputSp.computePacked(packedInput.data(), learn,
+                                packedInputActive.data());
+
+    ASSERT_EQ(sparseSp.getOverlaps(), packedSp.getOverlaps());
+    ASSERT_EQ(sparseSp.getOverlaps(), packedInputSp.getOverlaps());
+    ASSERT_EQ(sparseActive, packedActive);
+    ASSERT_EQ(sparseActive, packedInputActive);
+  }
+
+  ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sparseSp, packedSp));
+  ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sparseSp, packedInputSp));
+}
+
+
+TEST(SpatialPoolerTest, testComputeBatch) {
+  const UInt numInputs = 120;
+  const UInt numColumns = 64;
+  const UInt batchSize = 37;
+
+  Random rng(11);
+  vector<UInt> inputs(batchSize * numInputs);
+  vector<UInt> indices, offsets = {0};
+  for (UInt b = 0; b < batchSize; b++) {
+    for (UInt i = 0; i < numInputs; i++) {
+      if (rng.getReal64() < 0.2) {
+        inputs[b * numInputs + i] = 1;
+        indices.push_back(i);
+      }
+    }
+    offsets.push_back(indices.size());
+  }
+
+  for (bool globalInhibition : {true, false}) {
+    for (ConnectedBackend backend :
+         {ConnectedBackend::SPARSE, ConnectedBackend::PACKED}) {
+      SpatialPooler sp({numInputs}, {numColumns}, 16, 0.5, globalInhibition,
+                       -1.0, 5, 0, 0.008, 0.05, 0.1, 0.001, 1000, 0.0, 3, 0,
+                       true, backend);
+      vector<UInt> active(numColumns);
+      for (UInt i = 0; i < 20; i++) {
+        sp.compute(&inputs[(i % batchSize) * numInputs], true, active.data());
+      }
+
+      SpatialPooler expectedSp = sp;
+      vector<UInt> expected(batchSize * numColumns);
+      for (UInt b = 0; b < batchSize; b++) {
+        expectedSp.compute(&inputs[b * numInputs], false,
+                           &expected[b * numColumns]);
+      }
+
+      for (UInt numThreads : {1, 3}) {
+        SpatialPooler denseSp = sp;
+        vector<UInt> denseActive(batchSize * numColumns);
+        denseSp.computeBatch(inputs.data(), batchSize, denseActive.data(),
+                             numThreads);
+        EXPECT_EQ(expected, denseActive);
+        EXPECT_EQ(expectedSp.getIterationNum(), denseSp.getIterationNum());
+        EXPECT_EQ(expectedSp.getOverlaps(), denseSp.getOverlaps());
+        EXPECT_EQ(expectedSp.getBoostedOverlaps(),
+                  denseSp.getBoostedOverlaps());
+
+        SpatialPooler sparseSp = sp;
+        vector<UInt> sparseActive(batchSize * numColumns);
+        sparseSp.computeBatchSparse(indices.data(), offsets.data(), batchSize,
+                                    sparseActive.data(), numThreads);
+        EXPECT_EQ(expected, sparseActive);
+        EXPECT_EQ(expectedSp.getOverlaps(), sparseSp.getOverlaps());
+      }
+    }
+  }
+}
+
+TEST(SpatialPoolerTest, testFastInitialization) {
+  for (bool wrapAround : {true, false}) {
+    vector<SpatialPooler> sps(3);
+    const UInt initThreads[] = {1, 4, 64};
+    for (UInt i = 0; i < sps.size(); i++) {
+      sps[i].initialize(
+          /*inputDimensions*/ {12, 10},
+          /*columnDimensions*/ {6, 5},
+          /*potentialRadius*/ 3,
+          /*potentialPct*/ 0.5,
+          /*globalInhibition*/ true,
+          /*localAreaDensity*/ -1.0,
+          /*numActiveColumnsPerInhArea*/ 5,
+          /*stimulusThreshold*/ 4,
+          /*synPermInactiveDec*/ 0.008,
+          /*synPermActiveInc*/ 0.05,
+          /*synPermConnected*/ 0.1,
+          /*minPctOverlapDutyCycles*/ 0.001,
+          /*dutyCyclePeriod*/ 1000,
+          /*boostStrength*/ 1.0,
+          /*seed*/ 9,
+          /*spVerbosity*/ 0, wrapAround, ConnectedBackend::AUTO,
+          initThreads[i]);
+    }
+
+    // The model only depends on the seed.
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sps[0], sps[1]));
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sps[0], sps[2]));
+
+    SpatialPooler &sp = sps[0];
+    const UInt numInputs = sp.getNumInputs();
+    const UInt numColumns = sp.getNumColumns();
+    vector<UInt> connectedCounts(numColumns);
+    sp.getConnectedCounts(connectedCounts.data());
+    for (UInt column = 0; column < numColumns; column++) {
+      vector<UInt> potential(numInputs), connected(numInputs);
+      vector<Real> perm(numInputs);
+      sp.getPotential(column, potential.data());
+      sp.getConnectedSynapses(column, connected.data());
+      sp.getPermanence(column, perm.data());
+
+      // The potential pool is half of the column's neighborhood.
+      const UInt center = sp.mapColumn_(column);
+      UInt numNeighbors = 0, numPotential = 0, numConnected = 0;
+      vector<UInt> inNeighborhood(numInputs, 0);
+      const vector<UInt> inputDimensions = sp.getInputDimensions();
+      if (wrapAround) {
+        for (UInt input : WrappingNeighborhood(center, 3, inputDimensions)) {
+          inNeighborhood[input] = 1;
+        }
+      } else {
+        for (UInt input : Neighborhood(center, 3, inputDimensions)) {
+          inNeighborhood[input] = 1;
+        }
+      }
+      for (UInt i = 0; i < numInputs; i++) {
+        numNeighbors += inNeighborhood[i];
+        numPotential += potential[i];
+        numConnected += connected[i];
+        if (!potential[i]) {
+          ASSERT_EQ(0, perm[i]);
+        }
+        ASSERT_LE(potential[i], inNeighborhood[i]);
+        ASSERT_EQ(connected[i] == 1, perm[i] >= 0.1 - 0.000001);
+        ASSERT_LE(perm[i], 1.0);
+      }
+      ASSERT_EQ(round(numNeighbors * 0.5), numPotential);
+      ASSERT_EQ(numConnected, connectedCounts[column]);
+      ASSERT_GE(numConnected, 4);
+    }
+  }
+}
+
+TEST(SpatialPoolerTest, testQuantizedPermanences) {
+  const UInt numInputs = 80;
+  const UInt numColumns = 40;
+  const char *filename = "SpatialPoolerSerialization.tmp";
+
+  for (PermanenceBackend backend :
+       {PermanenceBackend::UINT16, PermanenceBackend::UINT8}) {
+    const Real step = backend == PermanenceBackend::UINT8 ? 1.0 / 255
+                                                         : 1.0 / 65535;
+    SpatialPooler sp({numInputs}, {numColumns}, 20, 0.5, true, -1.0, 4, 3,
+                     0.008, 0.05, 0.1, 0.001, 1000, 0.0, 5, 0, true,
+                     ConnectedBackend::AUTO, 0, backend);
+    EXPECT_EQ(backend, sp.getPermanenceBackend());
+
+    // Increments are rounded to the nearest step, but never to 0.
+    vector<UInt> potential(numInputs), input(numInputs, 0);
+    vector<Real> perm(numInputs), before(numInputs);
+    sp.getPotential(0, potential.data());
+    sp.getPermanence(0, before.data());
+    for (UInt i = 0; i < numInputs; i += 2) {
+      input[i] = 1;
+    }
+    vector<UInt> activeColumns = {0};
+    sp.setSynPermInactiveDec(step / 10);
+    sp.adaptSynapses_(input.data(), activeColumns);
+    sp.getPermanence(0, perm.data());
+    for (UInt i = 0; i < numInputs; i++) {
+      if (!potential[i]) {
+        ASSERT_EQ(0, perm[i]);
+      } else if (input[i]) {
+        ASSERT_NEAR(min(1.0, before[i] + round(0.05 / step) * step), perm[i],
+                    1e-5);
+      } else if (before[i] >= step) {
+        ASSERT_NEAR(before[i] - step, perm[i], 1e-5);
+      }
+    }
+    sp.setSynPermInactiveDec(0.008);
+
+    Random rng(3);
+    vector<UInt> active(numColumns);
+    for (UInt record = 0; record < 50; record++) {
+      for (UInt i = 0; i < numInputs; i++) {
+        input[i] = rng.getReal64() < 0.25 ? 1 : 0;
+      }
+      sp.compute(input.data(), true, active.data());
+    }
+
+    // Permanences are on the grid and connected synapses match them.
+    vector<UInt> connected(numInputs), connectedCounts(numColumns);
+    sp.getConnectedCounts(connectedCounts.data());
+    for (UInt column = 0; column < numColumns; column++) {
+      sp.getPotential(column, potential.data());
+      sp.getPermanence(column, perm.data());
+      sp.getConnectedSynapses(column, connected.data());
+      UInt numConnected = 0;
+      for (UInt i = 0; i < numInputs; i++) {
+        ASSERT_NEAR(round(perm[i] / step) * step, perm[i], 1e-6);
+        ASSERT_TRUE(perm[i] == 0 || potential[i]);
+        ASSERT_TRUE(perm[i] == 0 || perm[i] >= 0.025);
+        ASSERT_EQ(perm[i] >= 0.1 - 0.000001, connected[i] == 1);
+        numConnected += connected[i];
+      }
+      ASSERT_EQ(numConnected, connectedCounts[column]);
+      ASSERT_GE(numConnected, 3);
+    }
+
+    // write and read keep the backend and the values.
+    SpatialPooler readSp;
+    ofstream os(filename, ios::binary);
+    sp.write(os);
+    os.close();
+    ifstream is(filename, ios::binary);
+    readSp.read(is);
+    is.close();
+    ASSERT_EQ(0, ::remove(filename));
+    EXPECT_EQ(backend, readSp.getPermanenceBackend());
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sp, readSp));
+
+    // Converting to REAL keeps the values.
+    SpatialPooler realSp = sp;
+    realSp.setPermanenceBackend(PermanenceBackend::REAL);
+    EXPECT_EQ(PermanenceBackend::REAL, realSp.getPermanenceBackend());
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sp, realSp));
+
+    vector<UInt> readActive(numColumns), realActive(numColumns);
+    for (UInt i = 0; i < numInputs; i++) {
+      input[i] = rng.getReal64() < 0.25 ? 1 : 0;
+    }
+    sp.compute(input.data(), false, active.data());
+    readSp.compute(input.data(), false, readActive.data());
+    realSp.compute(input.data(), false, realActive.data());
+    EXPECT_EQ(active, readActive);
+    EXPECT_EQ(active, realActive);
+  }
+}
+
 } // end anonymous namespace
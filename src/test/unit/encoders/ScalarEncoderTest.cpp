@@ -57,6 +57,41 @@ std::vector<Real32> patternFromNZ(int n, std::vector<size_t> patternNZ) {
   return v;
 }
 
+// Checks encodeSparse and the batch encodings against encodeIntoArray.
+void doSparseAndBatchCases(ScalarEncoderBase &e, std::vector<Real64> inputs) {
+  const int n = e.getOutputWidth();
+  const int w = e.getW();
+  std::vector<Real32> denseBatch(inputs.size() * n);
+  std::vector<UInt32> sparseBatch(inputs.size() * w);
+  std::vector<int> denseBuckets(inputs.size()), sparseBuckets(inputs.size());
+  e.encodeBatch(inputs.data(), inputs.size(), denseBatch.data(),
+                denseBuckets.data());
+  e.encodeSparseBatch(inputs.data(), inputs.size(), sparseBatch.data(),
+                      sparseBuckets.data());
+
+  for (size_t i = 0; i < inputs.size(); i++) {
+    auto dense = std::vector<Real32>(n);
+    const int bucket = e.encodeIntoArray(inputs[i], dense.data());
+    std::vector<UInt32> expectedSparse;
+    for (int j = 0; j < n; j++) {
+      if (dense[j] != 0) {
+        expectedSparse.push_back(j);
+      }
+    }
+
+    auto sparse = std::vector<UInt32>(w);
+    EXPECT_EQ(bucket, e.encodeSparse(inputs[i], sparse.data()));
+    EXPECT_EQ(expectedSparse, sparse) << "For input " << inputs[i];
+
+    EXPECT_EQ(dense, std::vector<Real32>(denseBatch.begin() + i * n,
+                                         denseBatch.begin() + (i + 1) * n));
+    EXPECT_EQ(sparse, std::vector<UInt32>(sparseBatch.begin() + i * w,
+                                          sparseBatch.begin() + (i + 1) * w));
+    EXPECT_EQ(bucket, denseBuckets[i]);
+    EXPECT_EQ(bucket, sparseBuckets[i]);
+  }
+}
+
 void doScalarValueCases(ScalarEncoderBase &e,
                         std::vector<ScalarValueCase> cases) {
   for (auto c = cases.begin(); c != cases.end(); c++) {
@@ -206,3 +241,39 @@ TEST(PeriodicScalarEncoder, FloorToNearestMultipleOfResolution) {
 
   doScalarValueCases(encoder, cases);
 }
+
+TEST(ScalarEncoder, SparseAndBatch) {
+  ScalarEncoder encoder(3, 0, 10, 14, 0, 0, true);
+  doSparseAndBatchCases(encoder, {-1, 0, 0.4, 2.5, 5, 7.7, 9.9, 10, 11});
+}
+
+TEST(PeriodicScalarEncoder, SparseAndBatch) {
+  // Even and odd widths, so the active bits wrap around either edge.
+  for (int w : {3, 4}) {
+    PeriodicScalarEncoder encoder(w, 0, 10, 10, 0, 0);
+    doSparseAndBatchCases(encoder, {0, 0.5, 1, 2.5, 5, 7.7, 8.5, 9, 9.9});
+  }
+}
+
+// An encoder that only implements the dense encoding, and relies on the
+// defaults of ScalarEncoderBase for the sparse one.
+class DenseOnlyEncoder : public ScalarEncoderBase {
+public:
+  DenseOnlyEncoder(ScalarEncoderBase &encoder) : encoder_(encoder) {}
+  virtual int encodeIntoArray(Real64 input, Real32 output[]) override {
+    return encoder_.encodeIntoArray(input, output);
+  }
+  virtual int getOutputWidth() const override {
+    return encoder_.getOutputWidth();
+  }
+
+private:
+  ScalarEncoderBase &encoder_;
+};
+
+TEST(ScalarEncoderBase, DefaultSparseEncoding) {
+  ScalarEncoder scalar(3, 0, 10, 14, 0, 0, true);
+  DenseOnlyEncoder encoder(scalar);
+  EXPECT_EQ(3, encoder.getW());
+  doSparseAndBatchCases(encoder, {-1, 0, 0.4, 2.5, 5, 7.7, 9.9, 10, 11});
+}
@@ -0,0 +1,110 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of ScalarSensor test
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <nupic/encoders/ScalarEncoder.hpp>
+#include <nupic/engine/Network.hpp>
+#include <nupic/engine/Output.hpp>
+#include <nupic/engine/Region.hpp>
+#include <nupic/engine/RegionImplFactory.hpp>
+#include <nupic/engine/RegisteredRegionImpl.hpp>
+#include <nupic/engine/Spec.hpp>
+#include <nupic/engine/TestNode.hpp>
+#include <nupic/ntypes/BundleIO.hpp>
+
+using namespace nupic;
+
+namespace {
+
+// A TestNode with a sparse input, for links from encodedSparse
+class SparseInputTestNode : public TestNode {
+public:
+  SparseInputTestNode(const ValueMap &params, Region *region)
+      : TestNode(params, region) {}
+  SparseInputTestNode(BundleIO &bundle, Region *region)
+      : TestNode(bundle, region) {}
+  SparseInputTestNode(capnp::AnyPointer::Reader &proto, Region *region)
+      : TestNode(proto, region) {}
+
+  std::string getNodeType() { return "SparseInputTestNode"; }
+
+  static Spec *createSpec() {
+    Spec *ns = TestNode::createSpec();
+    ns->inputs.add("sparseIn",
+                   InputSpec("Sparse input", NTA_BasicType_UInt32,
+                             0,     // count
+                             false, // required
+                             true,  // regionLevel
+                             false, // isDefaultInput
+                             false, // requireSplitterMap
+                             true   // sparse
+                             ));
+    return ns;
+  }
+};
+
+} // namespace
+
+TEST(ScalarSensorTest, DenseOutputWithSparseLinkOnly) {
+  // When only encodedSparse is linked, encoded is still readable and
+  // follows the sensed value.
+  RegionImplFactory::registerCPPRegion(
+      "SparseInputTestNode",
+      new RegisteredRegionImpl<SparseInputTestNode>());
+
+  {
+    Network net;
+    Region *sensor =
+        net.addRegion("sensor", "ScalarSensor",
+                      "{n: 14, w: 3, minValue: 0, maxValue: 10, "
+                      "clipInput: true}");
+    Region *sink = net.addRegion("sink", "SparseInputTestNode", "");
+    Dimensions d;
+    d.push_back(1);
+    sink->setDimensions(d);
+    net.link("sensor", "sink", "UniformLink", "{mapping: in, rfSize: [1]}",
+             "encodedSparse", "sparseIn");
+
+    ScalarEncoder encoder(3, 0, 10, 14, 0, 0, true);
+    for (Real64 value : {2.5, 7.7, 7.7, 0.0, 11.0}) {
+      sensor->setParameterReal64("sensedValue", value);
+      net.run(1);
+
+      std::vector<Real32> expected(14);
+      encoder.encodeIntoArray(value, expected.data());
+      const Array &encoded = sensor->getOutput("encoded")->getData();
+      ASSERT_EQ(expected.size(), encoded.getCount());
+      const Real32 *actual = (const Real32 *)encoded.getBuffer();
+      EXPECT_EQ(expected, std::vector<Real32>(actual, actual + 14))
+          << "For input " << value;
+    }
+  }
+
+  RegionImplFactory::unregisterCPPRegion("SparseInputTestNode");
+}
@@ -29,7 +29,11 @@
 #include <nupic/engine/Network.hpp>
 #include <nupic/engine/Output.hpp>
 #include <nupic/engine/Region.hpp>
+#include <nupic/engine/RegionImplFactory.hpp>
+#include <nupic/engine/RegisteredRegionImpl.hpp>
+#include <nupic/engine/Spec.hpp>
 #include <nupic/engine/TestNode.hpp>
+#include <nupic/ntypes/BundleIO.hpp>
 #include <nupic/ntypes/Dimensions.hpp>
 
 using namespace nupic;
@@ -243,3 +247,141 @@ TEST(InputTest, LinkTwoRegionsOneInput) {
   ASSERT_EQ(15, data[95]);
   ASSERT_EQ(31, data[127]);
 }
+
+TEST(InputTest, ZeroCopy) {
+  class ReadOnlyTestNode : public TestNode {
+  public:
+    ReadOnlyTestNode(const ValueMap &params, Region *region)
+        : TestNode(params, region) {}
+
+    ReadOnlyTestNode(BundleIO &bundle, Region *region)
+        : TestNode(bundle, region) {}
+
+    ReadOnlyTestNode(capnp::AnyPointer::Reader &proto, Region *region)
+        : TestNode(proto, region) {}
+
+    std::string getNodeType() { return "ReadOnlyTestNode"; }
+
+    static Spec *createSpec() {
+      Spec *ns = TestNode::createSpec();
+      InputSpec is = ns->inputs.getByName("bottomUpIn");
+      is.readOnly = true;
+      ns->inputs.remove("bottomUpIn");
+      ns->inputs.add("bottomUpIn", is);
+      return ns;
+    }
+  };
+
+  RegionImplFactory::registerCPPRegion(
+      "ReadOnlyTestNode", new RegisteredRegionImpl<ReadOnlyTestNode>());
+
+  Network net;
+  Region *region1 = net.addRegion("region1", "TestNode", "");
+  Region *region2 = net.addRegion("region2", "ReadOnlyTestNode", "");
+  Region *region3 = net.addRegion("region3", "ReadOnlyTestNode", "");
+  Region *region4 = net.addRegion("region4", "TestNode", "");
+  Region *region5 = net.addRegion("region5", "ReadOnlyTestNode", "");
+
+  RegionImplFactory::unregisterCPPRegion("ReadOnlyTestNode");
+
+  Dimensions d1;
+  d1.push_back(8);
+  d1.push_back(4);
+  region1->setDimensions(d1);
+  region4->setDimensions(d1);
+
+  // A single link without delay to a read-only input reads the output's
+  // buffer, a delayed link and an input with several links keep a copy.
+  net.link("region1", "region2", "TestFanIn2", "");
+  net.link("region1", "region3", "TestFanIn2", "", "", "", 1);
+  net.link("region4", "region3", "TestFanIn2", "");
+  net.link("region1", "region5", "TestFanIn2", "", "", "", 1);
+
+  net.initialize();
+
+  Input *in2 = region2->getInput("bottomUpIn");
+  Input *in3 = region3->getInput("bottomUpIn");
+  Input *in5 = region5->getInput("bottomUpIn");
+  const Array &out1 = region1->getOutput("bottomUpOut")->getData();
+  ASSERT_TRUE(in2->isZeroCopy());
+  ASSERT_FALSE(in3->isZeroCopy());
+  ASSERT_FALSE(in5->isZeroCopy());
+  ASSERT_EQ(out1.getBuffer(), in2->getData().getBuffer());
+  ASSERT_NE(out1.getBuffer(), in3->getData().getBuffer());
+
+  net.run(2);
+
+  const Real64 *src = (const Real64 *)out1.getBuffer();
+  const Real64 *dest = (const Real64 *)in2->getData().getBuffer();
+  ASSERT_EQ(out1.getCount(), in2->getData().getCount());
+  for (size_t i = 0; i < out1.getCount(); i++) {
+    ASSERT_EQ(src[i], dest[i]);
+  }
+}
+
+TEST(InputTest, WritableInputKeepsCopy) {
+  class InputWritingTestNode : public TestNode {
+  public:
+    InputWritingTestNode(const ValueMap &params, Region *region)
+        : TestNode(params, region) {}
+
+    InputWritingTestNode(BundleIO &bundle, Region *region)
+        : TestNode(bundle, region) {}
+
+    InputWritingTestNode(capnp::AnyPointer::Reader &proto, Region *region)
+        : TestNode(proto, region) {}
+
+    std::string getNodeType() { return "InputWritingTestNode"; }
+
+    void compute() override {
+      TestNode::compute();
+
+      // Scribble over the input once it has been read
+      const Array &input = getInput("bottomUpIn")->getData();
+      Real64 *data = (Real64 *)input.getBuffer();
+      for (size_t i = 0; i < input.getCount(); i++) {
+        data[i] = -1;
+      }
+    }
+  };
+
+  RegionImplFactory::registerCPPRegion(
+      "InputWritingTestNode", new RegisteredRegionImpl<InputWritingTestNode>());
+
+  Network net;
+  Region *region1 = net.addRegion("region1", "TestNode", "");
+  Region *region2 = net.addRegion("region2", "InputWritingTestNode", "");
+  Region *region3 = net.addRegion("region3", "TestNode", "");
+
+  RegionImplFactory::unregisterCPPRegion("InputWritingTestNode");
+
+  Dimensions d1;
+  d1.push_back(8);
+  d1.push_back(4);
+  region1->setDimensions(d1);
+
+  // region2 does not declare its input read-only, so it gets a copy
+  net.link("region1", "region2", "TestFanIn2", "");
+  net.link("region1", "region3", "TestFanIn2", "");
+
+  net.initialize();
+
+  Input *in2 = region2->getInput("bottomUpIn");
+  Input *in3 = region3->getInput("bottomUpIn");
+  const Array &out1 = region1->getOutput("bottomUpOut")->getData();
+  ASSERT_FALSE(in2->isZeroCopy());
+  ASSERT_NE(out1.getBuffer(), in2->getData().getBuffer());
+
+  net.run(1);
+
+  // The writes went to region2's copy only
+  const Real64 *src = (const Real64 *)out1.getBuffer();
+  const Real64 *written = (const Real64 *)in2->getData().getBuffer();
+  const Real64 *other = (const Real64 *)in3->getData().getBuffer();
+  ASSERT_EQ(out1.getCount(), in3->getData().getCount());
+  for (size_t i = 0; i < out1.getCount(); i++) {
+    ASSERT_EQ(-1, written[i]);
+    ASSERT_NE(-1, src[i]);
+    ASSERT_EQ(src[i], other[i]);
+  }
+}
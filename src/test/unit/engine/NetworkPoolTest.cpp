@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of NetworkPool test
+ */
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <nupic/engine/Network.hpp>
+#include <nupic/engine/NetworkPool.hpp>
+#include <nupic/engine/Region.hpp>
+#include <nupic/ntypes/ArrayRef.hpp>
+#include <nupic/ntypes/Dimensions.hpp>
+
+using namespace nupic;
+
+namespace {
+
+Network *createModel() {
+  auto n = new Network;
+  Dimensions d;
+  d.push_back(2);
+  d.push_back(2);
+  Region *l1 = n->addRegion("level1", "TestNode", "");
+  n->addRegion("level2", "TestNode", "");
+  l1->setDimensions(d);
+  n->link("level1", "level2", "TestFanIn2", "");
+  return n;
+}
+
+} // end namespace
+
+TEST(NetworkPoolTest, RecordsOfAModelStayInOrder) {
+  const size_t numModels = 16;
+  const Int64 numRecords = 50;
+
+  NetworkPool pool(4);
+  ASSERT_EQ((UInt32)4, pool.getNumThreads());
+  for (size_t m = 0; m < numModels; m++)
+    ASSERT_EQ(m, pool.addModel(createModel()));
+  ASSERT_EQ(numModels, pool.getNumModels());
+
+  // Each model only runs on one thread at a time, so its own vector needs
+  // no lock
+  std::vector<std::vector<Int64>> seen(numModels);
+  pool.setResultCallback([&seen](NetworkPool::ModelId model, Network &n) {
+    seen[model].push_back(
+        n.getRegions().getByName("level1")->getParameterInt64("int64Param"));
+  });
+
+  // Two producers, each submitting for half of the models
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < 2; p++) {
+    producers.emplace_back([&pool, p, numModels, numRecords] {
+      for (Int64 r = 0; r < numRecords; r++) {
+        for (size_t m = p; m < numModels; m += 2) {
+          pool.submit(m, [r](Network &n) {
+            n.getRegions().getByName("level1")->setParameterInt64(
+                "int64Param", r);
+          });
+        }
+      }
+    });
+  }
+  for (auto &producer : producers)
+    producer.join();
+  pool.wait();
+
+  Network *reference = createModel();
+  reference->run(numRecords);
+  for (size_t m = 0; m < numModels; m++) {
+    ASSERT_EQ((size_t)numRecords, seen[m].size());
+    for (Int64 r = 0; r < numRecords; r++)
+      ASSERT_EQ(r, seen[m][r]);
+    const ArrayRef expected =
+        reference->getRegions().getByName("level2")->getOutputData(
+            "bottomUpOut");
+    const ArrayRef actual =
+        pool.getNetwork(m).getRegions().getByName("level2")->getOutputData(
+            "bottomUpOut");
+    ASSERT_EQ(expected.getCount(), actual.getCount());
+    ASSERT_EQ(0, ::memcmp(expected.getBuffer(), actual.getBuffer(),
+                          expected.getBufferSize()));
+
+    const NetworkPool::ModelStats stats = pool.getModelStats(m);
+    ASSERT_EQ((UInt64)numRecords, stats.records);
+    ASSERT_EQ((UInt64)0, stats.errors);
+    ASSERT_EQ((UInt64)numRecords, stats.runLatency.getCount());
+    ASSERT_EQ((UInt64)numRecords, stats.queueLatency.getCount());
+  }
+  delete reference;
+}
+
+TEST(NetworkPoolTest, ErrorsAreCountedPerModel) {
+  NetworkPool pool(2);
+  pool.addModel(createModel());
+  pool.addModel(createModel());
+
+  pool.submit(0, [](Network &n) {
+    n.getRegions().getByName("level1")->setParameterInt64("noSuchParam", 1);
+  });
+  pool.submit(0, NetworkPool::Record());
+  pool.submit(1, NetworkPool::Record());
+  pool.wait();
+
+  const NetworkPool::ModelStats stats0 = pool.getModelStats(0);
+  ASSERT_EQ((UInt64)2, stats0.records);
+  ASSERT_EQ((UInt64)1, stats0.errors);
+  ASSERT_FALSE(stats0.lastError.empty());
+  ASSERT_EQ((UInt64)0, pool.getModelStats(1).errors);
+
+  EXPECT_THROW(pool.submit(2, NetworkPool::Record()), std::exception);
+}
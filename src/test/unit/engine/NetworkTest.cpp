@@ -27,10 +27,23 @@
 #include "gtest/gtest.h"
 
 #include <nupic/engine/Network.hpp>
+#include <nupic/engine/NetworkCheckpoint.hpp>
+#include <nupic/engine/NetworkInputSource.hpp>
+#include <nupic/engine/NetworkOutputSink.hpp>
 #include <nupic/engine/NuPIC.hpp>
 #include <nupic/engine/Region.hpp>
+#include <nupic/engine/RegionImplFactory.hpp>
+#include <nupic/engine/RegisteredRegionImpl.hpp>
+#include <nupic/engine/Spec.hpp>
+#include <nupic/engine/TestNode.hpp>
+#include <nupic/ntypes/ArrayRef.hpp>
+#include <nupic/ntypes/BundleIO.hpp>
 #include <nupic/ntypes/Dimensions.hpp>
+#include <nupic/os/Directory.hpp>
+#include <nupic/os/FStream.hpp>
+#include <nupic/os/Path.hpp>
 #include <nupic/utils/Log.hpp>
+#include <nupic/utils/StringUtils.hpp>
 
 using namespace nupic;
 
@@ -132,6 +145,91 @@ TEST(NetworkTest, InitializationNoRegions) {
   net.run(1);
 }
 
+TEST(NetworkTest, InitializationInducesDimensionsAgainstRegionOrder) {
+  Network net;
+  // Each region gets its input from the next one, and only the last one
+  // has dimensions, so they have to travel backwards through the regions.
+  const size_t numRegions = 6;
+  for (size_t i = 0; i < numRegions; i++)
+    net.addRegion("level" + StringUtils::fromInt(i), "TestNode", "");
+  for (size_t i = 0; i + 1 < numRegions; i++)
+    net.link("level" + StringUtils::fromInt(i + 1),
+             "level" + StringUtils::fromInt(i), "TestFanIn2", "");
+
+  Dimensions d;
+  d.push_back(64);
+  d.push_back(32);
+  net.getRegions()
+      .getByName("level" + StringUtils::fromInt(numRegions - 1))
+      ->setDimensions(d);
+  net.initialize();
+
+  for (size_t i = numRegions - 1; i-- > 0;) {
+    d[0] /= 2;
+    d[1] /= 2;
+    ASSERT_EQ(d, net.getRegions()
+                     .getByName("level" + StringUtils::fromInt(i))
+                     ->getDimensions());
+  }
+
+  // A region that no link reaches still stops initialization
+  Network incomplete;
+  incomplete.addRegion("level0", "TestNode", "");
+  incomplete.addRegion("level1", "TestNode", "");
+  incomplete.link("level1", "level0", "TestFanIn2", "");
+  EXPECT_THROW(incomplete.initialize(), std::exception);
+}
+
+TEST(NetworkTest, InitializationRequeuesLinkWithNewLinkDimensions) {
+  class RegionLevelTestNode : public TestNode {
+  public:
+    RegionLevelTestNode(const ValueMap &params, Region *region)
+        : TestNode(params, region) {}
+
+    RegionLevelTestNode(BundleIO &bundle, Region *region)
+        : TestNode(bundle, region) {}
+
+    RegionLevelTestNode(capnp::AnyPointer::Reader &proto, Region *region)
+        : TestNode(proto, region) {}
+
+    std::string getNodeType() { return "RegionLevelTestNode"; }
+
+    static Spec *createSpec() {
+      Spec *ns = TestNode::createSpec();
+      InputSpec is = ns->inputs.getByName("bottomUpIn");
+      is.regionLevel = true;
+      ns->inputs.remove("bottomUpIn");
+      ns->inputs.add("bottomUpIn", is);
+      return ns;
+    }
+  };
+
+  RegionImplFactory::registerCPPRegion(
+      "RegionLevelTestNode", new RegisteredRegionImpl<RegionLevelTestNode>());
+
+  Network net;
+  Region *bottom = net.addRegion("bottom", "TestNode", "");
+  Region *top = net.addRegion("top", "RegionLevelTestNode", "");
+
+  RegionImplFactory::unregisterCPPRegion("RegionLevelTestNode");
+
+  Dimensions d;
+  d.push_back(4);
+  d.push_back(2);
+  top->setDimensions(d);
+  net.link("bottom", "top", "TestFanIn2", "");
+
+  // The first evaluation of the link gives it both of its dimensions from
+  // the region level input, but no region gets new dimensions, so only the
+  // link itself being queued again induces the dimensions of bottom.
+  net.initialize();
+
+  Dimensions expected;
+  expected.push_back(2);
+  expected.push_back(2);
+  ASSERT_EQ(expected, bottom->getDimensions());
+}
+
 TEST(NetworkTest, Modification) {
   NTA_DEBUG << "Running network modification tests";
 
@@ -542,6 +640,278 @@ TEST(NetworkTest, Callback) {
   EXPECT_STREQ("level3", mydata[5].c_str());
 }
 
+TEST(NetworkTest, RunThreads) {
+  // Two independent stacks with both levels in the same phase compute the
+  // same on one thread and on several.
+  Network n1;
+  Network n2;
+  ASSERT_EQ((UInt32)1, n1.getRunThreads());
+  n2.setRunThreads(4);
+  ASSERT_EQ((UInt32)4, n2.getRunThreads());
+  EXPECT_THROW(n2.setRunThreads(0), std::exception);
+
+  for (Network *n : {&n1, &n2}) {
+    Dimensions d;
+    d.push_back(4);
+    d.push_back(4);
+    std::set<UInt32> phases;
+    phases.insert(0);
+
+    for (const std::string stack : {"a", "b"}) {
+      Region *l1 = n->addRegion("level1" + stack, "TestNode", "");
+      n->addRegion("level2" + stack, "TestNode", "");
+      l1->setDimensions(d);
+      n->link("level1" + stack, "level2" + stack, "TestFanIn2", "");
+      n->setPhases("level1" + stack, phases);
+      n->setPhases("level2" + stack, phases);
+    }
+  }
+
+  n1.run(3);
+  n2.run(3);
+  ASSERT_TRUE(n1 == n2);
+
+  // Back to one thread
+  n2.setRunThreads(1);
+  n1.run(2);
+  n2.run(2);
+  ASSERT_TRUE(n1 == n2);
+}
+
+TEST(NetworkTest, RunThreadsAfterChanges) {
+  // The order of the regions that run() keeps between runs follows the
+  // phases and regions that change after the network is initialized.
+  Network n1;
+  Network n2;
+  n2.setRunThreads(4);
+
+  for (Network *n : {&n1, &n2}) {
+    Dimensions d;
+    d.push_back(4);
+    d.push_back(4);
+    std::set<UInt32> phases;
+    phases.insert(0);
+
+    for (const std::string stack : {"a", "b"}) {
+      Region *l1 = n->addRegion("level1" + stack, "TestNode", "");
+      n->addRegion("level2" + stack, "TestNode", "");
+      l1->setDimensions(d);
+      n->link("level1" + stack, "level2" + stack, "TestFanIn2", "");
+      n->setPhases("level1" + stack, phases);
+      n->setPhases("level2" + stack, phases);
+    }
+    n->run(2);
+
+    // level2a moves to its own phase, after level1a
+    phases.clear();
+    phases.insert(1);
+    n->setPhases("level2a", phases);
+    n->run(2);
+
+    n->removeRegion("level2b");
+    n->run(2);
+
+    Region *r = n->addRegion("single", "TestNode", "");
+    r->setDimensions(d);
+    n->run(2);
+  }
+
+  ASSERT_TRUE(n1 == n2);
+  ASSERT_EQ((UInt32)1, n2.getPhases("level2a").size());
+  ASSERT_EQ((UInt32)1, *n2.getPhases("level2a").begin());
+}
+
+TEST(NetworkTest, ProfilingReport) {
+  Network n;
+  Dimensions d;
+  d.push_back(4);
+  d.push_back(4);
+  Region *l1 = n.addRegion("level1", "TestNode", "");
+  n.addRegion("level2", "TestNode", "");
+  l1->setDimensions(d);
+  n.link("level1", "level2", "TestFanIn2", "");
+
+  // Nothing is recorded until profiling is enabled
+  n.run(1);
+  ASSERT_EQ("{\"stages\": []}", n.getProfilingReport());
+
+  n.enableProfiling();
+  n.run(5);
+  n.disableProfiling();
+  n.run(1);
+
+  const std::string csv = n.getProfilingReport("csv");
+  ASSERT_EQ(0u, csv.find("stage,name,count,total_us,mean_us,min_us,p50_us,"
+                         "p90_us,p99_us,max_us\n"));
+  ASSERT_NE(std::string::npos, csv.find("\niteration,,5,"));
+  ASSERT_NE(std::string::npos, csv.find("\nphase,1,5,"));
+  ASSERT_NE(std::string::npos, csv.find("\nprepare,level2,5,"));
+  ASSERT_NE(std::string::npos,
+            csv.find("\nlink,level1.bottomUpOut-->level2.bottomUpIn,5,"));
+  ASSERT_NE(std::string::npos, csv.find("\ncompute,level1,5,"));
+  ASSERT_NE(std::string::npos, csv.find("\nshift,,5,"));
+
+  const std::string json = n.getProfilingReport("json");
+  ASSERT_NE(std::string::npos,
+            json.find("{\"stage\": \"compute\", \"name\": \"level2\", "
+                      "\"count\": 5, \"total_us\": "));
+  EXPECT_THROW(n.getProfilingReport("xml"), std::exception);
+
+  n.resetProfiling();
+  ASSERT_EQ("{\"stages\": []}", n.getProfilingReport());
+}
+
+TEST(NetworkTest, RunBatch) {
+  // A batch computes the same as setting the inputs and calling run(1) for
+  // every record.
+  Network n1;
+  Network n2;
+  for (Network *n : {&n1, &n2}) {
+    Dimensions d;
+    d.push_back(4);
+    d.push_back(4);
+    Region *l1 = n->addRegion("level1", "TestNode", "");
+    n->addRegion("level2", "TestNode", "");
+    l1->setDimensions(d);
+    n->link("level1", "level2", "TestFanIn2", "");
+  }
+
+  const std::vector<Real64> block = {0.5, 10, 1.5, 20, 2.5, 30};
+  Region *l1 = n1.getRegions().getByName("level1");
+  std::vector<std::vector<Real64>> expected;
+  for (size_t i = 0; i < 3; i++) {
+    l1->setParameterReal64("real64Param", block[2 * i]);
+    n1.run(1);
+    const ArrayRef output = n1.getRegions().getByName("level2")->getOutputData(
+        "bottomUpOut");
+    const Real64 *buffer = (const Real64 *)output.getBuffer();
+    expected.emplace_back(buffer, buffer + output.getCount());
+  }
+
+  BlockInputSource source(block.data(), 3, 2);
+  source.addParameter("level1", "real64Param", 0);
+  NetworkOutputSink sink;
+  const size_t out = sink.addOutput("level2", "bottomUpOut");
+  n2.runBatch(3, &source, &sink);
+
+  ASSERT_TRUE(n1 == n2);
+  ASSERT_EQ(2.5, n2.getRegions().getByName("level1")->getParameterReal64(
+                     "real64Param"));
+  ASSERT_EQ(3u, sink.getNumIterations());
+  ASSERT_EQ(NTA_BasicType_Real64, sink.getType(out));
+  ASSERT_EQ(expected[0].size(), sink.getWidth(out));
+  const Real64 *captured = (const Real64 *)sink.getBuffer(out);
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_EQ(expected[i].size(), sink.getCount(out, i));
+    ASSERT_EQ(expected[i],
+              std::vector<Real64>(captured + i * sink.getWidth(out),
+                                  captured + (i + 1) * sink.getWidth(out)));
+  }
+
+  std::vector<UInt64> iterations;
+  CallbackInputSource callbackSource(
+      [&iterations](Network &n, UInt64 iteration) {
+        iterations.push_back(iteration);
+      });
+  n2.runBatch(2, &callbackSource, nullptr);
+  ASSERT_EQ(std::vector<UInt64>({0, 1}), iterations);
+
+  // More iterations than rows
+  EXPECT_THROW(n2.runBatch(4, &source, nullptr), std::exception);
+
+  // A copy of a source that owns its block reads its own copy of it
+  std::unique_ptr<BlockInputSource> owner(
+      new BlockInputSource(std::vector<Real64>({3.5, 4.5}), 1));
+  owner->addParameter("level1", "real64Param", 0);
+  BlockInputSource copy(*owner);
+  owner.reset();
+  n2.runBatch(2, &copy, nullptr);
+  ASSERT_EQ(4.5, n2.getRegions().getByName("level1")->getParameterReal64(
+                     "real64Param"));
+
+  NetworkOutputSink badSink;
+  badSink.addOutput("level2", "noSuchOutput");
+  EXPECT_THROW(n2.runBatch(1, nullptr, &badSink), std::exception);
+}
+
+TEST(NetworkTest, RegionHandles) {
+  Network n;
+  Dimensions d;
+  d.push_back(4);
+  d.push_back(4);
+  Region *l1 = n.addRegion("level1", "TestNode", "");
+  l1->setDimensions(d);
+  n.initialize();
+
+  OutputHandle output = l1->resolveOutput("bottomUpOut");
+  ASSERT_TRUE(output.isValid());
+  n.run(1);
+  const ArrayRef expected = l1->getOutputData("bottomUpOut");
+  ASSERT_EQ(expected.getBuffer(), output.getData().getBuffer());
+  ASSERT_EQ(expected.getCount(), output.getDataRef().getCount());
+  EXPECT_THROW(l1->resolveOutput("noSuchOutput"), std::exception);
+}
+
+TEST(NetworkTest, Checkpoint) {
+  Network n;
+  Dimensions d;
+  d.push_back(4);
+  d.push_back(4);
+  Region *l1 = n.addRegion("level1", "TestNode", "");
+  n.addRegion("level2", "TestNode", "");
+  l1->setDimensions(d);
+  n.link("level1", "level2", "TestFanIn2", "");
+  n.run(2);
+
+  const std::string dir = "NetworkTest_Checkpoint";
+  Directory::create(dir);
+  const std::string path = Path::join(dir, "network.capnp");
+  l1->setParameterInt64("int64Param", 42);
+  std::shared_ptr<NetworkCheckpoint> first = n.checkpoint(path);
+
+  // Changes after checkpoint() returns are not in the snapshot
+  l1->setParameterInt64("int64Param", 43);
+  n.run(1);
+
+  ASSERT_EQ(NetworkCheckpoint::DONE, first->wait());
+  ASSERT_TRUE(first->isDone());
+  ASSERT_EQ(first->getBytesTotal(), first->getBytesWritten());
+  ASSERT_EQ(first->getBytesWritten(), (UInt64)Path::getFileSize(path));
+
+  // The temporary file was renamed to the checkpoint
+  Directory::Iterator it(dir);
+  Directory::Entry entry;
+  size_t numEntries = 0;
+  while (it.next(entry) != nullptr)
+    numEntries++;
+  ASSERT_EQ(1u, numEntries);
+
+  {
+    Network restored;
+    IFStream f(path.c_str(), std::ios::in | std::ios::binary);
+    restored.read(f);
+    ASSERT_EQ(42, restored.getRegions().getByName("level1")->getParameterInt64(
+                      "int64Param"));
+  }
+
+  // A second checkpoint replaces the first one
+  std::shared_ptr<NetworkCheckpoint> second = n.checkpoint(path);
+  ASSERT_EQ(NetworkCheckpoint::DONE, second->wait());
+  {
+    Network restored;
+    IFStream f(path.c_str(), std::ios::in | std::ios::binary);
+    restored.read(f);
+    ASSERT_EQ(43, restored.getRegions().getByName("level1")->getParameterInt64(
+                      "int64Param"));
+  }
+  Directory::removeTree(dir);
+
+  std::shared_ptr<NetworkCheckpoint> failed =
+      n.checkpoint(Path::join("no_such_directory", path));
+  ASSERT_EQ(NetworkCheckpoint::FAILED, failed->wait());
+  ASSERT_FALSE(failed->getError().empty());
+}
+
 /**
  * Test operator '=='
  */
@@ -375,4 +375,73 @@ TEST(TopologyTest, WrappingNeighborhoodDimensionOne) {
       /*radius*/ 1,
       /*expected*/ {{4, 0, 0}, {5, 0, 0}, {6, 0, 0}});
 }
+
+// ==========================================================================
+// NEIGHBORHOOD MEANS AND MAXIMA
+// ==========================================================================
+
+void expectNeighborhoodReductions(const vector<UInt> &dimensions,
+                                  UInt radius, bool wrapAround) {
+  UInt numPoints = 1;
+  for (UInt dimension : dimensions) {
+    numPoints *= dimension;
+  }
+
+  vector<Real> values(numPoints);
+  for (UInt i = 0; i < numPoints; i++) {
+    values[i] = (Real)((i * 7919) % 97) / 97;
+  }
+
+  vector<Real> means, maxima;
+  neighborhoodMeans(values, radius, dimensions, wrapAround, means);
+  neighborhoodMaxima(values, radius, dimensions, wrapAround, maxima);
+  ASSERT_EQ(numPoints, means.size());
+  ASSERT_EQ(numPoints, maxima.size());
+
+  for (UInt i = 0; i < numPoints; i++) {
+    Real64 sum = 0;
+    Real maximum = 0;
+    UInt count = 0;
+    auto visit = [&](UInt neighbor) {
+      sum += values[neighbor];
+      maximum = std::max(maximum, values[neighbor]);
+      count++;
+    };
+    if (wrapAround) {
+      for (UInt neighbor : WrappingNeighborhood(i, radius, dimensions)) {
+        visit(neighbor);
+      }
+    } else {
+      for (UInt neighbor : Neighborhood(i, radius, dimensions)) {
+        visit(neighbor);
+      }
+    }
+
+    EXPECT_NEAR(sum / count, means[i], 1e-5);
+    EXPECT_EQ(maximum, maxima[i]);
+  }
+}
+
+TEST(TopologyTest, NeighborhoodMeansAndMaxima1D) {
+  for (UInt radius : {0, 1, 3, 20, 200}) {
+    expectNeighborhoodReductions({50}, radius, false);
+    expectNeighborhoodReductions({50}, radius, true);
+  }
+}
+
+TEST(TopologyTest, NeighborhoodMeansAndMaxima2D) {
+  for (UInt radius : {0, 1, 2, 5, 30}) {
+    expectNeighborhoodReductions({13, 21}, radius, false);
+    expectNeighborhoodReductions({13, 21}, radius, true);
+  }
+}
+
+TEST(TopologyTest, NeighborhoodMeansAndMaxima3D) {
+  for (UInt radius : {0, 1, 3}) {
+    expectNeighborhoodReductions({5, 7, 1}, radius, false);
+    expectNeighborhoodReductions({5, 7, 1}, radius, true);
+    expectNeighborhoodReductions({4, 6, 9}, radius, false);
+    expectNeighborhoodReductions({4, 6, 9}, radius, true);
+  }
+}
 } // namespace
@@ -0,0 +1,152 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Unit tests for VectorKernels.hpp
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+#include <nupic/math/VectorKernels.hpp>
+
+using std::vector;
+using namespace nupic;
+using namespace nupic::math::kernels;
+
+namespace {
+
+// Lengths around the widths of the AVX registers, to cover the tails.
+const UInt LENGTHS[] = {0, 1, 3, 4, 5, 7, 8, 9, 16, 17, 31};
+
+template <typename T> vector<T> ramp(UInt n, T start, T step) {
+  vector<T> v(n);
+  for (UInt j = 0; j < n; ++j)
+    v[j] = start + step * (T)j;
+  return v;
+}
+
+TEST(VectorKernelsTest, CpuFeatures) {
+#ifndef NTA_AVX_DISPATCH
+  EXPECT_FALSE(cpuHasAvx());
+  EXPECT_FALSE(cpuHasAvx2());
+#endif
+  // AVX2 extends AVX
+  EXPECT_TRUE(cpuHasAvx() || !cpuHasAvx2());
+}
+
+TEST(VectorKernelsTest, AddTo) {
+  for (UInt n : LENGTHS) {
+    const vector<Real32> x32 = ramp<Real32>(n, 0.5f, 0.25f);
+    const vector<Real64> x64 = ramp<Real64>(n, 1.5, -0.5);
+
+    vector<Real32> y32 = ramp<Real32>(n, 2.0f, 1.0f);
+    addTo(y32.data(), x32.data(), n);
+    for (UInt j = 0; j < n; ++j)
+      ASSERT_FLOAT_EQ(2.0f + j + 0.5f + 0.25f * j, y32[j]);
+
+    vector<Real64> y64 = ramp<Real64>(n, 2.0, 1.0);
+    addTo(y64.data(), x64.data(), n);
+    for (UInt j = 0; j < n; ++j)
+      ASSERT_DOUBLE_EQ(2.0 + j + 1.5 - 0.5 * j, y64[j]);
+
+    y64 = ramp<Real64>(n, 2.0, 1.0);
+    addTo(y64.data(), x32.data(), n);
+    for (UInt j = 0; j < n; ++j)
+      ASSERT_DOUBLE_EQ(2.0 + j + 0.5 + 0.25 * j, y64[j]);
+  }
+}
+
+TEST(VectorKernelsTest, AddScaledToAndDivideBy) {
+  for (UInt n : LENGTHS) {
+    const vector<Real64> x = ramp<Real64>(n, 1.0, 0.5);
+
+    vector<Real64> y64(n, 1.0);
+    addScaledTo(y64.data(), 3.0, x.data(), n);
+    for (UInt j = 0; j < n; ++j)
+      ASSERT_DOUBLE_EQ(1.0 + 3.0 * (1.0 + 0.5 * j), y64[j]);
+
+    vector<Real32> y32(n, 1.0f);
+    addScaledTo(y32.data(), 3.0, x.data(), n);
+    for (UInt j = 0; j < n; ++j)
+      ASSERT_FLOAT_EQ((Real32)(1.0 + 3.0 * (1.0 + 0.5 * j)), y32[j]);
+
+    divideBy(y64.data(), n, 4.0);
+    for (UInt j = 0; j < n; ++j)
+      ASSERT_DOUBLE_EQ((1.0 + 3.0 * (1.0 + 0.5 * j)) / 4.0, y64[j]);
+  }
+}
+
+TEST(VectorKernelsTest, DotAndMaxProd) {
+  for (UInt n : LENGTHS) {
+    const vector<Real32> a32 = ramp<Real32>(n, 1.0f, 0.5f);
+    const vector<Real32> x32 = ramp<Real32>(n, 2.0f, -0.25f);
+    const vector<Real64> a64(a32.begin(), a32.end());
+    const vector<Real64> x64(x32.begin(), x32.end());
+
+    Real64 sum = 0, result = 0;
+    for (UInt j = 0; j < n; ++j) {
+      sum += a64[j] * x64[j];
+      result = std::max(result, a64[j] * x64[j]);
+    }
+
+    ASSERT_NEAR(sum, dot(a32.data(), x32.data(), n), 1e-4);
+    ASSERT_DOUBLE_EQ(sum, dot(a64.data(), x64.data(), n));
+    ASSERT_FLOAT_EQ((Real32)result, maxProd(a32.data(), x32.data(), n));
+    ASSERT_DOUBLE_EQ(result, maxProd(a64.data(), x64.data(), n));
+  }
+}
+
+TEST(VectorKernelsTest, DotSumsInLanes) {
+  // Products of very different magnitudes, which round differently in each
+  // order, still give the same sum with or without AVX.
+  for (UInt n : LENGTHS) {
+    vector<Real32> a32(n), x32(n, 1.0f);
+    for (UInt j = 0; j < n; ++j)
+      a32[j] = (j % 3 == 0) ? 1e8f : (j % 3 == 1) ? 1.0f : -1e8f;
+    const vector<Real64> a64(a32.begin(), a32.end());
+    const vector<Real64> x64(x32.begin(), x32.end());
+
+    Real32 lanes32[8] = {};
+    Real64 lanes64[4] = {};
+    for (UInt j = 0; j < n - n % 8; ++j)
+      lanes32[j % 8] += a32[j] * x32[j];
+    for (UInt j = 0; j < n - n % 4; ++j)
+      lanes64[j % 4] += a64[j] * x64[j];
+    Real32 sum32 = 0;
+    Real64 sum64 = 0;
+    for (UInt k = 0; k < 8; ++k)
+      sum32 += lanes32[k];
+    for (UInt k = 0; k < 4; ++k)
+      sum64 += lanes64[k];
+    for (UInt j = n - n % 8; j < n; ++j)
+      sum32 += a32[j] * x32[j];
+    for (UInt j = n - n % 4; j < n; ++j)
+      sum64 += a64[j] * x64[j];
+
+    ASSERT_EQ(sum32, dot(a32.data(), x32.data(), n));
+    ASSERT_EQ(sum64, dot(a64.data(), x64.data(), n));
+  }
+}
+
+} // namespace
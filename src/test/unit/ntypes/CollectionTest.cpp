@@ -193,3 +193,31 @@ TEST_F(CollectionTest, testCollectionAddRemove) {
   ASSERT_TRUE(c.getCount() == 0);
   ASSERT_TRUE(!c.contains("2"));
 }
+
+TEST_F(CollectionTest, testCollectionGetByNameAfterRemove) {
+  Collection<int> c;
+  for (int i = 0; i < 10; ++i) {
+    std::stringstream ss;
+    ss << i;
+    c.add(ss.str(), i);
+  }
+
+  c.remove("3");
+  c.remove("0");
+  c.add("3", 33);
+  // c is now 1, 2, 4, 5, 6, 7, 8, 9, 33
+  for (int i : {1, 2, 4, 5, 6, 7, 8, 9}) {
+    std::stringstream ss;
+    ss << i;
+    ASSERT_EQ(i, c.getByName(ss.str()));
+  }
+  ASSERT_EQ(33, c.getByName("3"));
+  ASSERT_EQ(33, c.getByIndex(8).second);
+  ASSERT_ANY_THROW(c.getByName("0"));
+
+  // Collections of different sizes are different
+  Collection<int> d;
+  d.add("1", 1);
+  ASSERT_TRUE(c != d);
+  ASSERT_TRUE(d != c);
+}
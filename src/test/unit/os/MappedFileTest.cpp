@@ -0,0 +1,64 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of MappedFile test
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <nupic/os/MappedFile.hpp>
+
+using namespace nupic;
+
+TEST(MappedFileTest, MapsTheContents) {
+  const char *filename = "MappedFileTest.tmp";
+  const std::string contents = "0123456789abcdef";
+  {
+    std::ofstream f(filename, std::ios::binary);
+    f << contents;
+  }
+
+  {
+    MappedFile file(filename);
+    ASSERT_EQ(contents.size(), file.getSize());
+    ASSERT_EQ(0, ::memcmp(contents.data(), file.getData(), contents.size()));
+  }
+
+  // Empty files map to nothing
+  {
+    std::ofstream f(filename, std::ios::binary | std::ios::trunc);
+  }
+  {
+    MappedFile file(filename);
+    ASSERT_EQ(0u, file.getSize());
+    ASSERT_EQ(nullptr, file.getData());
+  }
+
+  ASSERT_EQ(0, ::remove(filename));
+  EXPECT_THROW(MappedFile file(filename), std::exception);
+}
@@ -200,6 +200,18 @@ TEST_F(PathTest, remove) {}
 // test static rename()
 TEST_F(PathTest, rename) {}
 
+// test static sync()
+TEST_F(PathTest, sync) {
+  {
+    OFStream f("a.txt");
+    f << "12345";
+  }
+  Path::sync("a.txt");
+  Path::sync(Directory::getCWD());
+  Path::remove("a.txt");
+  EXPECT_THROW(Path::sync("a.txt"), exception);
+}
+
 // test static copy()
 TEST_F(PathTest, copy) {
   {
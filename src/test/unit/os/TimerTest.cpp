@@ -30,6 +30,7 @@
 #include <chrono> // std::chrono::seconds
 #include <gtest/gtest.h>
 #include <math.h> // fabs
+#include <nupic/os/CycleClock.hpp>
 #include <nupic/os/Timer.hpp>
 #include <nupic/utils/Log.hpp>
 
@@ -80,3 +81,15 @@ TEST(TimerTest, Drift) {
   }
   ASSERT_LT(t.getElapsed(), EPSILON);
 }
+
+TEST(TimerTest, CycleClock) {
+  const UInt64 start = CycleClock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const UInt64 end = CycleClock::now();
+  ASSERT_GT(end, start);
+
+  // Loose bounds, the machine may be busy
+  const Real64 seconds = (end - start) / CycleClock::ticksPerSecond();
+  ASSERT_GT(seconds, 0.015);
+  ASSERT_LT(seconds, 1.0);
+}
@@ -0,0 +1,102 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2018, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for LatencyHistogram
+ */
+
+#include <gtest/gtest.h>
+
+#include <nupic/types/Exception.hpp>
+#include <nupic/utils/LatencyHistogram.hpp>
+
+using namespace nupic;
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram h;
+  ASSERT_EQ(0, h.getCount());
+  ASSERT_EQ(0, h.getMin());
+  ASSERT_EQ(0, h.getMax());
+  ASSERT_EQ(0.0, h.getMean());
+  ASSERT_EQ(0, h.getPercentile(50));
+  ASSERT_THROW(h.getPercentile(101), std::exception);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram h;
+  for (UInt64 v = 1; v <= 20; v++) {
+    h.record(v);
+  }
+  ASSERT_EQ(20, h.getCount());
+  ASSERT_EQ(210, h.getTotal());
+  ASSERT_EQ(1, h.getMin());
+  ASSERT_EQ(20, h.getMax());
+  ASSERT_DOUBLE_EQ(10.5, h.getMean());
+  ASSERT_EQ(1, h.getPercentile(0));
+  ASSERT_EQ(10, h.getPercentile(50));
+  ASSERT_EQ(19, h.getPercentile(95));
+  ASSERT_EQ(20, h.getPercentile(100));
+}
+
+TEST(LatencyHistogramTest, RelativeError) {
+  LatencyHistogram h;
+  // 1000 fast iterations and 10 slow ones
+  for (UInt64 i = 0; i < 1000; i++) {
+    h.record(100000 + i * 37);
+  }
+  for (UInt64 i = 0; i < 10; i++) {
+    h.record(5000000000ULL + i);
+  }
+
+  const UInt64 p50 = h.getPercentile(50);
+  const UInt64 exactP50 = 100000 + 504 * 37;
+  ASSERT_GE(p50, exactP50);
+  ASSERT_LE(p50, exactP50 + exactP50 / LatencyHistogram::SUB_BUCKET_COUNT);
+
+  const UInt64 p99 = h.getPercentile(99);
+  ASSERT_GE(p99, 100000 + 999 * 37);
+  ASSERT_LT(p99, 5000000000ULL);
+
+  ASSERT_EQ(5000000009ULL, h.getPercentile(100));
+  ASSERT_EQ(100000, h.getPercentile(0));
+}
+
+TEST(LatencyHistogramTest, MergeAndReset) {
+  LatencyHistogram a, b;
+  for (UInt64 v = 0; v < 100; v++) {
+    a.record(v);
+    b.record(v + 1000);
+  }
+  a.merge(b);
+  ASSERT_EQ(200, a.getCount());
+  ASSERT_EQ(0, a.getMin());
+  ASSERT_EQ(1099, a.getMax());
+  ASSERT_LT(a.getPercentile(50), 100);
+  ASSERT_GE(a.getPercentile(51), 1000);
+
+  a.reset();
+  ASSERT_EQ(0, a.getCount());
+  ASSERT_EQ(0, a.getPercentile(50));
+  a.record(7);
+  ASSERT_EQ(7, a.getMin());
+  ASSERT_EQ(7, a.getPercentile(50));
+}